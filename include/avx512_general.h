@@ -0,0 +1,81 @@
+#ifndef _AVX512_GENERAL_H_
+#define _AVX512_GENERAL_H_
+
+#include <immintrin.h>
+#include <stdint.h>
+
+#define AVX512_REG_N_FLOATS     16
+#define AVX512_REG_N_WORDS      32
+
+/**
+ * Dumps a __m512 register to stderr
+ * @param x Register to dump
+ */
+#define avx512_dump_ps512(x)   do {                                                     \
+    float __avx512_dump_ps512_var_tmp[AVX512_REG_N_FLOATS] __attribute__((aligned (64))); \
+    _mm512_store_ps(&__avx512_dump_ps512_var_tmp[0], (x));                                \
+    fprintf(stderr, "MSB ");                                                              \
+    for (size_t i = 0; i < AVX512_REG_N_FLOATS; i++)                                      \
+    {                                                                                     \
+        fprintf(stderr, "%.2f", __avx512_dump_ps512_var_tmp[i]);                          \
+        if (i < AVX512_REG_N_FLOATS - 1)                                                  \
+        {                                                                                 \
+            fprintf(stderr, " | ");                                                       \
+        }                                                                                 \
+    }                                                                                     \
+    fprintf(stderr, " LSB\n");                                                            \
+} while (0)
+
+/**
+ * Dumps a __m512i register to stderr
+ * @param x Register to dump
+ */
+#define avx512_dump_si512(x)   do {                                                        \
+    uint32_t __avx512_dump_si512_var_tmp[AVX512_REG_N_FLOATS] __attribute__((aligned (64))); \
+    _mm512_store_si512((void *)&__avx512_dump_si512_var_tmp[0], (x));                        \
+    fprintf(stderr, "MSB ");                                                                 \
+    for (size_t i = 0; i < AVX512_REG_N_FLOATS; i++)                                         \
+    {                                                                                        \
+        fprintf(stderr, "%d", __avx512_dump_si512_var_tmp[i]);                               \
+        if (i < AVX512_REG_N_FLOATS - 1)                                                     \
+        {                                                                                    \
+            fprintf(stderr, " | ");                                                          \
+        }                                                                                    \
+    }                                                                                        \
+    fprintf(stderr, " LSB\n");                                                               \
+} while (0)
+
+/**
+ * Creates a mask of the lanes that remain to be processed
+ * @param n Number of remaining elements
+ * @return Mask of min(n, 16) lowest lanes
+ */
+static inline __mmask16 avx512_tail_mask16(size_t n)
+{
+    return (n >= 16) ? (__mmask16)0xFFFF : (__mmask16)((1u << n) - 1);
+}
+
+/**
+ * Creates a mask of the lanes that remain to be processed
+ * @param n Number of remaining elements
+ * @return Mask of min(n, 32) lowest lanes
+ */
+static inline __mmask32 avx512_tail_mask32(size_t n)
+{
+    return (n >= 32) ? (__mmask32)0xFFFFFFFF : (__mmask32)((1u << n) - 1);
+}
+
+/**
+ * Reads channel value pairs (channel[c], channel[c + 1]) at given columns of a row
+ * Bounds are not checked, the dword read may reach 2 bytes past channel[c + 1]
+ * @param row Pointer to channel row
+ * @param mask Lanes to read, the others are zeroed
+ * @param cVec Column vector (indexed from 0), __m512i
+ * @return Vector of dwords, channel[c] in the lowest byte, channel[c + 1] in the second one
+ */
+static inline __m512i avx512ImgReadChannelPairVec(const uint8_t *row, __mmask16 mask, __m512i cVec)
+{
+    return _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), mask, cVec, (const void *)row, 1);
+}
+
+#endif
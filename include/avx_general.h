@@ -59,17 +59,17 @@ static inline __m256 avx_mm256_not_ps(const __m256 v)
 /**
  * Read channel value at given possition. Bounds are not checked
  * @param channel Pointer to channel array
- * @param width Image width
+ * @param stride Image row stride
  * @param r Row (indexed from 0)
  * @param cVec Column vector (indexed from 0), __m256i
  * @param cVecOffset Column vector offset, e.g cVec = [1,2,3, ...] cVecOffset = 3 --> [4,5,6, ...]
  * @param resVec Float array of at least AVX_REG_N_FLOATS size aligned to 32b to store the result to
  */
-#define avxImgReadChannelVec(channel, width, r, cVec, cVecOffset, resVec)                   \
+#define avxImgReadChannelVec(channel, stride, r, cVec, cVecOffset, resVec)                  \
 do {                                                                                        \
     uint32_t __avxImgReadChannelVarTmp[AVX_REG_N_FLOATS] __attribute__((aligned (32)));     \
     _mm256_store_si256((__m256i *)__avxImgReadChannelVarTmp, (cVec));                       \
-    size_t __avxImgReadChannelVarTmpOffset = (r) * (width) + (cVecOffset);                  \
+    size_t __avxImgReadChannelVarTmpOffset = (r) * (stride) + (cVecOffset);                 \
     resVec[0] = (channel)[__avxImgReadChannelVarTmpOffset + __avxImgReadChannelVarTmp[0]];  \
     resVec[1] = (channel)[__avxImgReadChannelVarTmpOffset + __avxImgReadChannelVarTmp[1]];  \
     resVec[2] = (channel)[__avxImgReadChannelVarTmpOffset + __avxImgReadChannelVarTmp[2]];  \
@@ -83,24 +83,24 @@ do {
 /**
  * Write channel value at given possition. Bounds are not checked
  * @param channel Pointer to channel array
- * @param width Image width
+ * @param stride Image row stride
  * @param r Row (indexed from 0)
  * @param c Column (indexed from 0)
- * @param valVec Vector of values to write, __m256
+ * @param valVec Vector of values to write, __m256, lowest lane is written to column c
  */
-#define avxImgWriteChannelVec(channel, width, r, c, valVec)                                                 \
+#define avxImgWriteChannelVec(channel, stride, r, c, valVec)                                                \
 do {                                                                                                        \
     uint32_t __avxImgWriteChannelVecTmp[AVX_REG_N_FLOATS] __attribute__((aligned (32)));                    \
     _mm256_store_si256((__m256i *)__avxImgWriteChannelVecTmp, _mm256_cvttps_epi32(valVec));                 \
-    size_t __avxImgWriteChannelVecTmpOffset = (r) * (width) + (c);                                          \
-    ((uint8_t *)(channel))[__avxImgWriteChannelVecTmpOffset + 0] = (uint8_t)__avxImgWriteChannelVecTmp[7];  \
-    ((uint8_t *)(channel))[__avxImgWriteChannelVecTmpOffset + 1] = (uint8_t)__avxImgWriteChannelVecTmp[6];  \
-    ((uint8_t *)(channel))[__avxImgWriteChannelVecTmpOffset + 2] = (uint8_t)__avxImgWriteChannelVecTmp[5];  \
-    ((uint8_t *)(channel))[__avxImgWriteChannelVecTmpOffset + 3] = (uint8_t)__avxImgWriteChannelVecTmp[4];  \
-    ((uint8_t *)(channel))[__avxImgWriteChannelVecTmpOffset + 4] = (uint8_t)__avxImgWriteChannelVecTmp[3];  \
-    ((uint8_t *)(channel))[__avxImgWriteChannelVecTmpOffset + 5] = (uint8_t)__avxImgWriteChannelVecTmp[2];  \
-    ((uint8_t *)(channel))[__avxImgWriteChannelVecTmpOffset + 6] = (uint8_t)__avxImgWriteChannelVecTmp[1];  \
-    ((uint8_t *)(channel))[__avxImgWriteChannelVecTmpOffset + 7] = (uint8_t)__avxImgWriteChannelVecTmp[0];  \
+    size_t __avxImgWriteChannelVecTmpOffset = (r) * (stride) + (c);                                         \
+    ((uint8_t *)(channel))[__avxImgWriteChannelVecTmpOffset + 0] = (uint8_t)__avxImgWriteChannelVecTmp[0];  \
+    ((uint8_t *)(channel))[__avxImgWriteChannelVecTmpOffset + 1] = (uint8_t)__avxImgWriteChannelVecTmp[1];  \
+    ((uint8_t *)(channel))[__avxImgWriteChannelVecTmpOffset + 2] = (uint8_t)__avxImgWriteChannelVecTmp[2];  \
+    ((uint8_t *)(channel))[__avxImgWriteChannelVecTmpOffset + 3] = (uint8_t)__avxImgWriteChannelVecTmp[3];  \
+    ((uint8_t *)(channel))[__avxImgWriteChannelVecTmpOffset + 4] = (uint8_t)__avxImgWriteChannelVecTmp[4];  \
+    ((uint8_t *)(channel))[__avxImgWriteChannelVecTmpOffset + 5] = (uint8_t)__avxImgWriteChannelVecTmp[5];  \
+    ((uint8_t *)(channel))[__avxImgWriteChannelVecTmpOffset + 6] = (uint8_t)__avxImgWriteChannelVecTmp[6];  \
+    ((uint8_t *)(channel))[__avxImgWriteChannelVecTmpOffset + 7] = (uint8_t)__avxImgWriteChannelVecTmp[7];  \
 } while (0)
 
 
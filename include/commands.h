@@ -0,0 +1,25 @@
+#ifndef _COMMANDS_H_
+#define _COMMANDS_H_
+
+/**
+ * Computes average hashes of many images on worker threads
+ * ./image-info hash [-j threads] [-d directory]... [-] [image]...
+ * Prints "path<TAB>hash" lines in the order the images finish
+ * @param argc Number of arguments, argv[0] is the subcommand name
+ * @param argv Arguments
+ * @return Exit code
+ */
+int cmdHash(int argc, char *argv[]);
+
+/**
+ * Resizes many bitmaps in a pipeline of loader, resize and writer threads
+ * ./image-info resize [-s WIDTHxHEIGHT] [-j workers] [-l loaders] [-w writers] [-q depth] [-m manifest]... [-]
+ *                     [src dst]...
+ * Prints throughput of the stages and depths of the queues between them at the end
+ * @param argc Number of arguments, argv[0] is the subcommand name
+ * @param argv Arguments
+ * @return Exit code
+ */
+int cmdResize(int argc, char *argv[]);
+
+#endif // guardian
@@ -0,0 +1,40 @@
+#ifndef _CPU_DISPATCH_H_
+#define _CPU_DISPATCH_H_
+
+#include <stdbool.h>
+
+/* Environment variable forcing a SIMD level, e.g. IMG_KERNEL=avx2 */
+#define CPU_DISPATCH_ENV        "IMG_KERNEL"
+
+/* SIMD levels, every level implies all of the previous ones */
+typedef enum
+{
+    SIMD_LEVEL_SCALAR = 0,
+    SIMD_LEVEL_SSE2,
+    SIMD_LEVEL_AVX,
+    SIMD_LEVEL_AVX2,
+    SIMD_LEVEL_AVX512,                  ///< AVX512F and AVX512BW
+    SIMD_LEVEL_COUNT
+} simd_level_t;
+
+/**
+ * Detects the highest SIMD level supported by both the CPU and the OS
+ * @return Supported SIMD level
+ */
+simd_level_t cpuDetectSimdLevel(void);
+
+/**
+ * SIMD level kernels should be chosen for
+ * Detected once on first call from any thread, CPU_DISPATCH_ENV may lower it
+ * @return SIMD level
+ */
+simd_level_t cpuSimdLevel(void);
+
+/**
+ * Name of a SIMD level
+ * @param level SIMD level
+ * @return Name as accepted by CPU_DISPATCH_ENV
+ */
+const char *cpuSimdLevelName(simd_level_t level);
+
+#endif // guardian
@@ -0,0 +1,98 @@
+#ifndef _HASH_INDEX_H_
+#define _HASH_INDEX_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+** Multi-index hashing over 64 bit average hashes
+**
+** Every hash is split to HASH_INDEX_N_CHUNKS 16 bit substrings and each substring indexes its own
+** bucket table. Hashes within distance k of a query agree with it in at least one substring up to
+** floor(k / HASH_INDEX_N_CHUNKS) bits, so only buckets near the query substrings are verified.
+*/
+
+#define HASH_INDEX_N_CHUNKS         4
+#define HASH_INDEX_CHUNK_BITS       16
+#define HASH_INDEX_N_BUCKETS        (1 << HASH_INDEX_CHUNK_BITS)
+
+#define HASH_INDEX_MAGIC            0x58494841      // "AHIX"
+#define HASH_INDEX_VERSION          1
+
+/* Hamming-space index, ids are assigned in insertion order from 0 */
+typedef struct
+{
+    uint64_t *hashes;                               ///< hash of every id
+    size_t nHashes;                                 ///< number of hashes
+    size_t capacity;                                ///< allocated hashes
+    size_t nIndexed;                                ///< ids below are in buckets, the rest is scanned
+    uint32_t *bucketStarts[HASH_INDEX_N_CHUNKS];    ///< first bucketIds entry of every bucket
+    uint32_t *bucketIds[HASH_INDEX_N_CHUNKS];       ///< ids ordered by substring value
+} hash_index_t;
+
+/**
+ * Creates an empty index
+ * @return New index or NULL on error
+ */
+hash_index_t *hashIndexCreate(void);
+
+/**
+ * Creates an index of given hashes, ids are positions in the array
+ * @param hashes Hashes to index
+ * @param n Number of hashes
+ * @return New index or NULL on error
+ */
+hash_index_t *hashIndexBuild(const uint64_t *hashes, size_t n);
+
+/**
+ * Deallocates all resources of an index
+ * @param index Index to destroy
+ */
+void hashIndexDestroy(hash_index_t *index);
+
+/**
+ * Adds a hash to the index
+ * Recent hashes are scanned linearly, a bounded number of them is merged into the buckets at once
+ * @param index Index
+ * @param hash Hash to add
+ * @param id Variable to store the id of the hash to, may be NULL
+ * @return Success flag
+ */
+bool hashIndexInsert(hash_index_t *index, uint64_t hash, uint32_t *id);
+
+/**
+ * Rebuilds buckets so that they cover all hashes
+ * @param index Index
+ * @return Success flag
+ */
+bool hashIndexRebuild(hash_index_t *index);
+
+/**
+ * Finds hashes within given Hamming distance
+ * @param index Index
+ * @param hash Query hash
+ * @param radius Maximal Hamming distance
+ * @param ids Array to store ids of found hashes to, may be NULL
+ * @param maxIds Capacity of ids
+ * @return Number of found hashes, only the first maxIds are stored
+ */
+size_t hashIndexQuery(const hash_index_t *index, uint64_t hash, size_t radius, uint32_t *ids,
+                      size_t maxIds);
+
+/**
+ * Saves indexed hashes to a file, buckets are rebuilt on load
+ * @param index Index to save
+ * @param file Name of file to save the index to
+ * @return Success flag
+ */
+bool hashIndexSave(const hash_index_t *index, const char *file);
+
+/**
+ * Loads an index saved by hashIndexSave
+ * @param file Name of file to load the index from
+ * @return New index or NULL on error
+ */
+hash_index_t *hashIndexLoad(const char *file);
+
+#endif // guardian
@@ -13,6 +13,15 @@
 
 #define BW_TRASHHOLD        127
 
+/* bytes allocated past the last channel so that vector kernels may over-read it */
+#define IMG_CHANNEL_SLACK   64
+
+/* alignment of channels and of their row strides, the widest vector register */
+#define IMG_ALIGN           64
+
+/* Row stride of a channel, vector loops may over-read and over-write the padding */
+#define IMG_ROW_STRIDE(width)   (((width) + IMG_ALIGN - 1) & ~(size_t)(IMG_ALIGN - 1))
+
 #define AVG_HASH_IMG_DIM    8
 #define AVG_HASH_SIMILARITY_TRASHHOLD   3
 
@@ -22,11 +31,54 @@ typedef struct
 {
     size_t width;
     size_t height;
-    uint8_t *rChannel;
+    size_t stride;                      ///< bytes between starts of rows, IMG_ROW_STRIDE(width)
+    uint8_t *rChannel;                  ///< aligned to IMG_ALIGN as are the other channels
     uint8_t *gChannel;
     uint8_t *bChannel;
+    struct img_pool *pool;              ///< pool imgDestroy returns the image to, NULL if not pooled
 } image_t;
 
+/* Packed image, the channels of every pixel are adjacent (RGB, BGR, RGBA, ...) */
+typedef struct
+{
+    size_t width;
+    size_t height;
+    size_t nChannels;                   ///< channels per pixel, 3 or 4
+    size_t stride;                      ///< bytes between starts of rows
+    uint8_t *pixels;
+    bool ownsPixels;                    ///< pixels are freed by packedImgDestroy
+} packed_image_t;
+
+/* Convolution filters of imgResizeFilter */
+typedef enum
+{
+    IMG_FILTER_BICUBIC,                 ///< Keys cubic, a = -0.5
+    IMG_FILTER_LANCZOS3,                ///< Lanczos windowed sinc, 3 lobes
+} img_filter_t;
+
+/* Precomputed interpolation tables of a single resize geometry */
+typedef struct
+{
+    size_t width;                       ///< source width
+    size_t height;                      ///< source height
+    size_t newWidth;                    ///< destination width
+    size_t newHeight;                   ///< destination height
+
+    /* bilinear interpolation */
+    uint32_t *cTable;                   ///< source column of every new column
+    float *deltaCTable;                 ///< horizontal delta of every new column
+    uint8_t *cShuffleTable;             ///< byte shuffles of every block of new columns, see image_resize.h
+    uint32_t *rTable;                   ///< source row of every new row
+    float *deltaRTable;                 ///< vertical delta of every new row
+
+    /* fixed-point bilinear interpolation */
+    int32_t *cFixedTable;               ///< source column of every new column
+    uint16_t *wFixedTable;              ///< (128 - fx, fx) byte pair of every new column
+    uint32_t *r0FixedTable;             ///< upper source row of every new row
+    uint32_t *r1FixedTable;             ///< lower source row of every new row
+    uint8_t *fyFixedTable;              ///< vertical fraction of every new row
+} img_resize_plan_t;
+
 /* BMP header */
 struct bmp_hdr
 {
@@ -73,31 +125,50 @@ image_t *imgLoadBitmap(const char *bmpFile);
  */
 bool imgSaveBitmap(const image_t *img, const char *bmpFile);
 
+/**
+ * Size of image saved as a bitmap
+ * @param img Image
+ * @return Size in bytes including headers, 0 for NULL image
+ */
+size_t imgBitmapSize(const image_t *img);
+
+/**
+ * Save image as a bitmap to memory
+ * @param img Image to save
+ * @param buffer Buffer to store the bitmap to
+ * @param bufferSize Size of buffer, at least imgBitmapSize(img)
+ * @param written Variable to store the number of written bytes to, may be NULL
+ * @return Success flag
+ */
+bool imgSaveBitmapToMemory(const image_t *img, uint8_t *buffer, size_t bufferSize, size_t *written);
+
 /**
  * Read channel value at given possition. Bounds are not checked
  * @param channel Pointer to channel array
- * @param width Image width
+ * @param stride Image row stride
  * @param r Row (indexed from 0)
  * @param c Column (indexed from 0)
  * @return Channel value
  */
-#define imgReadChannel(channel, width, r, c)        \
-    channel[(r) * (width) + (c)]
+#define imgReadChannel(channel, stride, r, c)       \
+    channel[(r) * (stride) + (c)]
 
 /**
  * Write channel value at given possition. Bounds are not checked
  * @param channel Pointer to channel array
- * @param width Image width
+ * @param stride Image row stride
  * @param r Row (indexed from 0)
  * @param c Column (indexed from 0)
  * @param v Value to write
  * @return Written value
  */
-#define imgWriteChannel(channel, width, r, c, v)    \
-    (channel)[(r) * (width) + (c)] = (v)
+#define imgWriteChannel(channel, stride, r, c, v)   \
+    (channel)[(r) * (stride) + (c)] = (v)
 
 /**
  * Resize image with bilinear interpolation, create a NEW image
+ * Halving, quartering, doubling and quadrupling both dimensions run dedicated kernels without
+ * index math, their results are identical to the general path.
  * @param img Image to resize
  * @param newWidth Width of resized image
  * @param newHeight Height of resized image
@@ -105,20 +176,189 @@ bool imgSaveBitmap(const image_t *img, const char *bmpFile);
  */
 image_t *imgResize(const image_t *img, size_t newWidth, size_t newHeight);
 
+/**
+ * Resize image with fixed-point bilinear interpolation, create a NEW image
+ * Unlike imgResize the result is rounded to nearest and is identical for all kernels
+ * @param img Image to resize (at least 2x2)
+ * @param newWidth Width of resized image
+ * @param newHeight Height of resized image
+ * @return New image or NULL on error
+ */
+image_t *imgResizeFixed(const image_t *img, size_t newWidth, size_t newHeight);
+
+/**
+ * Downscale image by area averaging, create a NEW image
+ * Every new pixel is the mean of the source pixels it covers, partially covered ones are weighted
+ * by their coverage. Every source pixel is read once, rows covered by two new rows are accumulated
+ * into both in one read. Unlike bilinear downscales do not alias.
+ * @param img Image to resize
+ * @param newWidth Width of resized image, at most the source width
+ * @param newHeight Height of resized image, at most the source height
+ * @return New image or NULL on error
+ */
+image_t *imgResizeArea(const image_t *img, size_t newWidth, size_t newHeight);
+
+/**
+ * Resize image by separable convolution with a filter, create a NEW image
+ * Weights are computed once per call, downscales widen the filter so that every source pixel
+ * contributes. Arithmetic is fixed-point and results are identical for all kernels.
+ * @param img Image to resize
+ * @param newWidth Width of resized image
+ * @param newHeight Height of resized image
+ * @param filter Filter
+ * @return New image or NULL on error
+ */
+image_t *imgResizeFilter(const image_t *img, size_t newWidth, size_t newHeight, img_filter_t filter);
+
+/**
+ * Resize image to several sizes with bilinear interpolation, create NEW images
+ * Every source row is read once for all sizes, each new image is identical to imgResize to its size.
+ * @param img Image to resize
+ * @param sizes Width and height of every new image
+ * @param nSizes Number of sizes
+ * @param newImgs Array of nSizes to store new images to, nothing is stored on error
+ * @return Success flag
+ */
+bool imgResizePyramid(const image_t *img, const size_t sizes[][2], size_t nSizes, image_t **newImgs);
+
+/**
+ * Precomputes interpolation tables for resizing images of given geometry
+ * The plan can be reused for any number of images of the same dimensions
+ * @param width Source image width (at least 2)
+ * @param height Source image height (at least 2)
+ * @param newWidth Width of resized images
+ * @param newHeight Height of resized images
+ * @return New plan or NULL on error
+ */
+img_resize_plan_t *imgResizePlanCreate(size_t width, size_t height, size_t newWidth, size_t newHeight);
+
+/**
+ * Deallocates all resources of a resize plan
+ * @param plan Plan to destroy
+ */
+void imgResizePlanDestroy(img_resize_plan_t *plan);
+
+/**
+ * Resize image with bilinear interpolation according to a plan
+ * @param plan Plan created for dimensions of img and newImg
+ * @param img Image to resize
+ * @param newImg Image to store the result to
+ * @return Success flag
+ */
+bool imgResizeWithPlan(const img_resize_plan_t *plan, const image_t *img, image_t *newImg);
+
+/**
+ * Resize image with fixed-point bilinear interpolation according to a plan
+ * @param plan Plan created for dimensions of img and newImg
+ * @param img Image to resize
+ * @param newImg Image to store the result to
+ * @return Success flag
+ */
+bool imgResizeFixedWithPlan(const img_resize_plan_t *plan, const image_t *img, image_t *newImg);
+
+/**
+ * Sets the number of worker threads used by parallel resizing
+ * The workers are persistent, they are started once and reused by every call.
+ * Resizes already running finish on the previous workers, which stop after the last of them.
+ * @param nThreads Number of workers, 0 for the number of online CPUs
+ * @return Success flag
+ */
+bool imgResizeSetThreads(size_t nThreads);
+
+/**
+ * Resize image with bilinear interpolation on all worker threads, create a NEW image
+ * The result is identical to imgResize
+ * @param img Image to resize
+ * @param newWidth Width of resized image
+ * @param newHeight Height of resized image
+ * @return New image or NULL on error
+ */
+image_t *imgResizeParallel(const image_t *img, size_t newWidth, size_t newHeight);
+
+/**
+ * Resize image with bilinear interpolation according to a plan on all worker threads
+ * The result is identical to imgResizeWithPlan
+ * @param plan Plan created for dimensions of img and newImg
+ * @param img Image to resize
+ * @param newImg Image to store the result to
+ * @return Success flag
+ */
+bool imgResizeParallelWithPlan(const img_resize_plan_t *plan, const image_t *img, image_t *newImg);
+
+/**
+ * Resize image with fixed-point bilinear interpolation according to a plan on all worker threads
+ * The result is identical to imgResizeFixedWithPlan
+ * @param plan Plan created for dimensions of img and newImg
+ * @param img Image to resize
+ * @param newImg Image to store the result to
+ * @return Success flag
+ */
+bool imgResizeFixedParallelWithPlan(const img_resize_plan_t *plan, const image_t *img, image_t *newImg);
+
+/**
+ * Resize packed image with bilinear interpolation, create a NEW image
+ * Every channel is interpolated on its own, alpha is not premultiplied.
+ * Channel values are identical to imgResize of the same image in planar layout.
+ * @param img Image to resize
+ * @param newWidth Width of resized image
+ * @param newHeight Height of resized image
+ * @return New image or NULL on error
+ */
+packed_image_t *imgResizePacked(const packed_image_t *img, size_t newWidth, size_t newHeight);
+
+/**
+ * Resize packed image with bilinear interpolation according to a plan
+ * @param plan Plan created for dimensions of img and newImg
+ * @param img Image to resize
+ * @param newImg Image with the same number of channels to store the result to
+ * @return Success flag
+ */
+bool imgResizePackedWithPlan(const img_resize_plan_t *plan, const packed_image_t *img,
+                             packed_image_t *newImg);
+
+/**
+ * Resize a bitmap file with bilinear interpolation without loading it to memory
+ * Source rows are streamed in file order, memory use depends on widths only.
+ * The result is identical to saving imgResize of the loaded image.
+ * On error no destination file is left behind.
+ * @param srcFile Name of bitmap to resize
+ * @param dstFile Name of file to save the resized bitmap to, must not be the source file
+ * @param newWidth Width of resized image
+ * @param newHeight Height of resized image
+ * @return Success flag
+ */
+bool imgResizeBitmapFile(const char *srcFile, const char *dstFile, size_t newWidth, size_t newHeight);
+
 /**
  * Convert image to greyscale
+ * Luma is BT.709 in fixed point, see image_color.h
  * @param img Image to convert
  * @return Success flag
  */
 bool imgToGrayscale(image_t *img);
 
+/**
+ * Computes luma of image to its red channel only, green and blue channels are left unchanged
+ * @param img Image to convert
+ * @return Success flag
+ */
+bool imgToGrayscalePlane(image_t *img);
+
 /**
  * Converts image to black and white
+ * Luma and threshold are computed in a single pass
  * @param img Image to convert
  * @return Success flag
  */
 bool imgToBW(image_t *img);
 
+/**
+ * Converts image to black and white in its red channel only, green and blue channels are left unchanged
+ * @param img Image to convert
+ * @return Success flag
+ */
+bool imgToBWPlane(image_t *img);
+
 /**
  * Computes average hash of image
  * @param img Image to compute the avg hash for
@@ -127,8 +367,20 @@ bool imgToBW(image_t *img);
  */
 bool imgAvgHash(const image_t *img, uint64_t *res);
 
+/**
+ * Computes average hash of image in a single pass over the source channels
+ * Every bit is the thresholded mean luma of one cell of an 8x8 grid, bit r * 8 + c for cell (r, c).
+ * No intermediate image is created, so hashes differ from imgAvgHash.
+ * @param img Image to compute the avg hash for
+ * @param res Variable to store the hash to.
+ * @return Success flag
+ */
+bool imgAvgHashFused(const image_t *img, uint64_t *res);
+
 /**
  * Allocates necessary resources for image
+ * Channels are aligned to IMG_ALIGN and their rows are padded to IMG_ROW_STRIDE(width).
+ * The image is taken from the default pool if there is one, see imgPoolSetDefault.
  * @param width Image width
  * @param height Image height
  * @return New image or NULL on error
@@ -141,6 +393,33 @@ image_t *imgCreate(size_t width, size_t height);
  */
 void imgDestroy(image_t *img);
 
+/**
+ * Allocates a packed image with rows of width * nChannels bytes
+ * @param width Image width
+ * @param height Image height
+ * @param nChannels Channels per pixel, 3 or 4
+ * @return New image or NULL on error
+ */
+packed_image_t *packedImgCreate(size_t width, size_t height, size_t nChannels);
+
+/**
+ * Describes pixels owned by the caller as a packed image, nothing is copied
+ * @param pixels First pixel of the first row
+ * @param width Image width
+ * @param height Image height
+ * @param nChannels Channels per pixel, 3 or 4
+ * @param stride Bytes between starts of rows, at least width * nChannels
+ * @return New image or NULL on error
+ */
+packed_image_t *packedImgWrap(uint8_t *pixels, size_t width, size_t height, size_t nChannels,
+                              size_t stride);
+
+/**
+ * Deallocates a packed image, wrapped pixels are left to their owner
+ * @param img Image to destroy
+ */
+void packedImgDestroy(packed_image_t *img);
+
 /**
  * Dumps image
  * @param img Image to dump
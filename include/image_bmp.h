@@ -0,0 +1,85 @@
+#ifndef _IMAGE_BMP_H_
+#define _IMAGE_BMP_H_
+
+#include "image.h"
+#include "cpu_dispatch.h"
+
+/*
+** 24bpp BMP pixel conversion
+**
+** Bitmap rows are interleaved B, G, R triplets padded to 4 bytes, images are planar. Rows are
+** converted in both directions by per-kernel primitives implemented in their own translation
+** units, see image_resize.h. Padding is handled by the callers once per row.
+*/
+
+/* Bytes of BMP and DIB headers preceding pixels of saved bitmaps */
+#define BMP_HEADERS_SIZE        (sizeof(bmp_hdr_t) + sizeof(dib_hdr_t))
+
+/* Bytes of rows interleaved before every write of imgSaveBitmap */
+#define BMP_WRITE_BUFFER_SIZE   (1 << 20)
+
+/* Bytes of a padded 24bpp bitmap row */
+#define BMP_ROW_STRIDE(width)   (((width) * 3 + 3) & ~(size_t)3)
+
+/**
+ * Splits a row of BGR triplets to planar channels
+ * @param bgr Source row of width triplets
+ * @param rRow Red channel row to store the result to
+ * @param gRow Green channel row to store the result to
+ * @param bRow Blue channel row to store the result to
+ * @param width Number of pixels
+ */
+typedef void (*bmp_deinterleave_fn_t)(const uint8_t *bgr, uint8_t *rRow, uint8_t *gRow, uint8_t *bRow,
+                                      size_t width);
+
+void bmpDeinterleaveScalar(const uint8_t *bgr, uint8_t *rRow, uint8_t *gRow, uint8_t *bRow,
+                           size_t width);                                       // image.c
+void bmpDeinterleaveAvx(const uint8_t *bgr, uint8_t *rRow, uint8_t *gRow, uint8_t *bRow,
+                        size_t width);                                          // image_bmp_avx.c
+
+/**
+ * Merges planar channel rows to a row of BGR triplets
+ * @param rRow Red channel row
+ * @param gRow Green channel row
+ * @param bRow Blue channel row
+ * @param bgr Row of width triplets to store the result to
+ * @param width Number of pixels
+ */
+typedef void (*bmp_interleave_fn_t)(const uint8_t *rRow, const uint8_t *gRow, const uint8_t *bRow,
+                                    uint8_t *bgr, size_t width);
+
+void bmpInterleaveScalar(const uint8_t *rRow, const uint8_t *gRow, const uint8_t *bRow, uint8_t *bgr,
+                         size_t width);                                         // image.c
+void bmpInterleaveAvx(const uint8_t *rRow, const uint8_t *gRow, const uint8_t *bRow, uint8_t *bgr,
+                      size_t width);                                            // image_bmp_avx.c
+
+/**
+ * Chooses the best row splitter for the CPU, see cpuSimdLevel()
+ * @return Row splitter
+ */
+bmp_deinterleave_fn_t bmpDeinterleaveKernel(void);
+
+/**
+ * Chooses the best row merger for the CPU, see cpuSimdLevel()
+ * @return Row merger
+ */
+bmp_interleave_fn_t bmpInterleaveKernel(void);
+
+/**
+ * Parses and validates headers of a 24bpp uncompressed bitmap
+ * @param hdr First BMP_HEADERS_SIZE bytes of the file
+ * @param bmpHdr Variable to store the BMP header to
+ * @param dibHdr Variable to store the DIB header to
+ * @return Success flag
+ */
+bool bmpParseHeaders(const uint8_t hdr[BMP_HEADERS_SIZE], bmp_hdr_t *bmpHdr, dib_hdr_t *dibHdr);
+
+/**
+ * Serializes headers of a 24bpp bitmap with pixels right after them
+ * @param width Image width
+ * @param height Image height
+ * @param hdr Buffer to store the headers to
+ */
+void bmpWriteHeaders(size_t width, size_t height, uint8_t hdr[BMP_HEADERS_SIZE]);
+
+#endif // guardian
@@ -0,0 +1,65 @@
+#ifndef _IMAGE_COLOR_H_
+#define _IMAGE_COLOR_H_
+
+#include "image.h"
+#include "cpu_dispatch.h"
+
+/*
+** Grayscale and black and white conversion
+**
+** Luma is BT.709 in fixed point, luma = (R * r + G * g + B * b) >> IMG_LUMA_BITS. Weights sum to
+** exactly 1 << IMG_LUMA_BITS, so gray pixels keep their value and converting twice changes nothing.
+** Every weight fits a signed word, vector kernels multiply (r, g) and (b, 0) pairs with madd and give
+** the same results as the scalar reference.
+*/
+
+#define IMG_LUMA_BITS       15
+#define IMG_LUMA_R          6966
+#define IMG_LUMA_G          23436
+#define IMG_LUMA_B          2366
+
+/* Row converters of a kernel, rows are converted in place */
+typedef struct
+{
+    /**
+     * Replaces pixels of a row by their luma
+     * Rows are padded to the image stride, kernels may process the padding.
+     * @param rRow Red channel row, receives the luma
+     * @param gRow Green channel row
+     * @param bRow Blue channel row
+     * @param width Number of pixels
+     * @param triplicate Whether to store the luma to gRow and bRow as well
+     */
+    void (*luma)(uint8_t *rRow, uint8_t *gRow, uint8_t *bRow, size_t width, bool triplicate);
+
+    /**
+     * Replaces pixels of a row by 0xFF if their luma is above BW_TRASHHOLD and by 0 otherwise
+     * Same parameters as luma
+     */
+    void (*bw)(uint8_t *rRow, uint8_t *gRow, uint8_t *bRow, size_t width, bool triplicate);
+} img_color_kernel_t;
+
+void imgLumaRowScalar(uint8_t *rRow, uint8_t *gRow, uint8_t *bRow, size_t width, bool triplicate);  // image.c
+void imgBWRowScalar(uint8_t *rRow, uint8_t *gRow, uint8_t *bRow, size_t width, bool triplicate);    // image.c
+void imgLumaRowAvx2(uint8_t *rRow, uint8_t *gRow, uint8_t *bRow, size_t width, bool triplicate);    // image_color_avx2.c
+void imgBWRowAvx2(uint8_t *rRow, uint8_t *gRow, uint8_t *bRow, size_t width, bool triplicate);      // image_color_avx2.c
+
+/**
+ * Chooses the best row converters for the CPU, see cpuSimdLevel()
+ * @return Kernel
+ */
+const img_color_kernel_t *imgColorKernel(void);
+
+/**
+ * Computes luma of a single pixel
+ * @param r Red
+ * @param g Green
+ * @param b Blue
+ * @return Luma
+ */
+static inline uint8_t imgLumaPixel(uint8_t r, uint8_t g, uint8_t b)
+{
+    return (uint8_t)((IMG_LUMA_R * r + IMG_LUMA_G * g + IMG_LUMA_B * b) >> IMG_LUMA_BITS);
+}
+
+#endif // guardian
@@ -0,0 +1,39 @@
+#ifndef _IMAGE_HASH_H_
+#define _IMAGE_HASH_H_
+
+#include "image.h"
+#include "image_color.h"
+#include "cpu_dispatch.h"
+
+/*
+** Fused average hash
+**
+** The source is split into an AVG_HASH_IMG_DIM x AVG_HASH_IMG_DIM grid of cells. Every row of every
+** channel is reduced straight into per-cell sums by a row primitive, the luma weights of
+** imgToGrayscale (IMG_LUMA_*) and the threshold are then applied to the 64 cell sums. Nothing but
+** the source channels is touched and nothing is allocated.
+** Row primitives are implemented per kernel in their own translation units, see image_resize.h.
+*/
+
+/* Source columns covered by every cell of a grid row */
+typedef struct
+{
+    size_t starts[AVG_HASH_IMG_DIM];    ///< first column of every cell
+    size_t ends[AVG_HASH_IMG_DIM];      ///< column past every cell, never equal to its start
+} avg_hash_cells_t;
+
+/**
+ * Adds pixels of a row to the sums of the cells they belong to
+ * @param row Source row
+ * @param cells Columns of cells
+ * @param sums Per-cell sums to add to
+ */
+typedef void (*avg_hash_row_fn_t)(const uint8_t *row, const avg_hash_cells_t *cells,
+                                  uint64_t sums[AVG_HASH_IMG_DIM]);
+
+void avgHashRowSumsScalar(const uint8_t *row, const avg_hash_cells_t *cells,
+                          uint64_t sums[AVG_HASH_IMG_DIM]);                     // image_hash.c
+void avgHashRowSumsAvx2(const uint8_t *row, const avg_hash_cells_t *cells,
+                        uint64_t sums[AVG_HASH_IMG_DIM]);                       // image_hash_avx2.c
+
+#endif // guardian
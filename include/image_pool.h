@@ -0,0 +1,128 @@
+#ifndef _IMAGE_POOL_H_
+#define _IMAGE_POOL_H_
+
+#include <pthread.h>
+#include "image.h"
+
+/*
+** Pool of image buffers
+**
+** Destroyed images of a pool keep their channels and are handed out again by later requests of the
+** same size class, so repeated loads, resizes and hashes neither call the allocator nor fault in
+** fresh pages. Every power of two is split to IMG_POOL_CLASS_STEPS size classes, a buffer wastes
+** at most 1 / IMG_POOL_CLASS_STEPS of its size. Buffers of at least IMG_POOL_HUGE_PAGE_SIZE may be
+** mapped with transparent huge pages.
+**
+** Once a pool is made the default one, imgCreate takes images from it and imgDestroy returns them.
+*/
+
+#define IMG_POOL_CLASS_STEPS        4
+#define IMG_POOL_MIN_BYTES          4096
+#define IMG_POOL_N_CLASSES          (64 * IMG_POOL_CLASS_STEPS)
+#define IMG_POOL_HUGE_PAGE_SIZE     (2 * 1024 * 1024)
+
+/* pool flags */
+#define IMG_POOL_HUGE_PAGES         0x1     ///< map large buffers with transparent huge pages
+#define IMG_POOL_PREFAULT           0x2     ///< fault in pages of new buffers when they are allocated
+
+/* Buffer of a pool, the image is handed out while the buffer is in use */
+typedef struct img_pool_buffer
+{
+    image_t img;                            ///< must be the first member, images are cast back
+    size_t capacity;                        ///< bytes of channels
+    size_t sizeClass;                       ///< free list the buffer is released to
+    uint8_t *mapping;                       ///< start of the mapping or NULL if allocated
+    size_t mappingLen;                      ///< length of the mapping
+    struct img_pool_buffer *next;           ///< next released buffer of the size class
+} img_pool_buffer_t;
+
+/* Usage statistics of a pool */
+typedef struct
+{
+    size_t hits;                            ///< requests served by a released buffer
+    size_t misses;                          ///< requests that allocated a new buffer
+    size_t nBuffers;                        ///< buffers in use and released
+    size_t nCached;                         ///< released buffers
+    size_t allocatedBytes;                  ///< capacity of buffers in use and released, not resident pages
+    size_t cachedBytes;                     ///< bytes of released buffers
+    size_t peakAllocatedBytes;              ///< maximum of allocatedBytes
+} img_pool_stats_t;
+
+/* Size-classed free lists of image buffers */
+typedef struct img_pool
+{
+    pthread_mutex_t lock;
+    img_pool_buffer_t *free[IMG_POOL_N_CLASSES];    ///< released buffers of every size class
+    unsigned flags;                                 ///< IMG_POOL_ flags
+    size_t maxCachedBytes;                          ///< released buffers above are freed, 0 for no limit
+    size_t maxCachedBuffers;                        ///< released buffers above are freed, 0 for no limit
+    img_pool_stats_t stats;
+} img_pool_t;
+
+/**
+ * Creates an empty pool
+ * @param maxCachedBytes Maximal bytes of released buffers kept for reuse, 0 for no limit
+ * @param flags IMG_POOL_HUGE_PAGES, IMG_POOL_PREFAULT or 0
+ * @return New pool or NULL on error
+ */
+img_pool_t *imgPoolCreate(size_t maxCachedBytes, unsigned flags);
+
+/**
+ * Limits the number of released buffers kept for reuse
+ * Bounds the cache by the largest buffers of a workload whose sizes are not known in advance.
+ * Applies to later releases, buffers already released are kept.
+ * @param pool Pool
+ * @param maxCachedBuffers Maximal number of released buffers, 0 for no limit
+ */
+void imgPoolSetMaxCachedBuffers(img_pool_t *pool, size_t maxCachedBuffers);
+
+/**
+ * Deallocates the pool and its released buffers
+ * All images of the pool must be destroyed before.
+ * @param pool Pool to destroy
+ */
+void imgPoolDestroy(img_pool_t *pool);
+
+/**
+ * Takes an image from the pool, its channels are not initialized
+ * Channels are aligned and padded as by imgCreate, imgDestroy returns the image to the pool.
+ * @param pool Pool
+ * @param width Image width
+ * @param height Image height
+ * @return Image or NULL on error
+ */
+image_t *imgPoolAcquire(img_pool_t *pool, size_t width, size_t height);
+
+/**
+ * Returns an image to its pool, the same as imgDestroy
+ * @param img Image taken from a pool
+ */
+void imgPoolRelease(image_t *img);
+
+/**
+ * Deallocates all released buffers of the pool
+ * @param pool Pool
+ */
+void imgPoolTrim(img_pool_t *pool);
+
+/**
+ * Reads usage statistics of the pool
+ * @param pool Pool
+ * @param stats Variable to store the statistics to
+ */
+void imgPoolStats(img_pool_t *pool, img_pool_stats_t *stats);
+
+/**
+ * Makes imgCreate take images from a pool
+ * Must not be called while other threads create images.
+ * @param pool Pool or NULL to allocate every image on its own
+ */
+void imgPoolSetDefault(img_pool_t *pool);
+
+/**
+ * Returns the pool imgCreate takes images from
+ * @return Pool or NULL if images are allocated on their own
+ */
+img_pool_t *imgPoolDefault(void);
+
+#endif // guardian
@@ -0,0 +1,572 @@
+#ifndef _IMAGE_RESIZE_H_
+#define _IMAGE_RESIZE_H_
+
+#include "image.h"
+#include "cpu_dispatch.h"
+#include "trace.h"
+
+/*
+** Separable resize engine
+**
+** Every source row is interpolated horizontally only once into a row cache, new rows are then
+** vertically interpolated from two cached rows. The row primitives below are implemented by every
+** kernel (scalar, SSE2, AVX, ...) in its own translation unit compiled with its own -m flags.
+** The engine driving them is in image_resize_plan.c, the kernel is chosen at runtime.
+**
+** Rows handed to row primitives are padded to RESIZE_PADDED_LEN(newWidth) values: column tables of
+** plans, horizontally interpolated rows and new rows. Tables and interpolated rows are aligned to
+** IMG_ALIGN. Primitives may process the padding instead of finishing rows with scalar code.
+*/
+
+/* Padded length of rows handed to row primitives, in values of any type */
+#define RESIZE_PADDED_LEN(n)    IMG_ROW_STRIDE(n)
+
+/*
+** Blocks of RESIZE_SHUFFLE_N_COLS new columns whose left and right source pixels all lie within
+** RESIZE_SHUFFLE_SPAN bytes from the left pixel of the first column, as in any upscale, are read by a
+** single load. plan->cShuffleTable holds 2 * RESIZE_SHUFFLE_N_COLS byte indices of every block relative
+** to that pixel, left pixels followed by right ones, for a byte shuffle of the loaded bytes. Indices of
+** blocks spanning more bytes are 0, see resizeShuffleFits().
+*/
+#define RESIZE_SHUFFLE_N_COLS   8
+#define RESIZE_SHUFFLE_SPAN     16
+
+#define ROW_CACHE_N_ROWS    2
+#define ROW_CACHE_EMPTY     SIZE_MAX
+
+/* Ring of horizontally interpolated source rows */
+typedef struct
+{
+    size_t  tags[ROW_CACHE_N_ROWS];     ///< source row held by every slot
+    void    *rows[ROW_CACHE_N_ROWS];    ///< horizontally interpolated rows
+} row_cache_t;
+
+/**
+ * Finds a cached row or a slot to interpolate it to
+ * @param cache Row cache
+ * @param r Requested source row
+ * @param keep Source row that must not be evicted
+ * @param hit Variable to store whether the row is already cached to
+ * @return Slot index
+ */
+static inline size_t rowCacheSlot(row_cache_t *cache, size_t r, size_t keep, bool *hit)
+{
+    size_t slot = 0;
+
+    for (slot = 0; slot < ROW_CACHE_N_ROWS; slot++)
+    {
+        if (cache->tags[slot] == r)
+        {
+            *hit = true;
+            return slot;
+        }
+    }
+
+    slot = (cache->tags[0] == keep) ? 1 : 0;
+    cache->tags[slot] = r;
+    *hit = false;
+    return slot;
+}
+
+/**
+ * Empties a row cache
+ * @param cache Row cache
+ */
+static inline void rowCacheReset(row_cache_t *cache)
+{
+    for (size_t slot = 0; slot < ROW_CACHE_N_ROWS; slot++)
+    {
+        cache->tags[slot] = ROW_CACHE_EMPTY;
+    }
+}
+
+/*
+** Area-averaging downscale
+**
+** Every new pixel is the mean of the source area it covers. Along each axis a new pixel covers
+** source pixels first .. last, the inner ones fully and the first and last ones by their weights.
+** Source rows covered by a new row are accumulated by their vertical weights in full width, the
+** accumulated row is then summed horizontally once per new row. The last row of a new row is often
+** the first row of the next one, such a row is accumulated into both rows in a single read.
+*/
+
+/* Coverage tables of a single area downscale geometry */
+typedef struct
+{
+    size_t width;                       ///< source width
+    size_t height;                      ///< source height
+    size_t newWidth;                    ///< destination width
+    size_t newHeight;                   ///< destination height
+    uint32_t *cFirst;                   ///< first covered source column of every new column
+    uint32_t *cLast;                    ///< last covered source column of every new column
+    float *cWFirst;                     ///< coverage of the first column, of the only one if first == last
+    float *cWLast;                      ///< coverage of the last column, 0 if first == last
+    uint32_t *rFirst;                   ///< first covered source row of every new row
+    uint32_t *rLast;                    ///< last covered source row of every new row
+    float *rWFirst;                     ///< coverage of the first row, of the only one if first == last
+    float *rWLast;                      ///< coverage of the last row, 0 if first == last
+    float norm;                         ///< reciprocal of the area of a new pixel
+} resize_area_plan_t;
+
+/*
+** Separable convolution resize (bicubic, Lanczos-3)
+**
+** Every new column and row has RESIZE_FILTER_W_BITS fixed-point weights of a window of source
+** pixels, windows are clamped to the image and weights of clamped taps are folded to edge pixels.
+** Horizontal pass:    h = (sum w * p + round) >> (W_BITS - H_BITS)         (int16, H_BITS fraction)
+** Vertical pass:      v = (sum w * h + round) >> (W_BITS + H_BITS)         (clamped to 0 .. 255)
+** Sums are exact in int32, so the scalar reference and the SIMD kernels are bit-identical.
+*/
+
+#define RESIZE_FILTER_W_BITS        14
+#define RESIZE_FILTER_H_BITS        6
+/* horizontal taps are padded for 4 taps per gather, vertical ones for pairs of rows */
+#define RESIZE_FILTER_X_TAPS_ALIGN  4
+#define RESIZE_FILTER_Y_TAPS_ALIGN  2
+/* new columns sharing a block of interleaved weights */
+#define RESIZE_FILTER_X_LANES       8
+
+/* Coefficient tables of a single convolution resize geometry */
+typedef struct
+{
+    size_t width;                       ///< source width
+    size_t height;                      ///< source height
+    size_t newWidth;                    ///< destination width
+    size_t newHeight;                   ///< destination height
+    size_t nTapsX;                      ///< weights of every new column, padded by zero weights
+    size_t nTapsY;                      ///< weights of every new row, padded by zero weights
+    size_t nRowsY;                      ///< source rows of every vertical window
+    uint32_t *cStart;                   ///< first source column of every new column, padded
+    int16_t *cWeights;                  ///< column weights, pairs of taps interleaved by blocks of columns
+    uint32_t *rStart;                   ///< first source row of every new row
+    int16_t *rWeights;                  ///< nTapsY weights of every new row
+} resize_filter_plan_t;
+
+/**
+ * Returns a horizontal weight
+ * Blocks of RESIZE_FILTER_X_LANES columns hold pairs of taps of all their columns next to each other,
+ * so a vector of tap pairs of all columns of a block is a single load.
+ * @param plan Filter plan
+ * @param cNew New column
+ * @param tap Tap
+ * @return Weight
+ */
+static inline int16_t resizeFilterWeightX(const resize_filter_plan_t *plan, size_t cNew, size_t tap)
+{
+    size_t block = cNew / RESIZE_FILTER_X_LANES;
+    size_t lane = cNew % RESIZE_FILTER_X_LANES;
+    size_t pair = block * (plan->nTapsX / 2) + tap / 2;
+
+    return plan->cWeights[(pair * RESIZE_FILTER_X_LANES + lane) * 2 + tap % 2];
+}
+
+/* Row primitives of a single kernel */
+typedef struct
+{
+    /**
+     * Horizontally interpolates a source row
+     * @param plan Resize plan
+     * @param row Source row of plan->width pixels
+     * @param hRow Row of plan->newWidth values to store the result to
+     */
+    void (*horizontalFloat)(const img_resize_plan_t *plan, const uint8_t *row, float *hRow);
+
+    /**
+     * Vertically interpolates two horizontally interpolated rows
+     * @param h0Row Upper row
+     * @param h1Row Lower row
+     * @param deltaR Vertical delta
+     * @param newRow Row to store the result to
+     * @param newWidth Row length
+     */
+    void (*verticalFloat)(const float *h0Row, const float *h1Row, float deltaR, uint8_t *newRow,
+                          size_t newWidth);
+
+    /**
+     * Horizontally interpolates a source row in fixed-point
+     * @param plan Resize plan
+     * @param row Source row of plan->width pixels
+     * @param hRow Row of plan->newWidth values to store the result to, scaled by RESIZE_FIXED_ONE
+     */
+    void (*horizontalFixed)(const img_resize_plan_t *plan, const uint8_t *row, uint16_t *hRow);
+
+    /**
+     * Vertically interpolates two horizontally interpolated rows in fixed-point
+     * @param h0Row Upper row
+     * @param h1Row Lower row
+     * @param fy Vertical fraction
+     * @param newRow Row to store the result to
+     * @param newWidth Row length
+     */
+    void (*verticalFixed)(const uint16_t *h0Row, const uint16_t *h1Row, uint8_t fy, uint8_t *newRow,
+                          size_t newWidth);
+
+    /**
+     * Horizontally interpolates a packed source row, verticalFloat applies to the result as is
+     * @param plan Resize plan
+     * @param row Source row of plan->width pixels
+     * @param nChannels Channels per pixel
+     * @param hRow Row of plan->newWidth * nChannels values to store the result to
+     */
+    void (*horizontalPacked)(const img_resize_plan_t *plan, const uint8_t *row, size_t nChannels,
+                             float *hRow);
+
+    /**
+     * Accumulates a source row weighted by its vertical coverage
+     * @param row Source row
+     * @param weight Vertical coverage of the row
+     * @param accRow Row to accumulate to
+     * @param width Row length
+     */
+    void (*verticalArea)(const uint8_t *row, float weight, float *accRow, size_t width);
+
+    /**
+     * Accumulates a source row covered by two new rows and starts the accumulated row of the second
+     * nextAccRow is the same as if it was zeroed and passed to verticalArea
+     * @param row Source row
+     * @param weight Vertical coverage of the row by the first new row
+     * @param accRow Row of the first new row to accumulate to
+     * @param nextWeight Vertical coverage of the row by the second new row
+     * @param nextAccRow Row of the second new row to store to
+     * @param width Row length
+     */
+    void (*verticalAreaSplit)(const uint8_t *row, float weight, float *accRow, float nextWeight, float *nextAccRow,
+                              size_t width);
+
+    /**
+     * Convolves a source row with column weights
+     * @param plan Filter plan
+     * @param row Source row of plan->width pixels
+     * @param hRow Row of plan->newWidth values to store the result to
+     */
+    void (*horizontalFilter)(const resize_filter_plan_t *plan, const uint8_t *row, int16_t *hRow);
+
+    /**
+     * Convolves horizontally filtered rows with row weights
+     * @param rows plan->nTapsY rows
+     * @param weights plan->nTapsY weights
+     * @param nTaps Number of rows and weights, even
+     * @param newRow Row to store the result to
+     * @param newWidth Row length
+     */
+    void (*verticalFilter)(const int16_t *const *rows, const int16_t *weights, size_t nTaps, uint8_t *newRow,
+                           size_t newWidth);
+
+    /**
+     * Takes every (1 << factorLog2)-th pixel of a source row
+     * @param row Source row of newWidth << factorLog2 pixels
+     * @param factorLog2 Log2 of the downscale factor, 1 or 2
+     * @param newRow Row to store the result to
+     * @param newWidth Row length
+     */
+    void (*downscaleRatio)(const uint8_t *row, size_t factorLog2, uint8_t *newRow, size_t newWidth);
+
+    /**
+     * Interpolates a new row between two source rows at a fixed ratio
+     * @param row0 Upper source row
+     * @param row1 Lower source row, the same as row0 at the bottom edge
+     * @param fy Vertical phase of the new row, 0 .. (1 << factorLog2) - 1
+     * @param factorLog2 Log2 of the upscale factor, 1 or 2
+     * @param newRow Row of width << factorLog2 pixels to store the result to
+     * @param width Source row length
+     */
+    void (*upscaleRatio)(const uint8_t *row0, const uint8_t *row1, size_t fy, size_t factorLog2, uint8_t *newRow,
+                         size_t width);
+} resize_kernel_t;
+
+/* Declares float row primitives of a kernel, e.g. resizeHorizontalFloatAvx */
+#define RESIZE_DECLARE_FLOAT_KERNEL(isa)                                                            \
+    void resizeHorizontalFloat##isa(const img_resize_plan_t *plan, const uint8_t *row, float *hRow); \
+    void resizeVerticalFloat##isa(const float *h0Row, const float *h1Row, float deltaR,              \
+                                  uint8_t *newRow, size_t newWidth)
+
+/* Declares fixed-point row primitives of a kernel, e.g. resizeHorizontalFixedAvx2 */
+#define RESIZE_DECLARE_FIXED_KERNEL(isa)                                                                \
+    void resizeHorizontalFixed##isa(const img_resize_plan_t *plan, const uint8_t *row, uint16_t *hRow);  \
+    void resizeVerticalFixed##isa(const uint16_t *h0Row, const uint16_t *h1Row, uint8_t fy,             \
+                                  uint8_t *newRow, size_t newWidth)
+
+/* Declares packed row primitives of a kernel, e.g. resizeHorizontalPackedAvx */
+#define RESIZE_DECLARE_PACKED_KERNEL(isa)                                                           \
+    void resizeHorizontalPacked##isa(const img_resize_plan_t *plan, const uint8_t *row,             \
+                                     size_t nChannels, float *hRow)
+
+/* Declares area row primitives of a kernel, e.g. resizeVerticalAreaSse2 */
+#define RESIZE_DECLARE_AREA_KERNEL(isa)                                                             \
+    void resizeVerticalArea##isa(const uint8_t *row, float weight, float *accRow, size_t width);   \
+    void resizeVerticalAreaSplit##isa(const uint8_t *row, float weight, float *accRow,             \
+                                      float nextWeight, float *nextAccRow, size_t width)
+
+/* Declares convolution row primitives of a kernel, e.g. resizeHorizontalFilterAvx2 */
+#define RESIZE_DECLARE_FILTER_KERNEL(isa)                                                               \
+    void resizeHorizontalFilter##isa(const resize_filter_plan_t *plan, const uint8_t *row, int16_t *hRow); \
+    void resizeVerticalFilter##isa(const int16_t *const *rows, const int16_t *weights, size_t nTaps,     \
+                                   uint8_t *newRow, size_t newWidth)
+
+/* Declares integer ratio row primitives of a kernel, e.g. resizeUpscaleRatioAvx2 */
+#define RESIZE_DECLARE_RATIO_KERNEL(isa)                                                            \
+    void resizeDownscaleRatio##isa(const uint8_t *row, size_t factorLog2, uint8_t *newRow,          \
+                                   size_t newWidth);                                                \
+    void resizeUpscaleRatio##isa(const uint8_t *row0, const uint8_t *row1, size_t fy,               \
+                                 size_t factorLog2, uint8_t *newRow, size_t width)
+
+RESIZE_DECLARE_FLOAT_KERNEL(Scalar);        // image_resize.c
+RESIZE_DECLARE_FIXED_KERNEL(Scalar);        // image_resize.c
+RESIZE_DECLARE_PACKED_KERNEL(Scalar);       // image_resize.c
+RESIZE_DECLARE_AREA_KERNEL(Scalar);         // image_resize.c
+RESIZE_DECLARE_FILTER_KERNEL(Scalar);       // image_resize.c
+RESIZE_DECLARE_RATIO_KERNEL(Scalar);        // image_resize.c
+RESIZE_DECLARE_FLOAT_KERNEL(Sse2);          // image_resize_sse2.c
+RESIZE_DECLARE_AREA_KERNEL(Sse2);           // image_resize_sse2.c
+RESIZE_DECLARE_FLOAT_KERNEL(Avx);           // image_resize_avx.c
+RESIZE_DECLARE_PACKED_KERNEL(Avx);          // image_resize_avx.c
+RESIZE_DECLARE_AREA_KERNEL(Avx);            // image_resize_avx.c
+RESIZE_DECLARE_FIXED_KERNEL(Avx2);          // image_resize_avx2.c
+RESIZE_DECLARE_AREA_KERNEL(Avx2);           // image_resize_avx2.c
+RESIZE_DECLARE_FILTER_KERNEL(Avx2);         // image_resize_avx2.c
+RESIZE_DECLARE_RATIO_KERNEL(Avx2);          // image_resize_avx2.c
+RESIZE_DECLARE_FLOAT_KERNEL(Avx512);        // image_resize_avx512.c
+RESIZE_DECLARE_FIXED_KERNEL(Avx512);        // image_resize_avx512.c
+RESIZE_DECLARE_AREA_KERNEL(Avx512);         // image_resize_avx512.c
+
+/**
+ * Chooses the best kernel for the CPU, see cpuSimdLevel()
+ * @return Kernel
+ */
+const resize_kernel_t *resizeKernel(void);
+
+/**
+ * Returns the kernel of a SIMD level regardless of the CPU, e.g. to compare kernels
+ * @param level SIMD level, must be supported by the CPU before the kernel is run
+ * @return Kernel
+ */
+const resize_kernel_t *resizeKernelForLevel(simd_level_t level);
+
+/**
+ * Resizes a band of new rows with float row primitives
+ * Bands are independent and may be processed concurrently
+ * @param kernel Kernel to use
+ * @param plan Resize plan matching img and newImg
+ * @param img Source image
+ * @param newImg Destination image
+ * @param rBegin First new row of the band
+ * @param rEnd New row past the band
+ * @return Success flag
+ */
+bool resizeBandFloat(const resize_kernel_t *kernel, const img_resize_plan_t *plan, const image_t *img,
+                     image_t *newImg, size_t rBegin, size_t rEnd);
+
+/**
+ * Resizes a band of new rows with fixed-point row primitives
+ * Bands are independent and may be processed concurrently
+ * @param kernel Kernel to use
+ * @param plan Resize plan matching img and newImg
+ * @param img Source image
+ * @param newImg Destination image
+ * @param rBegin First new row of the band
+ * @param rEnd New row past the band
+ * @return Success flag
+ */
+bool resizeBandFixed(const resize_kernel_t *kernel, const img_resize_plan_t *plan, const image_t *img,
+                     image_t *newImg, size_t rBegin, size_t rEnd);
+
+/**
+ * Precomputes coverage tables of an area downscale
+ * @param width Source image width
+ * @param height Source image height
+ * @param newWidth Width of resized images, at most width
+ * @param newHeight Height of resized images, at most height
+ * @return New plan or NULL on error
+ */
+resize_area_plan_t *resizeAreaPlanCreate(size_t width, size_t height, size_t newWidth, size_t newHeight);
+
+/**
+ * Deallocates all resources of an area plan
+ * @param plan Plan to destroy
+ */
+void resizeAreaPlanDestroy(resize_area_plan_t *plan);
+
+/**
+ * Downscales a band of new rows by area averaging
+ * Bands are independent and may be processed concurrently, a source row shared by the last new row
+ * of a band and the first one of the next band is read by both bands
+ * @param kernel Kernel to use
+ * @param plan Area plan matching img and newImg
+ * @param img Source image
+ * @param newImg Destination image
+ * @param rBegin First new row of the band
+ * @param rEnd New row past the band
+ * @return Success flag
+ */
+bool resizeBandArea(const resize_kernel_t *kernel, const resize_area_plan_t *plan, const image_t *img,
+                    image_t *newImg, size_t rBegin, size_t rEnd);
+
+/**
+ * Computes fixed-point weights of a convolution resize
+ * @param width Source image width
+ * @param height Source image height
+ * @param newWidth Width of resized images
+ * @param newHeight Height of resized images
+ * @param filter Filter
+ * @return New plan or NULL on error
+ */
+resize_filter_plan_t *resizeFilterPlanCreate(size_t width, size_t height, size_t newWidth, size_t newHeight,
+                                             img_filter_t filter);
+
+/**
+ * Deallocates all resources of a filter plan
+ * @param plan Plan to destroy
+ */
+void resizeFilterPlanDestroy(resize_filter_plan_t *plan);
+
+/**
+ * Resizes a band of new rows by separable convolution
+ * Bands are independent and may be processed concurrently
+ * @param kernel Kernel to use
+ * @param plan Filter plan matching img and newImg
+ * @param img Source image
+ * @param newImg Destination image
+ * @param rBegin First new row of the band
+ * @param rEnd New row past the band
+ * @return Success flag
+ */
+bool resizeBandFilter(const resize_kernel_t *kernel, const resize_filter_plan_t *plan, const image_t *img,
+                      image_t *newImg, size_t rBegin, size_t rEnd);
+
+/**
+ * Checks whether a resize scales both axes by the same factor of 2 or 4
+ * @param width Source image width
+ * @param height Source image height
+ * @param newWidth Width of resized images
+ * @param newHeight Height of resized images
+ * @return Log2 of the factor, 1 or 2 for upscales, -1 or -2 for downscales, 0 for other resizes
+ */
+int resizeRatioLog2(size_t width, size_t height, size_t newWidth, size_t newHeight);
+
+/**
+ * Resizes a band of new rows at an integer ratio found by resizeRatioLog2()
+ * Bands are independent and may be processed concurrently
+ * @param kernel Kernel to use
+ * @param img Source image
+ * @param newImg Destination image
+ * @param rBegin First new row of the band
+ * @param rEnd New row past the band
+ * @return Success flag
+ */
+bool resizeBandRatio(const resize_kernel_t *kernel, const image_t *img, image_t *newImg, size_t rBegin,
+                     size_t rEnd);
+
+/**
+ * Checks whether images match dimensions of a resize plan
+ * @param plan Resize plan
+ * @param img Source image
+ * @param newImg Destination image
+ * @return True if the plan can be applied
+ */
+static inline bool imgResizePlanMatches(const img_resize_plan_t *plan, const image_t *img,
+                                        const image_t *newImg)
+{
+    return plan && img && newImg
+            && plan->width == img->width && plan->height == img->height
+            && plan->newWidth == newImg->width && plan->newHeight == newImg->height;
+}
+
+/**
+ * Checks whether source pixels of a block of new columns are covered by a shuffle of a single load
+ * @param cTable Source column of every new column, padded
+ * @param cNew First new column of the block, a multiple of RESIZE_SHUFFLE_N_COLS
+ * @return Whether the block has shuffle indices
+ */
+static inline bool resizeShuffleFits(const uint32_t *cTable, size_t cNew)
+{
+    /* the right pixel of the last column is the last byte at most */
+    return cTable[cNew + RESIZE_SHUFFLE_N_COLS - 1] + 1 - cTable[cNew] < RESIZE_SHUFFLE_SPAN;
+}
+
+/**
+ * Horizontally interpolates a single pixel
+ * Vector kernels use the same operation order so that results are bit-identical
+ * @param row Source row
+ * @param c Column of the left pixel
+ * @param deltaC Horizontal delta
+ * @return Interpolated value
+ */
+static inline float resizeHorizontalFloatPixel(const uint8_t *row, size_t c, float deltaC)
+{
+    return row[c] * (1.0f - deltaC) + row[c + 1] * deltaC;
+}
+
+/**
+ * Horizontally interpolates a single channel of a packed pixel
+ * Same operation order as resizeHorizontalFloatPixel
+ * @param pixel Channel of the left pixel
+ * @param nChannels Channels per pixel
+ * @param deltaC Horizontal delta
+ * @return Interpolated value
+ */
+static inline float resizeHorizontalPackedPixel(const uint8_t *pixel, size_t nChannels, float deltaC)
+{
+    return pixel[0] * (1.0f - deltaC) + pixel[nChannels] * deltaC;
+}
+
+/**
+ * Vertically interpolates a single pixel
+ * @param h0 Upper value
+ * @param h1 Lower value
+ * @param deltaR Vertical delta
+ * @return Pixel value
+ */
+static inline uint8_t resizeVerticalFloatPixel(float h0, float h1, float deltaR)
+{
+    return (uint8_t)(h0 * (1.0f - deltaR) + h1 * deltaR);
+}
+
+/**
+ * Accumulates a single pixel of a source row
+ * Vector kernels use the same operations, so accumulated rows are bit-identical
+ * @param acc Accumulated value
+ * @param weight Vertical coverage of the row
+ * @param p Source pixel
+ * @return New accumulated value
+ */
+static inline float resizeVerticalAreaPixel(float acc, float weight, uint8_t p)
+{
+    return acc + weight * (float)p;
+}
+
+/**
+ * Interpolates a single pixel of an integer ratio upscale
+ * Weights are multiples of 1 / (1 << factorLog2), so the float interpolation of imgResize() is exact
+ * and truncating the exact value here gives the same pixels.
+ * @param p00 Upper left pixel
+ * @param p01 Upper right pixel
+ * @param p10 Lower left pixel
+ * @param p11 Lower right pixel
+ * @param fx Horizontal phase, 0 .. (1 << factorLog2) - 1
+ * @param fy Vertical phase, 0 .. (1 << factorLog2) - 1
+ * @param factorLog2 Log2 of the upscale factor
+ * @return Pixel value
+ */
+static inline uint8_t resizeUpscaleRatioPixel(uint8_t p00, uint8_t p01, uint8_t p10, uint8_t p11, size_t fx,
+                                              size_t fy, size_t factorLog2)
+{
+    size_t f = (size_t)1 << factorLog2;
+    size_t h0 = (f - fx) * p00 + fx * p01;
+    size_t h1 = (f - fx) * p10 + fx * p11;
+
+    return (uint8_t)(((f - fy) * h0 + fy * h1) >> (2 * factorLog2));
+}
+
+/**
+ * Rounds and clamps a vertically convolved value
+ * @param acc Sum of weighted horizontally filtered values
+ * @return Pixel value
+ */
+static inline uint8_t resizeFilterPixel(int32_t acc)
+{
+    acc = (acc + (1 << (RESIZE_FILTER_W_BITS + RESIZE_FILTER_H_BITS - 1)))
+            >> (RESIZE_FILTER_W_BITS + RESIZE_FILTER_H_BITS);
+    return (acc < 0) ? 0 : (acc > 255) ? 255 : (uint8_t)acc;
+}
+
+#endif // guardian
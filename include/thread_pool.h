@@ -0,0 +1,93 @@
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Queued unit of work */
+typedef struct thread_pool_task
+{
+    void (*fn)(void *arg);                      ///< function to execute
+    void *arg;                                  ///< argument of fn
+    struct thread_pool_group *group;            ///< group to notify on completion, may be NULL
+    struct thread_pool_task *next;              ///< next queued task
+} thread_pool_task_t;
+
+/* Set of tasks that can be waited for together */
+typedef struct thread_pool_group
+{
+    pthread_mutex_t lock;
+    pthread_cond_t done;                        ///< signalled whenever a task finishes
+    size_t pending;                             ///< submitted but not finished tasks
+} thread_pool_group_t;
+
+/* Persistent pool of worker threads */
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t work;                        ///< signalled when a task is queued
+    thread_pool_task_t *head;                   ///< first queued task
+    thread_pool_task_t *tail;                   ///< last queued task
+    pthread_t *threads;
+    size_t nThreads;
+    bool stop;                                  ///< workers exit once the queue is empty
+} thread_pool_t;
+
+/**
+ * Starts a pool of worker threads
+ * @param nThreads Number of workers, 0 for the number of online CPUs
+ * @return New pool or NULL on error
+ */
+thread_pool_t *threadPoolCreate(size_t nThreads);
+
+/**
+ * Finishes all queued tasks, joins the workers and deallocates the pool
+ * @param pool Pool to destroy
+ */
+void threadPoolDestroy(thread_pool_t *pool);
+
+/**
+ * Queues a task
+ * @param pool Pool to execute the task
+ * @param group Group to account the task to or NULL
+ * @param fn Function to execute
+ * @param arg Argument of fn
+ * @return Success flag
+ */
+bool threadPoolSubmit(thread_pool_t *pool, thread_pool_group_t *group, void (*fn)(void *), void *arg);
+
+/**
+ * Initializes an empty task group
+ * @param group Group to initialize
+ * @return Success flag
+ */
+bool threadPoolGroupInit(thread_pool_group_t *group);
+
+/**
+ * Waits until all tasks of a group finish, the group can be reused afterwards
+ * @param group Group to wait for
+ */
+void threadPoolGroupWait(thread_pool_group_t *group);
+
+/**
+ * Waits until at most maxPending tasks of a group are unfinished
+ * Lets producers bound the number of queued tasks
+ * @param group Group to wait for
+ * @param maxPending Number of tasks that may remain pending
+ */
+void threadPoolGroupWaitPending(thread_pool_group_t *group, size_t maxPending);
+
+/**
+ * Deallocates resources of a task group with no pending tasks
+ * @param group Group to destroy
+ */
+void threadPoolGroupDestroy(thread_pool_group_t *group);
+
+/**
+ * Number of online CPUs
+ * @return Number of CPUs, at least 1
+ */
+size_t threadPoolCpuCount(void);
+
+#endif // guardian
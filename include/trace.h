@@ -0,0 +1,73 @@
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+** Tracing spans of image stages
+**
+** Built with -DIMG_TRACE (make TRACE=1), every load, deinterleave, resize, grayscale, hash and save
+** records a span: its monotonic start and duration and the bytes and pixels it processed. Without
+** the flag TRACE_BEGIN and TRACE_END expand to nothing.
+**
+** Spans are recorded only if TRACE_ENV names an output file. Every thread appends to its own buffer
+** and sums its own counters, buffers are linked to a global list by compare and swap on their first
+** span, so recording never takes a lock. At exit all buffers are written to the file as a Chrome
+** trace (chrome://tracing, Perfetto), per stage totals of all threads are added as "stages". Spans
+** nest, a hash span includes the resize span of the hash, totals are inclusive.
+*/
+
+/* Environment variable naming the trace file, e.g. IMG_TRACE=trace.json */
+#define TRACE_ENV               "IMG_TRACE"
+
+/* Spans kept per thread, later spans are counted but not written */
+#define TRACE_MAX_SPANS         (1 << 20)
+
+/* Traced stages */
+typedef enum
+{
+    TRACE_LOAD = 0,
+    TRACE_DEINTERLEAVE,
+    TRACE_RESIZE,
+    TRACE_GRAYSCALE,                    ///< grayscale and black and white conversion
+    TRACE_HASH,
+    TRACE_SAVE,
+    TRACE_STAGE_COUNT
+} trace_stage_t;
+
+/**
+ * Name of a stage
+ * @param stage Stage
+ * @return Name as written to traces
+ */
+const char *traceStageName(trace_stage_t stage);
+
+#ifdef IMG_TRACE
+
+/**
+ * Starts a span
+ * @return Monotonic nanoseconds or 0 if tracing is off
+ */
+uint64_t traceBegin(void);
+
+/**
+ * Records a span of the calling thread
+ * @param stage Stage of the span
+ * @param begin Return value of traceBegin(), the span is dropped if 0
+ * @param bytes Bytes processed by the span
+ * @param pixels Pixels processed by the span
+ */
+void traceEnd(trace_stage_t stage, uint64_t begin, uint64_t bytes, uint64_t pixels);
+
+#define TRACE_BEGIN(span)                       uint64_t span = traceBegin()
+#define TRACE_END(span, stage, bytes, pixels)   traceEnd((stage), (span), (bytes), (pixels))
+
+#else
+
+#define TRACE_BEGIN(span)
+#define TRACE_END(span, stage, bytes, pixels)   do {} while (0)
+
+#endif
+
+#endif // guardian
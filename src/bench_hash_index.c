@@ -0,0 +1,209 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "hash_index.h"
+#include "utils.h"
+
+/*
+** Benchmark of radius queries over the hash index
+** Usage: bench-hash-index [radius] [n]...
+**
+** Every size runs on uniform hashes built at once, on uniform hashes of which the last
+** BENCH_INSERTED_PART are inserted one by one after the build, and on skewed hashes built at once.
+*/
+
+#define BENCH_DEFAULT_RADIUS    AVG_HASH_SIMILARITY_TRASHHOLD
+#define BENCH_N_QUERIES         100000
+#define BENCH_QUERY_SECONDS     5.0     // queries stop early once they take this long
+#define BENCH_N_CHECKED         200
+#define BENCH_MAX_IDS           1024
+#define BENCH_INSERTED_PART     8       // 1/8 of hashes are inserted after the build
+#define BENCH_ZERO_CHUNK_ODDS   4       // 1/4 of skewed 16 bit substrings are 0x0000
+
+static uint64_t benchRandState = 0x9E3779B97F4A7C15ull;
+
+static uint64_t benchRand(void)
+{
+    /* xorshift64* */
+    benchRandState ^= benchRandState >> 12;
+    benchRandState ^= benchRandState << 25;
+    benchRandState ^= benchRandState >> 27;
+    return benchRandState * 0x2545F4914F6CDD1Dull;
+}
+
+static double benchNow(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Generates a hash resembling average hashes of real images
+ * Flat image areas hash to runs of zero bits, so many 16 bit substrings are 0x0000 and fill few
+ * large buckets.
+ * @return Skewed hash
+ */
+static uint64_t benchSkewedHash(void)
+{
+    uint64_t hash = benchRand();
+
+    for (size_t chunk = 0; chunk < HASH_INDEX_N_CHUNKS; chunk++)
+    {
+        if (benchRand() % BENCH_ZERO_CHUNK_ODDS == 0)
+        {
+            hash &= ~((uint64_t)(HASH_INDEX_N_BUCKETS - 1) << (chunk * HASH_INDEX_CHUNK_BITS));
+        }
+    }
+    return hash;
+}
+
+static size_t linearQuery(const uint64_t *hashes, size_t n, uint64_t hash, size_t radius)
+{
+    size_t nFound = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        nFound += hemmingDistance(hashes[i], hash) <= radius;
+    }
+    return nFound;
+}
+
+/**
+ * Benchmarks one configuration
+ * @param n Number of hashes
+ * @param radius Query radius
+ * @param skewed Use benchSkewedHash instead of uniform hashes
+ * @param nInserted Number of hashes inserted one by one after building the index of the rest
+ * @return Success flag, false also when the index disagrees with a linear scan
+ */
+static bool benchRun(size_t n, size_t radius, bool skewed, size_t nInserted)
+{
+    uint64_t        *hashes = NULL;
+    uint64_t        *queries = NULL;
+    uint32_t        *ids = NULL;
+    hash_index_t    *index = NULL;
+    size_t          nFound = 0;
+    size_t          nQueries = 0;
+    double          start, buildTime, insertTime, queryTime, linearTime;
+
+    RET_ERR_MSG(!(hashes = malloc(sizeof(uint64_t) * n)), "Allocation error\n");
+    RET_ERR_MSG(!(queries = malloc(sizeof(uint64_t) * BENCH_N_QUERIES)), "Allocation error\n");
+    RET_ERR_MSG(!(ids = malloc(sizeof(uint32_t) * BENCH_MAX_IDS)), "Allocation error\n");
+
+    for (size_t i = 0; i < n; i++)
+    {
+        hashes[i] = skewed ? benchSkewedHash() : benchRand();
+    }
+
+    /* half of the queries are near duplicates of known hashes, the other half is unknown */
+    for (size_t i = 0; i < BENCH_N_QUERIES; i++)
+    {
+        uint64_t query = benchRand();
+        if (i & 1)
+        {
+            query = hashes[query % n];
+            for (size_t flip = benchRand() % (radius + 1); flip > 0; flip--)
+            {
+                query ^= 1ull << (benchRand() & 63);
+            }
+        }
+        queries[i] = query;
+    }
+
+    start = benchNow();
+    RET_ERR(!(index = hashIndexBuild(hashes, n - nInserted)));
+    buildTime = benchNow() - start;
+
+    start = benchNow();
+    for (size_t i = n - nInserted; i < n; i++)
+    {
+        RET_ERR(!hashIndexInsert(index, hashes[i], NULL));
+    }
+    insertTime = benchNow() - start;
+
+    start = benchNow();
+    for (queryTime = 0.0; nQueries < BENCH_N_QUERIES && queryTime < BENCH_QUERY_SECONDS; nQueries++)
+    {
+        nFound += hashIndexQuery(index, queries[nQueries], radius, ids, BENCH_MAX_IDS);
+        if (nQueries % 1024 == 1023)
+        {
+            queryTime = benchNow() - start;
+        }
+    }
+    queryTime = benchNow() - start;
+
+    /* cross-check a sample against a linear scan */
+    start = benchNow();
+    for (size_t i = 0; i < BENCH_N_CHECKED; i++)
+    {
+        size_t expected = linearQuery(hashes, n, queries[i], radius);
+        size_t found = hashIndexQuery(index, queries[i], radius, NULL, 0);
+        if (found != expected)
+        {
+            fprintf(stderr, "Query %zu: index found %zu, linear scan found %zu\n", i, found, expected);
+            goto error;
+        }
+    }
+    linearTime = (benchNow() - start) / BENCH_N_CHECKED;
+
+    printf("n = %zu, radius = %zu, %s hashes\n", n, radius, skewed ? "skewed" : "uniform");
+    printf("    build:          %.3f s (%zu hashes)\n", buildTime, n - nInserted);
+    if (nInserted)
+    {
+        printf("    insert:         %.0f inserts/s (%zu hashes)\n", nInserted / insertTime, nInserted);
+    }
+    printf("    index query:    %.0f queries/s (%.2f us/query, %zu matches in %zu queries)\n",
+           nQueries / queryTime, queryTime / nQueries * 1e6, nFound, nQueries);
+    printf("    linear scan:    %.0f queries/s (%.2f us/query)\n", 1.0 / linearTime, linearTime * 1e6);
+
+    hashIndexDestroy(index);
+    free(ids);
+    free(queries);
+    free(hashes);
+    return true;
+
+error:
+    hashIndexDestroy(index);
+    free(ids);
+    free(queries);
+    free(hashes);
+    return false;
+}
+
+static bool benchSize(size_t n, size_t radius)
+{
+    return benchRun(n, radius, false, 0)
+        && benchRun(n, radius, false, n / BENCH_INSERTED_PART)
+        && benchRun(n, radius, true, 0);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t radius = BENCH_DEFAULT_RADIUS;
+    size_t defaultSizes[] = { 1000000, 10000000 };
+
+    if (argc > 1)
+    {
+        radius = strtoul(argv[1], NULL, 10);
+    }
+
+    if (argc > 2)
+    {
+        for (int i = 2; i < argc; i++)
+        {
+            RET_ERR(!benchSize(strtoul(argv[i], NULL, 10), radius));
+        }
+        return 0;
+    }
+
+    for (size_t i = 0; i < sizeof(defaultSizes) / sizeof(defaultSizes[0]); i++)
+    {
+        RET_ERR(!benchSize(defaultSizes[i], radius));
+    }
+    return 0;
+
+error:
+    return 1;
+}
@@ -0,0 +1,664 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <x86intrin.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include "image_resize.h"
+#include "utils.h"
+
+/*
+** Benchmark of resize kernels, bitmap I/O and average hashes on synthetic images
+** Usage: bench-resize [-q] [-n] [-r reps] [-t seconds] [-j file.json]
+**
+** Every resize of the geometry matrix runs with the kernel of every SIMD level up to cpuSimdLevel(),
+** levels sharing the primitives of a lower one are skipped. Plans and destination images are created
+** outside of the timed region. Load, save and hashes run with the dispatched kernels only.
+** MPix/s counts destination pixels of resizes and source pixels otherwise, cycles are TSC ticks.
+**
+** Hardware counters of the benchmark thread are read with perf_event_open around all timed
+** repetitions of a measurement and reported per pixel, user space only. Counters the kernel or the
+** CPU does not permit are reported as "-", the benchmark runs without them (-n turns all off).
+*/
+
+#define BENCH_MIN_REPS          5
+#define BENCH_MAX_REPS          1000
+#define BENCH_MIN_SECONDS       0.1
+#define BENCH_MAX_RESULTS       1024
+
+/* Measured operations */
+typedef enum
+{
+    BENCH_OP_BILINEAR,                  ///< float plan, imgResizeWithPlan
+    BENCH_OP_FIXED,                     ///< fixed-point plan, imgResizeFixedWithPlan
+    BENCH_OP_RATIO,                     ///< integer ratio fast path of imgResize
+    BENCH_OP_AREA,                      ///< imgResizeArea
+    BENCH_OP_BICUBIC,                   ///< imgResizeFilter, IMG_FILTER_BICUBIC
+    BENCH_OP_LANCZOS3,                  ///< imgResizeFilter, IMG_FILTER_LANCZOS3
+    BENCH_OP_RESIZE_COUNT,
+    BENCH_OP_LOAD = BENCH_OP_RESIZE_COUNT,
+    BENCH_OP_SAVE,
+    BENCH_OP_AVG_HASH,
+    BENCH_OP_AVG_HASH_FUSED,
+    BENCH_OP_COUNT
+} bench_op_t;
+
+static const char *benchOpNames[BENCH_OP_COUNT] =
+{
+    "bilinear", "fixed", "ratio", "area", "bicubic", "lanczos3", "load", "save", "avghash", "avghash-f"
+};
+
+/* Hardware counters */
+typedef enum
+{
+    BENCH_PERF_CYCLES,
+    BENCH_PERF_INSTRUCTIONS,
+    BENCH_PERF_L1D_MISSES,              ///< L1 data cache read misses
+    BENCH_PERF_LLC_MISSES,              ///< last level cache misses
+    BENCH_PERF_BRANCH_MISSES,
+    BENCH_PERF_DTLB_MISSES,             ///< data TLB read misses
+    BENCH_PERF_COUNT
+} bench_perf_t;
+
+/* Event of a hardware counter */
+typedef struct
+{
+    const char  *name;                  ///< table header and JSON key
+    uint32_t    type;
+    uint64_t    config;
+} bench_perf_event_t;
+
+#define BENCH_PERF_READ_MISS(cache) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static const bench_perf_event_t benchPerfEvents[BENCH_PERF_COUNT] =
+{
+    [BENCH_PERF_CYCLES]         = { "coreCycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    [BENCH_PERF_INSTRUCTIONS]   = { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    [BENCH_PERF_L1D_MISSES]     = { "l1dMisses", PERF_TYPE_HW_CACHE, BENCH_PERF_READ_MISS(PERF_COUNT_HW_CACHE_L1D) },
+    [BENCH_PERF_LLC_MISSES]     = { "llcMisses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    [BENCH_PERF_BRANCH_MISSES]  = { "branchMisses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    [BENCH_PERF_DTLB_MISSES]    = { "dtlbMisses", PERF_TYPE_HW_CACHE, BENCH_PERF_READ_MISS(PERF_COUNT_HW_CACHE_DTLB) },
+};
+
+/* Source sizes and scales of the resize matrix, scales are num / den */
+static const size_t benchSources[][2] = { { 640, 480 }, { 1920, 1080 }, { 3840, 2160 } };
+static const size_t benchScales[][2] = { { 2, 1 }, { 3, 2 }, { 1, 2 }, { 1, 4 }, { 3, 10 } };
+
+/* State of a single measured operation */
+typedef struct
+{
+    bench_op_t              op;
+    const resize_kernel_t   *kernel;
+    const image_t           *img;
+    image_t                 *newImg;
+    img_resize_plan_t       *plan;
+    resize_area_plan_t      *areaPlan;
+    resize_filter_plan_t    *filterPlan;
+    const char              *bmpFile;
+} bench_ctx_t;
+
+/* Medians of a measurement */
+typedef struct
+{
+    bench_op_t  op;
+    const char  *level;
+    size_t      width;
+    size_t      height;
+    size_t      newWidth;
+    size_t      newHeight;
+    size_t      reps;
+    double      mpixPerSec;
+    double      cyclesPerPixel;
+    double      perfPerPixel[BENCH_PERF_COUNT];     ///< NAN if the counter is not available
+} bench_result_t;
+
+static bench_result_t   benchResults[BENCH_MAX_RESULTS];
+static size_t           benchNResults = 0;
+static size_t           benchMinReps = BENCH_MIN_REPS;
+static double           benchMinSeconds = BENCH_MIN_SECONDS;
+static int              benchPerfFds[BENCH_PERF_COUNT];
+static size_t           benchPerfNOpen = 0;
+
+static double benchNow(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int benchCompareDoubles(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double benchMedian(double *values, size_t n)
+{
+    qsort(values, n, sizeof(double), benchCompareDoubles);
+    return (n % 2) ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2.0;
+}
+
+/**
+ * Opens all hardware counters of the calling thread, disabled
+ * Counters that cannot be opened are reported once and left out.
+ */
+static void benchPerfOpen(void)
+{
+    int errors[BENCH_PERF_COUNT];
+
+    for (size_t i = 0; i < BENCH_PERF_COUNT; i++)
+    {
+        struct perf_event_attr attr;
+
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = benchPerfEvents[i].type;
+        attr.config = benchPerfEvents[i].config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        /* no glibc wrapper, counts the calling thread on any CPU */
+        benchPerfFds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        errors[i] = (benchPerfFds[i] < 0) ? errno : 0;
+        benchPerfNOpen += (benchPerfFds[i] >= 0);
+    }
+
+    /* e.g. perf_event_paranoid, seccomp or virtual machines without a PMU */
+    if (!benchPerfNOpen)
+    {
+        fprintf(stderr, "hardware counters not available: %s\n", strerror(errors[0]));
+        return;
+    }
+    for (size_t i = 0; i < BENCH_PERF_COUNT; i++)
+    {
+        if (errors[i])
+        {
+            fprintf(stderr, "counter %s not available: %s\n", benchPerfEvents[i].name, strerror(errors[i]));
+        }
+    }
+}
+
+/**
+ * Closes all hardware counters
+ */
+static void benchPerfClose(void)
+{
+    for (size_t i = 0; i < BENCH_PERF_COUNT; i++)
+    {
+        if (benchPerfFds[i] >= 0)
+        {
+            close(benchPerfFds[i]);
+            benchPerfFds[i] = -1;
+        }
+    }
+    benchPerfNOpen = 0;
+}
+
+/**
+ * Zeroes and enables all open counters
+ */
+static void benchPerfStart(void)
+{
+    for (size_t i = 0; i < BENCH_PERF_COUNT; i++)
+    {
+        if (benchPerfFds[i] >= 0)
+        {
+            ioctl(benchPerfFds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(benchPerfFds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+/**
+ * Disables and reads all counters
+ * Counts of multiplexed counters are scaled to the time they were enabled.
+ * @param counts Array to store counts to, NAN for counters that are not available
+ */
+static void benchPerfStop(double counts[BENCH_PERF_COUNT])
+{
+    for (size_t i = 0; i < BENCH_PERF_COUNT; i++)
+    {
+        if (benchPerfFds[i] >= 0)
+        {
+            ioctl(benchPerfFds[i], PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+
+    for (size_t i = 0; i < BENCH_PERF_COUNT; i++)
+    {
+        uint64_t values[3] = { 0, 0, 0 };       // value, time enabled, time running
+
+        counts[i] = NAN;
+        if (benchPerfFds[i] >= 0 && read(benchPerfFds[i], values, sizeof(values)) == sizeof(values) && values[2])
+        {
+            counts[i] = (double)values[0] * ((double)values[1] / (double)values[2]);
+        }
+    }
+}
+
+/**
+ * Prints a counter ratio
+ * @param f Stream to print to
+ * @param value Ratio, NAN if not available
+ * @param json Whether to print a JSON value or a table column
+ */
+static void benchPrintRatio(FILE *f, double value, bool json)
+{
+    if (json)
+    {
+        isnan(value) ? fprintf(f, "null") : fprintf(f, "%.4f", value);
+    }
+    else
+    {
+        isnan(value) ? fprintf(f, " %8s", "-") : fprintf(f, " %8.4f", value);
+    }
+}
+
+/**
+ * Fills an image with gradients and noise, so neither flat areas nor pure noise are measured
+ * @param img Image to fill
+ */
+static void benchFillImage(image_t *img)
+{
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+
+    for (size_t r = 0; r < img->height; r++)
+    {
+        for (size_t c = 0; c < img->width; c++)
+        {
+            /* xorshift64 */
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+
+            uint8_t noise = (uint8_t)(state & 0x1F);
+            imgWriteChannel(img->rChannel, img->stride, r, c, (uint8_t)(c * 255 / img->width) ^ noise);
+            imgWriteChannel(img->gChannel, img->stride, r, c, (uint8_t)(r * 255 / img->height) ^ noise);
+            imgWriteChannel(img->bChannel, img->stride, r, c, (uint8_t)((c + r) * 3) ^ noise);
+        }
+    }
+}
+
+/**
+ * Runs a measured operation once
+ * @param ctx Operation
+ * @return Success flag
+ */
+static bool benchRunOnce(bench_ctx_t *ctx)
+{
+    const image_t   *img = ctx->img;
+    image_t         *newImg = ctx->newImg;
+    image_t         *loaded = NULL;
+    uint64_t        hash = 0;
+
+    switch (ctx->op)
+    {
+    case BENCH_OP_BILINEAR:
+        return resizeBandFloat(ctx->kernel, ctx->plan, img, newImg, 0, newImg->height);
+    case BENCH_OP_FIXED:
+        return resizeBandFixed(ctx->kernel, ctx->plan, img, newImg, 0, newImg->height);
+    case BENCH_OP_RATIO:
+        return resizeBandRatio(ctx->kernel, img, newImg, 0, newImg->height);
+    case BENCH_OP_AREA:
+        return resizeBandArea(ctx->kernel, ctx->areaPlan, img, newImg, 0, newImg->height);
+    case BENCH_OP_BICUBIC:
+    case BENCH_OP_LANCZOS3:
+        return resizeBandFilter(ctx->kernel, ctx->filterPlan, img, newImg, 0, newImg->height);
+    case BENCH_OP_LOAD:
+        RET_ERR(!(loaded = imgLoadBitmap(ctx->bmpFile)));
+        imgDestroy(loaded);
+        return true;
+    case BENCH_OP_SAVE:
+        return imgSaveBitmap(img, ctx->bmpFile);
+    case BENCH_OP_AVG_HASH:
+        return imgAvgHash(img, &hash);
+    case BENCH_OP_AVG_HASH_FUSED:
+        return imgAvgHashFused(img, &hash);
+    default:
+        break;
+    }
+
+error:
+    return false;
+}
+
+/**
+ * Measures an operation and records medians of its repetitions
+ * @param ctx Operation
+ * @param level Name of the SIMD level
+ * @param nPixels Pixels MPix/s and cycles are counted per
+ * @return Success flag
+ */
+static bool benchMeasure(bench_ctx_t *ctx, const char *level, size_t nPixels)
+{
+    double          seconds[BENCH_MAX_REPS];
+    double          cycles[BENCH_MAX_REPS];
+    double          counts[BENCH_PERF_COUNT];
+    double          start = 0.0;
+    size_t          reps = 0;
+    bench_result_t  *res = NULL;
+
+    RET_ERR_MSG(benchNResults >= BENCH_MAX_RESULTS, "Too many results\n");
+
+    /* warmup faults in destinations and fills caches and branch predictors */
+    RET_ERR(!benchRunOnce(ctx));
+
+    /* counters sum all repetitions, a syscall per repetition would be measured as well */
+    benchPerfStart();
+    start = benchNow();
+    while (reps < BENCH_MAX_REPS && (reps < benchMinReps || benchNow() - start < benchMinSeconds))
+    {
+        double      t0 = benchNow();
+        uint64_t    c0 = __rdtsc();
+
+        RET_ERR(!benchRunOnce(ctx));
+
+        cycles[reps] = (double)(__rdtsc() - c0);
+        seconds[reps] = benchNow() - t0;
+        reps++;
+    }
+    benchPerfStop(counts);
+
+    res = &benchResults[benchNResults++];
+    res->op = ctx->op;
+    res->level = level;
+    res->width = ctx->img->width;
+    res->height = ctx->img->height;
+    res->newWidth = ctx->newImg ? ctx->newImg->width : 0;
+    res->newHeight = ctx->newImg ? ctx->newImg->height : 0;
+    res->reps = reps;
+    res->mpixPerSec = nPixels / benchMedian(seconds, reps) * 1e-6;
+    res->cyclesPerPixel = benchMedian(cycles, reps) / nPixels;
+    for (size_t i = 0; i < BENCH_PERF_COUNT; i++)
+    {
+        res->perfPerPixel[i] = counts[i] / ((double)reps * nPixels);
+    }
+
+    printf("%-10s %-7s %5zux%-5zu", benchOpNames[res->op], res->level, res->width, res->height);
+    if (ctx->newImg)
+    {
+        printf(" %5zux%-5zu", res->newWidth, res->newHeight);
+    }
+    else
+    {
+        printf(" %11s", "-");
+    }
+    printf(" %10.1f %9.2f %6zu", res->mpixPerSec, res->cyclesPerPixel, res->reps);
+    if (benchPerfNOpen)
+    {
+        benchPrintRatio(stdout, res->perfPerPixel[BENCH_PERF_INSTRUCTIONS] / res->perfPerPixel[BENCH_PERF_CYCLES],
+                        false);
+        for (size_t i = 0; i < BENCH_PERF_COUNT; i++)
+        {
+            benchPrintRatio(stdout, res->perfPerPixel[i], false);
+        }
+    }
+    printf("\n");
+    fflush(stdout);
+    return true;
+
+error:
+    fprintf(stderr, "%s failed\n", benchOpNames[ctx->op]);
+    return false;
+}
+
+/**
+ * Checks whether a level runs the same primitives as the level below for an operation
+ * @param op Resize operation
+ * @param kernel Kernel of the level
+ * @param lower Kernel of the level below
+ * @return Whether the measurement would repeat the lower one
+ */
+static bool benchSameKernel(bench_op_t op, const resize_kernel_t *kernel, const resize_kernel_t *lower)
+{
+    switch (op)
+    {
+    case BENCH_OP_BILINEAR:
+        return kernel->horizontalFloat == lower->horizontalFloat && kernel->verticalFloat == lower->verticalFloat;
+    case BENCH_OP_FIXED:
+        return kernel->horizontalFixed == lower->horizontalFixed && kernel->verticalFixed == lower->verticalFixed;
+    case BENCH_OP_RATIO:
+        return kernel->downscaleRatio == lower->downscaleRatio && kernel->upscaleRatio == lower->upscaleRatio;
+    case BENCH_OP_AREA:
+        return kernel->verticalArea == lower->verticalArea && kernel->verticalAreaSplit == lower->verticalAreaSplit;
+    default:
+        return kernel->horizontalFilter == lower->horizontalFilter && kernel->verticalFilter == lower->verticalFilter;
+    }
+}
+
+/**
+ * Measures all resizes of a geometry with all levels
+ * @param img Source image
+ * @param newWidth Destination width
+ * @param newHeight Destination height
+ * @return Success flag
+ */
+static bool benchResizeGeometry(const image_t *img, size_t newWidth, size_t newHeight)
+{
+    bench_ctx_t ctx;
+
+    memset(&ctx, 0, sizeof(bench_ctx_t));
+    ctx.img = img;
+    RET_ERR_MSG(!(ctx.newImg = imgCreate(newWidth, newHeight)), "Allocation error\n");
+    RET_ERR(!(ctx.plan = imgResizePlanCreate(img->width, img->height, newWidth, newHeight)));
+    RET_ERR(!(ctx.filterPlan = resizeFilterPlanCreate(img->width, img->height, newWidth, newHeight,
+                                                      IMG_FILTER_BICUBIC)));
+
+    for (bench_op_t op = 0; op < BENCH_OP_RESIZE_COUNT; op++)
+    {
+        ctx.op = op;
+
+        /* operations limited to some geometries */
+        if (op == BENCH_OP_RATIO && !resizeRatioLog2(img->width, img->height, newWidth, newHeight))
+        {
+            continue;
+        }
+        if (op == BENCH_OP_AREA)
+        {
+            if (newWidth > img->width || newHeight > img->height)
+            {
+                continue;
+            }
+            RET_ERR(!(ctx.areaPlan = resizeAreaPlanCreate(img->width, img->height, newWidth, newHeight)));
+        }
+        if (op == BENCH_OP_LANCZOS3)
+        {
+            resizeFilterPlanDestroy(ctx.filterPlan);
+            RET_ERR(!(ctx.filterPlan = resizeFilterPlanCreate(img->width, img->height, newWidth, newHeight,
+                                                              IMG_FILTER_LANCZOS3)));
+        }
+
+        for (simd_level_t level = SIMD_LEVEL_SCALAR; level <= cpuSimdLevel(); level++)
+        {
+            ctx.kernel = resizeKernelForLevel(level);
+            if (level > SIMD_LEVEL_SCALAR && benchSameKernel(op, ctx.kernel, resizeKernelForLevel(level - 1)))
+            {
+                continue;
+            }
+
+            RET_ERR(!benchMeasure(&ctx, cpuSimdLevelName(level), newWidth * newHeight));
+        }
+    }
+
+    resizeAreaPlanDestroy(ctx.areaPlan);
+    resizeFilterPlanDestroy(ctx.filterPlan);
+    imgResizePlanDestroy(ctx.plan);
+    imgDestroy(ctx.newImg);
+    return true;
+
+error:
+    resizeAreaPlanDestroy(ctx.areaPlan);
+    resizeFilterPlanDestroy(ctx.filterPlan);
+    imgResizePlanDestroy(ctx.plan);
+    if (ctx.newImg) { imgDestroy(ctx.newImg); }
+    return false;
+}
+
+/**
+ * Measures bitmap I/O and hashes of an image with the dispatched kernels
+ * @param img Source image
+ * @param bmpFile Scratch bitmap file
+ * @return Success flag
+ */
+static bool benchImageOps(const image_t *img, const char *bmpFile)
+{
+    bench_ctx_t ctx;
+
+    memset(&ctx, 0, sizeof(bench_ctx_t));
+    ctx.img = img;
+    ctx.bmpFile = bmpFile;
+
+    /* saving first leaves the file to load */
+    const bench_op_t ops[] = { BENCH_OP_SAVE, BENCH_OP_LOAD, BENCH_OP_AVG_HASH, BENCH_OP_AVG_HASH_FUSED };
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++)
+    {
+        ctx.op = ops[i];
+        RET_ERR(!benchMeasure(&ctx, cpuSimdLevelName(cpuSimdLevel()), img->width * img->height));
+    }
+    return true;
+
+error:
+    return false;
+}
+
+/**
+ * Writes all results as a JSON array
+ * @param jsonFile File to write to
+ * @return Success flag
+ */
+static bool benchWriteJson(const char *jsonFile)
+{
+    FILE *f = NULL;
+
+    RET_ERR(!(f = fopen(jsonFile, "w")));
+
+    fprintf(f, "[\n");
+    for (size_t i = 0; i < benchNResults; i++)
+    {
+        const bench_result_t *res = &benchResults[i];
+
+        fprintf(f, "  {\"op\": \"%s\", \"kernel\": \"%s\", \"width\": %zu, \"height\": %zu, "
+                   "\"newWidth\": %zu, \"newHeight\": %zu, \"reps\": %zu, \"mpixPerSec\": %.3f, "
+                   "\"cyclesPerPixel\": %.4f, \"ipc\": ",
+                benchOpNames[res->op], res->level, res->width, res->height, res->newWidth, res->newHeight,
+                res->reps, res->mpixPerSec, res->cyclesPerPixel);
+        benchPrintRatio(f, res->perfPerPixel[BENCH_PERF_INSTRUCTIONS] / res->perfPerPixel[BENCH_PERF_CYCLES], true);
+
+        /* counters per pixel */
+        for (size_t p = 0; p < BENCH_PERF_COUNT; p++)
+        {
+            fprintf(f, ", \"%sPerPixel\": ", benchPerfEvents[p].name);
+            benchPrintRatio(f, res->perfPerPixel[p], true);
+        }
+        fprintf(f, "}%s\n", (i + 1 < benchNResults) ? "," : "");
+    }
+    fprintf(f, "]\n");
+
+    RET_ERR(fclose(f));
+    return true;
+
+error:
+    fprintf(stderr, "Failed to write %s\n", jsonFile);
+    return false;
+}
+
+int main(int argc, char *argv[])
+{
+    const char  *jsonFile = NULL;
+    size_t      nSources = sizeof(benchSources) / sizeof(benchSources[0]);
+    char        bmpFile[] = "/tmp/bench-resize-XXXXXX";
+    int         fd = -1;
+    image_t     *img = NULL;
+    bool        perf = true;
+    int         opt;
+
+    while ((opt = getopt(argc, argv, "qnr:t:j:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'q':
+            nSources = 1;
+            break;
+        case 'n':
+            perf = false;
+            break;
+        case 'r':
+            benchMinReps = strtoul(optarg, NULL, 10);
+            benchMinReps = (benchMinReps < 1) ? 1 : (benchMinReps > BENCH_MAX_REPS) ? BENCH_MAX_REPS : benchMinReps;
+            break;
+        case 't':
+            benchMinSeconds = strtod(optarg, NULL);
+            break;
+        case 'j':
+            jsonFile = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-q] [-n] [-r reps] [-t seconds] [-j file.json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    for (size_t i = 0; i < BENCH_PERF_COUNT; i++)
+    {
+        benchPerfFds[i] = -1;
+    }
+    if (perf)
+    {
+        benchPerfOpen();
+    }
+
+    RET_ERR_MSG((fd = mkstemp(bmpFile)) < 0, "Failed to create a scratch file\n");
+    close(fd);
+
+    printf("kernels up to %s, median of at least %zu reps and %.2f s\n",
+           cpuSimdLevelName(cpuSimdLevel()), benchMinReps, benchMinSeconds);
+    printf("%-10s %-7s %11s %11s %10s %9s %6s", "op", "kernel", "source", "dest", "MPix/s", "cyc/px", "reps");
+    if (benchPerfNOpen)
+    {
+        printf(" %8s %8s %8s %8s %8s %8s %8s", "IPC", "clk/px", "ins/px", "L1m/px", "LLCm/px", "brm/px", "TLBm/px");
+    }
+    printf("\n");
+
+    for (size_t s = 0; s < nSources; s++)
+    {
+        RET_ERR_MSG(!(img = imgCreate(benchSources[s][0], benchSources[s][1])), "Allocation error\n");
+        benchFillImage(img);
+
+        for (size_t i = 0; i < sizeof(benchScales) / sizeof(benchScales[0]); i++)
+        {
+            RET_ERR(!benchResizeGeometry(img, img->width * benchScales[i][0] / benchScales[i][1],
+                                         img->height * benchScales[i][0] / benchScales[i][1]));
+        }
+        RET_ERR(!benchImageOps(img, bmpFile));
+
+        imgDestroy(img);
+        img = NULL;
+    }
+
+    if (jsonFile)
+    {
+        RET_ERR(!benchWriteJson(jsonFile));
+    }
+
+    unlink(bmpFile);
+    benchPerfClose();
+    return 0;
+
+error:
+    benchPerfClose();
+    if (img) { imgDestroy(img); }
+    if (fd >= 0) { unlink(bmpFile); }
+    return 1;
+}
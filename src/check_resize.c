@@ -0,0 +1,611 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "image_resize.h"
+#include "resize_fixed.h"
+#include "utils.h"
+
+/*
+** Bit-exactness check of resize kernels and paths on random geometries
+** Usage: check-resize [-n geometries] [-s seed]
+**
+** imgResizeFixed and the fixed-point band must equal the formulas of resize_fixed.h evaluated pixel
+** by pixel. Every level up to cpuSimdLevel() runs the float, fixed-point, area, bicubic, Lanczos-3
+** and integer ratio bands, results must equal the scalar kernel byte for byte. Paths built on the
+** dispatched kernel must equal the general float band of the same kernel: imgResize (integer ratio
+** fast paths), imgResizeParallel, imgResizePyramid, imgResizePacked and imgResizeBitmapFile. make
+** check runs it once per IMG_KERNEL level, so every path is checked with every kernel the CPU
+** supports. Sources and padding are random, results must not depend on bytes past the row ends.
+*/
+
+#define CHECK_GEOMETRIES        200
+#define CHECK_MAX_LEN           300
+#define CHECK_MAX_NEW_LEN       400
+#define CHECK_PYRAMID_SIZES     3
+
+/* Band operations compared across kernels */
+typedef enum
+{
+    CHECK_OP_FLOAT,
+    CHECK_OP_FIXED,
+    CHECK_OP_AREA,
+    CHECK_OP_BICUBIC,
+    CHECK_OP_LANCZOS3,
+    CHECK_OP_RATIO,
+    CHECK_OP_COUNT
+} check_op_t;
+
+static const char *checkOpNames[CHECK_OP_COUNT] = { "float", "fixed", "area", "bicubic", "lanczos3", "ratio" };
+
+static uint64_t checkState = 0x9E3779B97F4A7C15ull;
+static size_t   checkNFailed = 0;
+
+/**
+ * Next pseudo-random number, xorshift64
+ * @return Random number
+ */
+static uint64_t checkRand(void)
+{
+    checkState ^= checkState >> 12;
+    checkState ^= checkState << 25;
+    checkState ^= checkState >> 27;
+    return checkState * 0x2545F4914F6CDD1Dull;
+}
+
+/**
+ * Random number of a range
+ * @param min Minimum
+ * @param max Maximum, inclusive
+ * @return Random number
+ */
+static size_t checkRange(size_t min, size_t max)
+{
+    return min + checkRand() % (max - min + 1);
+}
+
+/**
+ * Fills channels of an image including the padding of its rows with random bytes
+ * @param img Image
+ */
+static void checkFillImage(image_t *img)
+{
+    uint8_t *channels[3] = { img->rChannel, img->gChannel, img->bChannel };
+
+    for (size_t ch = 0; ch < 3; ch++)
+    {
+        for (size_t i = 0; i < img->height * img->stride; i++)
+        {
+            channels[ch][i] = (uint8_t)checkRand();
+        }
+    }
+}
+
+/**
+ * Creates an image of random pixels
+ * @param width Width
+ * @param height Height
+ * @return New image or NULL on error
+ */
+static image_t *checkCreateImage(size_t width, size_t height)
+{
+    image_t *img = imgCreate(width, height);
+
+    if (img)
+    {
+        checkFillImage(img);
+    }
+    return img;
+}
+
+/**
+ * Compares pixels of two images and reports the first difference
+ * @param what Name of the compared result
+ * @param level Name of the kernel
+ * @param src Source image of both results
+ * @param expected Expected image
+ * @param img Image to check, NULL if it failed to be created
+ * @return True if the images are identical
+ */
+static bool checkSame(const char *what, const char *level, const image_t *src, const image_t *expected,
+                      const image_t *img)
+{
+    const uint8_t *expChannels[3] = { expected->rChannel, expected->gChannel, expected->bChannel };
+
+    if (!img || img->width != expected->width || img->height != expected->height)
+    {
+        printf("FAIL %-9s %-7s %zux%zu -> %zux%zu: no result\n", what, level, src->width, src->height,
+               expected->width, expected->height);
+        checkNFailed++;
+        return false;
+    }
+
+    const uint8_t *channels[3] = { img->rChannel, img->gChannel, img->bChannel };
+
+    for (size_t ch = 0; ch < 3; ch++)
+    {
+        for (size_t r = 0; r < img->height; r++)
+        {
+            for (size_t c = 0; c < img->width; c++)
+            {
+                uint8_t e = imgReadChannel(expChannels[ch], expected->stride, r, c);
+                uint8_t v = imgReadChannel(channels[ch], img->stride, r, c);
+
+                if (e != v)
+                {
+                    printf("FAIL %-9s %-7s %zux%zu -> %zux%zu: channel %zu row %zu column %zu is %u, expected %u\n",
+                           what, level, src->width, src->height, img->width, img->height, ch, r, c, v, e);
+                    checkNFailed++;
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Runs a band operation over all new rows with a kernel
+ * @param op Operation
+ * @param kernel Kernel
+ * @param img Source image
+ * @param newWidth Width of the result
+ * @param newHeight Height of the result
+ * @return New image or NULL on error
+ */
+static image_t *checkRunBand(check_op_t op, const resize_kernel_t *kernel, const image_t *img, size_t newWidth,
+                             size_t newHeight)
+{
+    img_resize_plan_t       *plan = NULL;
+    resize_area_plan_t      *areaPlan = NULL;
+    resize_filter_plan_t    *filterPlan = NULL;
+    image_t                 *newImg = NULL;
+    bool                    ok = false;
+
+    RET_ERR_MSG(!(newImg = imgCreate(newWidth, newHeight)), "Allocation error\n");
+    checkFillImage(newImg);
+
+    switch (op)
+    {
+    case CHECK_OP_FLOAT:
+    case CHECK_OP_FIXED:
+        RET_ERR(!(plan = imgResizePlanCreate(img->width, img->height, newWidth, newHeight)));
+        ok = (op == CHECK_OP_FLOAT) ? resizeBandFloat(kernel, plan, img, newImg, 0, newHeight)
+                                    : resizeBandFixed(kernel, plan, img, newImg, 0, newHeight);
+        break;
+    case CHECK_OP_AREA:
+        RET_ERR(!(areaPlan = resizeAreaPlanCreate(img->width, img->height, newWidth, newHeight)));
+        ok = resizeBandArea(kernel, areaPlan, img, newImg, 0, newHeight);
+        break;
+    case CHECK_OP_BICUBIC:
+    case CHECK_OP_LANCZOS3:
+        RET_ERR(!(filterPlan = resizeFilterPlanCreate(img->width, img->height, newWidth, newHeight,
+                                                      (op == CHECK_OP_BICUBIC) ? IMG_FILTER_BICUBIC
+                                                                               : IMG_FILTER_LANCZOS3)));
+        ok = resizeBandFilter(kernel, filterPlan, img, newImg, 0, newHeight);
+        break;
+    default:
+        ok = resizeBandRatio(kernel, img, newImg, 0, newHeight);
+        break;
+    }
+    RET_ERR(!ok);
+
+    imgResizePlanDestroy(plan);
+    resizeAreaPlanDestroy(areaPlan);
+    resizeFilterPlanDestroy(filterPlan);
+    return newImg;
+
+error:
+    imgResizePlanDestroy(plan);
+    resizeAreaPlanDestroy(areaPlan);
+    resizeFilterPlanDestroy(filterPlan);
+    if (newImg) { imgDestroy(newImg); }
+    return NULL;
+}
+
+/**
+ * Compares a band operation of every kernel up to the dispatched one with the scalar kernel
+ * @param op Operation
+ * @param img Source image
+ * @param newWidth Width of the result
+ * @param newHeight Height of the result
+ * @return False on errors other than differences
+ */
+static bool checkKernels(check_op_t op, const image_t *img, size_t newWidth, size_t newHeight)
+{
+    image_t *expected = NULL;
+
+    RET_ERR_MSG(!(expected = checkRunBand(op, resizeKernelForLevel(SIMD_LEVEL_SCALAR), img, newWidth, newHeight)),
+                "Failed to run the scalar kernel\n");
+
+    for (simd_level_t level = SIMD_LEVEL_SCALAR + 1; level <= cpuSimdLevel(); level++)
+    {
+        image_t *newImg = checkRunBand(op, resizeKernelForLevel(level), img, newWidth, newHeight);
+
+        checkSame(checkOpNames[op], cpuSimdLevelName(level), img, expected, newImg);
+        if (newImg) { imgDestroy(newImg); }
+    }
+
+    imgDestroy(expected);
+    return true;
+
+error:
+    return false;
+}
+
+/**
+ * Resizes with the fixed-point formulas of resize_fixed.h, pixel by pixel
+ * @param img Source image
+ * @param newWidth Width of the result
+ * @param newHeight Height of the result
+ * @return New image or NULL on error
+ */
+static image_t *checkFixedReference(const image_t *img, size_t newWidth, size_t newHeight)
+{
+    const uint8_t   *channels[3] = { img->rChannel, img->gChannel, img->bChannel };
+    image_t         *newImg = imgCreate(newWidth, newHeight);
+
+    if (!newImg)
+    {
+        return NULL;
+    }
+
+    uint8_t *newChannels[3] = { newImg->rChannel, newImg->gChannel, newImg->bChannel };
+
+    for (size_t rNew = 0; rNew < newHeight; rNew++)
+    {
+        size_t  r0 = 0;
+        size_t  r1 = 0;
+        uint8_t fy = 0;
+
+        /* beyond the last pair of rows the last row is held */
+        resizeFixedMap(img->height, newHeight, rNew, &r0, &fy);
+        r1 = r0 + 1;
+        r0 = (fy == RESIZE_FIXED_ONE) ? r1 : r0;
+        fy = (fy == RESIZE_FIXED_ONE) ? 0 : fy;
+
+        for (size_t cNew = 0; cNew < newWidth; cNew++)
+        {
+            size_t  c = 0;
+            uint8_t fx = 0;
+
+            resizeFixedMap(img->width, newWidth, cNew, &c, &fx);
+            for (size_t ch = 0; ch < 3; ch++)
+            {
+                uint16_t h0 = resizeFixedHorizontal(&imgReadChannel(channels[ch], img->stride, r0, 0), c, fx);
+                uint16_t h1 = resizeFixedHorizontal(&imgReadChannel(channels[ch], img->stride, r1, 0), c, fx);
+
+                imgWriteChannel(newChannels[ch], newImg->stride, rNew, cNew, resizeFixedVertical(h0, h1, fy));
+            }
+        }
+    }
+
+    return newImg;
+}
+
+/**
+ * Compares imgResizeFixed and the fixed-point band of the dispatched kernel with the fixed-point formulas
+ * @param img Source image
+ * @param newWidth Width of the result
+ * @param newHeight Height of the result
+ * @return False on errors other than differences
+ */
+static bool checkFixed(const image_t *img, size_t newWidth, size_t newHeight)
+{
+    const char  *level = cpuSimdLevelName(cpuSimdLevel());
+    image_t     *expected = NULL;
+    image_t     *newImg = NULL;
+
+    RET_ERR_MSG(!(expected = checkFixedReference(img, newWidth, newHeight)), "Allocation error\n");
+
+    newImg = imgResizeFixed(img, newWidth, newHeight);
+    checkSame("reference", level, img, expected, newImg);
+    if (newImg) { imgDestroy(newImg); }
+
+    newImg = checkRunBand(CHECK_OP_FIXED, resizeKernel(), img, newWidth, newHeight);
+    checkSame("fixedband", level, img, expected, newImg);
+    if (newImg) { imgDestroy(newImg); }
+
+    imgDestroy(expected);
+    return true;
+
+error:
+    return false;
+}
+
+/**
+ * Packs channels of a planar image, a 4th channel repeats the red one shifted by one column
+ * @param img Planar image
+ * @param nChannels Channels per pixel, 3 or 4
+ * @return New packed image or NULL on error
+ */
+static packed_image_t *checkPack(const image_t *img, size_t nChannels)
+{
+    packed_image_t *packed = packedImgCreate(img->width, img->height, nChannels);
+
+    if (!packed)
+    {
+        return NULL;
+    }
+
+    for (size_t r = 0; r < img->height; r++)
+    {
+        uint8_t *pixel = &packed->pixels[r * packed->stride];
+
+        for (size_t c = 0; c < img->width; c++, pixel += nChannels)
+        {
+            pixel[0] = imgReadChannel(img->rChannel, img->stride, r, c);
+            pixel[1] = imgReadChannel(img->gChannel, img->stride, r, c);
+            pixel[2] = imgReadChannel(img->bChannel, img->stride, r, c);
+            if (nChannels == 4)
+            {
+                pixel[3] = imgReadChannel(img->rChannel, img->stride, r, (c + 1) % img->width);
+            }
+        }
+    }
+
+    return packed;
+}
+
+/**
+ * Unpacks three channels of a packed image, starting at a channel
+ * @param packed Packed image
+ * @param first First channel to unpack
+ * @return New planar image or NULL on error
+ */
+static image_t *checkUnpack(const packed_image_t *packed, size_t first)
+{
+    image_t *img = imgCreate(packed->width, packed->height);
+
+    if (!img)
+    {
+        return NULL;
+    }
+
+    for (size_t r = 0; r < img->height; r++)
+    {
+        const uint8_t *pixel = &packed->pixels[r * packed->stride];
+
+        for (size_t c = 0; c < img->width; c++, pixel += packed->nChannels)
+        {
+            imgWriteChannel(img->rChannel, img->stride, r, c, pixel[first]);
+            imgWriteChannel(img->gChannel, img->stride, r, c, pixel[(first + 1) % packed->nChannels]);
+            imgWriteChannel(img->bChannel, img->stride, r, c, pixel[(first + 2) % packed->nChannels]);
+        }
+    }
+
+    return img;
+}
+
+/**
+ * Compares packed resizes of 3 and 4 channels with planar resizes of the same channels
+ * @param img Source image
+ * @param expected imgResize of img
+ * @param level Name of the dispatched kernel
+ * @return False on errors other than differences
+ */
+static bool checkPacked(const image_t *img, const image_t *expected, const char *level)
+{
+    packed_image_t  *packed = NULL;
+    packed_image_t  *newPacked = NULL;
+    image_t         *planar = NULL;
+    image_t         *newImg = NULL;
+    image_t         *unpacked = NULL;
+
+    for (size_t nChannels = 3; nChannels <= 4; nChannels++)
+    {
+        RET_ERR_MSG(!(packed = checkPack(img, nChannels)), "Allocation error\n");
+        if ((newPacked = imgResizePacked(packed, expected->width, expected->height)))
+        {
+            RET_ERR_MSG(!(unpacked = checkUnpack(newPacked, 0)), "Allocation error\n");
+        }
+        checkSame(nChannels == 3 ? "packed3" : "packed4", level, img, expected, unpacked);
+        if (unpacked) { imgDestroy(unpacked); }
+        unpacked = NULL;
+
+        /* alpha is checked as a channel of a planar image of channels 1 .. 3 */
+        if (newPacked && nChannels == 4)
+        {
+            RET_ERR_MSG(!(planar = checkUnpack(packed, 1)), "Allocation error\n");
+            RET_ERR_MSG(!(newImg = imgResize(planar, expected->width, expected->height)), "Failed to resize\n");
+            RET_ERR_MSG(!(unpacked = checkUnpack(newPacked, 1)), "Allocation error\n");
+            checkSame("packed4", level, img, newImg, unpacked);
+            imgDestroy(unpacked);
+            imgDestroy(newImg);
+            imgDestroy(planar);
+            unpacked = newImg = planar = NULL;
+        }
+
+        if (newPacked) { packedImgDestroy(newPacked); }
+        packedImgDestroy(packed);
+        newPacked = packed = NULL;
+    }
+
+    return true;
+
+error:
+    if (unpacked) { imgDestroy(unpacked); }
+    if (newImg) { imgDestroy(newImg); }
+    if (planar) { imgDestroy(planar); }
+    if (newPacked) { packedImgDestroy(newPacked); }
+    if (packed) { packedImgDestroy(packed); }
+    return false;
+}
+
+/**
+ * Compares paths built on the dispatched kernel with its general float band
+ * @param img Source image
+ * @param newWidth Width of the result
+ * @param newHeight Height of the result
+ * @param bmpFiles Scratch files for the streaming resize, source and destination
+ * @return False on errors other than differences
+ */
+static bool checkPaths(const image_t *img, size_t newWidth, size_t newHeight, char *const bmpFiles[2])
+{
+    const char  *level = cpuSimdLevelName(cpuSimdLevel());
+    size_t      sizes[CHECK_PYRAMID_SIZES][2];
+    image_t     *pyramid[CHECK_PYRAMID_SIZES] = { NULL };
+    image_t     *expected = NULL;
+    image_t     *newImg = NULL;
+
+    RET_ERR_MSG(!(expected = checkRunBand(CHECK_OP_FLOAT, resizeKernel(), img, newWidth, newHeight)),
+                "Failed to run the float band\n");
+
+    newImg = imgResize(img, newWidth, newHeight);
+    checkSame("imgResize", level, img, expected, newImg);
+    if (newImg) { imgDestroy(newImg); }
+
+    newImg = imgResizeParallel(img, newWidth, newHeight);
+    checkSame("parallel", level, img, expected, newImg);
+    if (newImg) { imgDestroy(newImg); }
+    newImg = NULL;
+
+    RET_ERR(!checkPacked(img, expected, level));
+
+    /* the pyramid adds a smaller and a larger size, every size is compared with imgResize */
+    sizes[0][0] = newWidth;
+    sizes[0][1] = newHeight;
+    sizes[1][0] = checkRange(2, CHECK_MAX_NEW_LEN);
+    sizes[1][1] = checkRange(2, CHECK_MAX_NEW_LEN);
+    sizes[2][0] = (newWidth + 2) / 2;
+    sizes[2][1] = (newHeight + 2) / 2;
+    if (imgResizePyramid(img, (const size_t (*)[2])sizes, CHECK_PYRAMID_SIZES, pyramid))
+    {
+        for (size_t l = 0; l < CHECK_PYRAMID_SIZES; l++)
+        {
+            image_t *levelImg = imgResize(img, sizes[l][0], sizes[l][1]);
+
+            RET_ERR_MSG(!levelImg, "Failed to resize\n");
+            checkSame("pyramid", level, img, levelImg, pyramid[l]);
+            imgDestroy(levelImg);
+            imgDestroy(pyramid[l]);
+        }
+    }
+    else
+    {
+        checkSame("pyramid", level, img, expected, NULL);
+    }
+
+    RET_ERR_MSG(!imgSaveBitmap(img, bmpFiles[0]), "Failed to save a scratch bitmap\n");
+    if (imgResizeBitmapFile(bmpFiles[0], bmpFiles[1], newWidth, newHeight))
+    {
+        newImg = imgLoadBitmap(bmpFiles[1]);
+    }
+    checkSame("stream", level, img, expected, newImg);
+    if (newImg) { imgDestroy(newImg); }
+
+    imgDestroy(expected);
+    return true;
+
+error:
+    if (expected) { imgDestroy(expected); }
+    return false;
+}
+
+/**
+ * Checks all kernels and paths on a random geometry
+ * @param bmpFiles Scratch files for the streaming resize
+ * @return False on errors other than differences
+ */
+static bool checkGeometry(char *const bmpFiles[2])
+{
+    size_t  width = checkRange(2, CHECK_MAX_LEN);
+    size_t  height = checkRange(2, CHECK_MAX_LEN);
+    size_t  newWidth = checkRange(2, CHECK_MAX_NEW_LEN);
+    size_t  newHeight = checkRange(2, CHECK_MAX_NEW_LEN);
+    image_t *img = NULL;
+
+    RET_ERR_MSG(!(img = checkCreateImage(width, height)), "Allocation error\n");
+
+    RET_ERR(!checkFixed(img, newWidth, newHeight));
+    RET_ERR(!checkKernels(CHECK_OP_FLOAT, img, newWidth, newHeight));
+    RET_ERR(!checkKernels(CHECK_OP_FIXED, img, newWidth, newHeight));
+    RET_ERR(!checkKernels(CHECK_OP_BICUBIC, img, newWidth, newHeight));
+    RET_ERR(!checkKernels(CHECK_OP_LANCZOS3, img, newWidth, newHeight));
+    RET_ERR(!checkKernels(CHECK_OP_AREA, img, checkRange(1, width), checkRange(1, height)));
+    RET_ERR(!checkPaths(img, newWidth, newHeight, bmpFiles));
+    imgDestroy(img);
+
+    /* integer ratios need matching dimensions, the source is resized by 1/4, 1/2, 2 or 4 */
+    int     factorLog2 = (int)checkRange(0, 3) - 2;
+    size_t  len = CHECK_MAX_LEN >> 2;
+
+    factorLog2 = (factorLog2 >= 0) ? factorLog2 + 1 : factorLog2;
+    width = checkRange(2, len);
+    height = checkRange(2, len);
+    newWidth = (factorLog2 > 0) ? width << factorLog2 : width;
+    newHeight = (factorLog2 > 0) ? height << factorLog2 : height;
+    width = (factorLog2 > 0) ? width : width << -factorLog2;
+    height = (factorLog2 > 0) ? height : height << -factorLog2;
+
+    RET_ERR_MSG(!(img = checkCreateImage(width, height)), "Allocation error\n");
+    RET_ERR(!checkKernels(CHECK_OP_RATIO, img, newWidth, newHeight));
+    RET_ERR(!checkPaths(img, newWidth, newHeight, bmpFiles));
+    imgDestroy(img);
+
+    return true;
+
+error:
+    if (img) { imgDestroy(img); }
+    return false;
+}
+
+int main(int argc, char *argv[])
+{
+    char    srcFile[] = "/tmp/check-resize-XXXXXX";
+    char    dstFile[] = "/tmp/check-resize-XXXXXX";
+    char    *bmpFiles[2] = { srcFile, dstFile };
+    size_t  nGeometries = CHECK_GEOMETRIES;
+    int     fds[2] = { -1, -1 };
+    bool    ok = true;
+    int     opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            nGeometries = strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            checkState = strtoull(optarg, NULL, 0) | 1;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-n geometries] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* a level above the CPU falls back to the detected one, which has its own run */
+    const char *forced = getenv(CPU_DISPATCH_ENV);
+    if (forced && *forced && strcmp(forced, cpuSimdLevelName(cpuSimdLevel())))
+    {
+        printf("%s=%s skipped\n", CPU_DISPATCH_ENV, forced);
+        return 0;
+    }
+
+    RET_ERR_MSG((fds[0] = mkstemp(srcFile)) < 0, "Failed to create a scratch file\n");
+    RET_ERR_MSG((fds[1] = mkstemp(dstFile)) < 0, "Failed to create a scratch file\n");
+
+    for (size_t i = 0; ok && i < nGeometries; i++)
+    {
+        ok = checkGeometry(bmpFiles);
+    }
+
+    printf("%s: %zu geometries, kernels up to %s, %zu differences\n", (ok && !checkNFailed) ? "ok" : "FAIL",
+           nGeometries, cpuSimdLevelName(cpuSimdLevel()), checkNFailed);
+
+    close(fds[0]);
+    close(fds[1]);
+    unlink(srcFile);
+    unlink(dstFile);
+    return (ok && !checkNFailed) ? 0 : 1;
+
+error:
+    if (fds[0] >= 0) { close(fds[0]); unlink(srcFile); }
+    if (fds[1] >= 0) { close(fds[1]); unlink(dstFile); }
+    return 1;
+}
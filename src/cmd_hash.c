@@ -0,0 +1,253 @@
+#define _POSIX_C_SOURCE 200809L
+#include <dirent.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "commands.h"
+#include "image.h"
+#include "image_pool.h"
+#include "thread_pool.h"
+
+#define HASH_USAGE          "./image-info hash [-f] [-j threads] [-d directory]... [-] [image]...\n"
+#define HASH_BMP_SUFFIX     ".bmp"
+/* queued images per worker, bounds memory when reading paths from a stream */
+#define HASH_TASKS_PER_THREAD   8
+/* images a task holds at once, the loaded image and its thumbnail, are cached per worker */
+#define HASH_CACHED_PER_THREAD  2
+
+/* State shared by all hashing tasks */
+typedef struct
+{
+    thread_pool_t       *pool;
+    thread_pool_group_t group;
+    size_t              maxPending;
+    bool                fused;          ///< use imgAvgHashFused
+    pthread_mutex_t     outLock;        ///< serializes result lines
+    bool                failed;         ///< any image failed, guarded by outLock
+} hash_batch_t;
+
+/* Single image to hash */
+typedef struct
+{
+    hash_batch_t    *batch;
+    char            *path;
+} hash_task_t;
+
+/**
+ * Thread pool task loading and hashing a single image
+ * @param arg Task
+ */
+static void hashTask(void *arg)
+{
+    hash_task_t     *task = arg;
+    hash_batch_t    *batch = task->batch;
+    image_t         *img = NULL;
+    uint64_t        avgHash = 0x0000000000000000;
+    char            avgHashStr[HEX_PREFIXED_8B_STR_SIZE];
+    bool            ok = false;
+
+    if ((img = imgLoadBitmap(task->path)))
+    {
+        ok = batch->fused ? imgAvgHashFused(img, &avgHash) : imgAvgHash(img, &avgHash);
+        imgDestroy(img);
+    }
+
+    pthread_mutex_lock(&batch->outLock);
+    if (ok)
+    {
+        int64ToHexStr(avgHash, avgHashStr);
+        printf("%s\t%s\n", task->path, avgHashStr);
+        fflush(stdout);
+    }
+    else
+    {
+        fprintf(stderr, "%s: failed to compute average hash\n", task->path);
+        batch->failed = true;
+    }
+    pthread_mutex_unlock(&batch->outLock);
+
+    free(task->path);
+    free(task);
+}
+
+/**
+ * Queues an image, blocks while too many images are queued
+ * @param batch Batch
+ * @param path Image path, copied
+ * @return Success flag
+ */
+static bool hashSubmit(hash_batch_t *batch, const char *path)
+{
+    hash_task_t *task = NULL;
+
+    RET_ERR_MSG(!(task = malloc(sizeof(hash_task_t))), "Allocation error\n");
+    RET_ERR_MSG(!(task->path = strdup(path)), "Allocation error\n");
+    task->batch = batch;
+
+    threadPoolGroupWaitPending(&batch->group, batch->maxPending);
+    RET_ERR(!threadPoolSubmit(batch->pool, &batch->group, hashTask, task));
+    return true;
+
+error:
+    if (task) { free(task->path); free(task); }
+    return false;
+}
+
+/**
+ * Recursively queues all bitmaps of a directory, symbolic links are not followed
+ * @param batch Batch
+ * @param dirPath Directory path
+ * @return Success flag
+ */
+static bool hashSubmitDirectory(hash_batch_t *batch, const char *dirPath)
+{
+    DIR             *dir = NULL;
+    struct dirent   *entry = NULL;
+    char            *path = NULL;
+    size_t          suffixLen = strlen(HASH_BMP_SUFFIX);
+
+    RET_ERR_MSG(!(dir = opendir(dirPath)), "Failed to open directory\n");
+
+    while ((entry = readdir(dir)))
+    {
+        struct stat st;
+        size_t nameLen = strlen(entry->d_name);
+
+        if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+        {
+            continue;
+        }
+
+        RET_ERR_MSG(!(path = malloc(strlen(dirPath) + nameLen + 2)), "Allocation error\n");
+        sprintf(path, "%s/%s", dirPath, entry->d_name);
+
+        if (lstat(path, &st) == 0)
+        {
+            if (S_ISDIR(st.st_mode))
+            {
+                RET_ERR(!hashSubmitDirectory(batch, path));
+            }
+            else if (S_ISREG(st.st_mode) && nameLen >= suffixLen
+                     && !strcasecmp(entry->d_name + nameLen - suffixLen, HASH_BMP_SUFFIX))
+            {
+                RET_ERR(!hashSubmit(batch, path));
+            }
+        }
+
+        free(path);
+        path = NULL;
+    }
+
+    closedir(dir);
+    return true;
+
+error:
+    if (path) { free(path); }
+    if (dir) { closedir(dir); }
+    return false;
+}
+
+/**
+ * Queues newline separated image paths read from a stream
+ * @param batch Batch
+ * @param f Stream to read
+ * @return Success flag
+ */
+static bool hashSubmitStream(hash_batch_t *batch, FILE *f)
+{
+    char    *line = NULL;
+    size_t  lineSize = 0;
+    ssize_t lineLen = 0;
+
+    while ((lineLen = getline(&line, &lineSize, f)) != -1)
+    {
+        if (lineLen > 0 && line[lineLen - 1] == '\n')
+        {
+            line[--lineLen] = '\0';
+        }
+
+        if (lineLen > 0)
+        {
+            RET_ERR(!hashSubmit(batch, line));
+        }
+    }
+
+    free(line);
+    return true;
+
+error:
+    free(line);
+    return false;
+}
+
+int cmdHash(int argc, char *argv[])
+{
+    hash_batch_t    batch;
+    img_pool_t      *imgPool = NULL;
+    bool            groupInit = false;
+    bool            lockInit = false;
+    bool            ok = true;
+    size_t          nThreads = 0;
+    int             opt = 0;
+
+    memset(&batch, 0, sizeof(batch));
+
+    /* first pass parses options only, directories are walked once the pool runs */
+    while ((opt = getopt(argc, argv, "fj:d:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'f':
+                batch.fused = true;
+                break;
+            case 'j':
+                nThreads = strtoul(optarg, NULL, 10);
+                break;
+            case 'd':
+                break;
+            default:
+                RET_ERR_MSG(true, HASH_USAGE);
+        }
+    }
+
+    /* every worker loads and hashes images of similar sizes, their buffers are recycled */
+    RET_ERR_MSG(!(imgPool = imgPoolCreate(0, IMG_POOL_HUGE_PAGES)), "Failed to create image pool\n");
+    imgPoolSetDefault(imgPool);
+
+    RET_ERR_MSG(!(batch.pool = threadPoolCreate(nThreads)), "Failed to start worker threads\n");
+    RET_ERR_MSG(!(groupInit = threadPoolGroupInit(&batch.group)), "Failed to create task group\n");
+    RET_ERR_MSG(!(lockInit = !pthread_mutex_init(&batch.outLock, NULL)), "Failed to create mutex\n");
+    batch.maxPending = batch.pool->nThreads * HASH_TASKS_PER_THREAD;
+    imgPoolSetMaxCachedBuffers(imgPool, batch.pool->nThreads * HASH_CACHED_PER_THREAD);
+
+    optind = 1;
+    while (ok && (opt = getopt(argc, argv, "fj:d:")) != -1)
+    {
+        if (opt == 'd')
+        {
+            ok = hashSubmitDirectory(&batch, optarg);
+        }
+    }
+
+    for (int i = optind; ok && i < argc; i++)
+    {
+        ok = !strcmp(argv[i], "-") ? hashSubmitStream(&batch, stdin) : hashSubmit(&batch, argv[i]);
+    }
+
+    threadPoolGroupWait(&batch.group);
+    threadPoolDestroy(batch.pool);
+    threadPoolGroupDestroy(&batch.group);
+    pthread_mutex_destroy(&batch.outLock);
+    imgPoolSetDefault(NULL);
+    imgPoolDestroy(imgPool);
+
+    return (ok && !batch.failed) ? 0 : 1;
+
+error:
+    if (lockInit) { pthread_mutex_destroy(&batch.outLock); }
+    if (groupInit) { threadPoolGroupDestroy(&batch.group); }
+    if (batch.pool) { threadPoolDestroy(batch.pool); }
+    if (imgPool) { imgPoolSetDefault(NULL); imgPoolDestroy(imgPool); }
+    return 1;
+}
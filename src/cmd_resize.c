@@ -0,0 +1,619 @@
+#define _POSIX_C_SOURCE 200809L
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "commands.h"
+#include "image.h"
+#include "image_pool.h"
+#include "thread_pool.h"
+
+#define RESIZE_USAGE        "./image-info resize [-s WIDTHxHEIGHT] [-j workers] [-l loaders] [-w writers] " \
+                            "[-q depth] [-m manifest]... [-] [src dst]...\n"
+#define RESIZE_LOADERS      2
+#define RESIZE_WRITERS      2
+#define RESIZE_QUEUE_DEPTH  8
+#define RESIZE_MANIFEST_SEP " \t\r\n"
+
+/*
+** Pipelined batch resize
+**
+** Images flow through three stages of threads connected by bounded queues: loaders read and
+** deinterleave bitmaps, workers resize them and writers save the results. A full queue stalls the
+** stage feeding it, so at most (depth + threads) images per stage are in memory. Images are taken
+** from a default image pool, buffers of saved images are reused by later loads and resizes.
+*/
+
+/* Image passing through the pipeline */
+typedef struct
+{
+    char    *src;
+    char    *dst;
+    size_t  newWidth;
+    size_t  newHeight;
+    image_t *img;                       ///< loaded image, resized image after the resize stage
+} resize_job_t;
+
+/* Bounded FIFO of jobs between two stages */
+typedef struct
+{
+    const char      *name;
+    pthread_mutex_t lock;
+    pthread_cond_t  notEmpty;
+    pthread_cond_t  notFull;
+    resize_job_t    **jobs;             ///< ring of capacity jobs
+    size_t          capacity;
+    size_t          head;               ///< oldest job
+    size_t          count;
+    bool            closed;             ///< no more jobs are pushed, pops of an empty queue return NULL
+
+    /* statistics, guarded by lock */
+    size_t          nPushed;
+    size_t          depthSum;           ///< depth after every push
+    size_t          maxDepth;
+    double          fullWait;           ///< seconds producers waited for space
+    double          emptyWait;          ///< seconds consumers waited for jobs
+} resize_queue_t;
+
+/* Threads of a pipeline stage */
+typedef struct
+{
+    const char      *name;
+    bool            (*process)(resize_job_t *job, uint64_t *bytes);
+    resize_queue_t  *in;
+    resize_queue_t  *out;               ///< NULL for the last stage
+    pthread_t       *threads;
+    size_t          nThreads;           ///< started threads
+
+    /* statistics, updated atomically */
+    uint64_t        busyNs;             ///< time spent processing jobs
+    uint64_t        bytes;              ///< bytes read, produced or written
+    uint64_t        nDone;
+    uint64_t        nFailed;
+} resize_stage_t;
+
+/**
+ * Reads the monotonic clock
+ * @return Seconds
+ */
+static double resizeNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Deallocates a job and its image
+ * @param job Job
+ */
+static void resizeJobDestroy(resize_job_t *job)
+{
+    if (!job)
+    {
+        return;
+    }
+    if (job->img) { imgDestroy(job->img); }
+    free(job->src);
+    free(job->dst);
+    free(job);
+}
+
+/**
+ * Initializes an empty queue
+ * @param queue Queue
+ * @param name Name printed with statistics
+ * @param capacity Maximum number of queued jobs
+ * @return Success flag
+ */
+static bool resizeQueueInit(resize_queue_t *queue, const char *name, size_t capacity)
+{
+    bool lockInit = false;
+    bool notEmptyInit = false;
+
+    memset(queue, 0, sizeof(resize_queue_t));
+    queue->name = name;
+    queue->capacity = capacity;
+    RET_ERR_MSG(!(queue->jobs = malloc(sizeof(resize_job_t *) * capacity)), "Allocation error\n");
+    RET_ERR_MSG(!(lockInit = !pthread_mutex_init(&queue->lock, NULL)), "Failed to create mutex\n");
+    RET_ERR_MSG(!(notEmptyInit = !pthread_cond_init(&queue->notEmpty, NULL)), "Failed to create condition\n");
+    RET_ERR_MSG(pthread_cond_init(&queue->notFull, NULL), "Failed to create condition\n");
+    return true;
+
+error:
+    if (notEmptyInit) { pthread_cond_destroy(&queue->notEmpty); }
+    if (lockInit) { pthread_mutex_destroy(&queue->lock); }
+    free(queue->jobs);
+    queue->jobs = NULL;
+    return false;
+}
+
+/**
+ * Deallocates a queue and jobs left in it
+ * @param queue Queue initialized by resizeQueueInit
+ */
+static void resizeQueueDestroy(resize_queue_t *queue)
+{
+    if (!queue->jobs)
+    {
+        return;
+    }
+    for (size_t i = 0; i < queue->count; i++)
+    {
+        resizeJobDestroy(queue->jobs[(queue->head + i) % queue->capacity]);
+    }
+    pthread_cond_destroy(&queue->notFull);
+    pthread_cond_destroy(&queue->notEmpty);
+    pthread_mutex_destroy(&queue->lock);
+    free(queue->jobs);
+    queue->jobs = NULL;
+}
+
+/**
+ * Appends a job, blocks while the queue is full
+ * @param queue Queue
+ * @param job Job
+ */
+static void resizeQueuePush(resize_queue_t *queue, resize_job_t *job)
+{
+    pthread_mutex_lock(&queue->lock);
+    if (queue->count == queue->capacity)
+    {
+        double start = resizeNow();
+        while (queue->count == queue->capacity)
+        {
+            pthread_cond_wait(&queue->notFull, &queue->lock);
+        }
+        queue->fullWait += resizeNow() - start;
+    }
+
+    queue->jobs[(queue->head + queue->count) % queue->capacity] = job;
+    queue->count++;
+    queue->nPushed++;
+    queue->depthSum += queue->count;
+    queue->maxDepth = (queue->count > queue->maxDepth) ? queue->count : queue->maxDepth;
+
+    pthread_cond_signal(&queue->notEmpty);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+/**
+ * Removes the oldest job, blocks while the queue is empty and open
+ * @param queue Queue
+ * @return Job or NULL if the queue is empty and closed
+ */
+static resize_job_t *resizeQueuePop(resize_queue_t *queue)
+{
+    resize_job_t *job = NULL;
+
+    pthread_mutex_lock(&queue->lock);
+    if (!queue->count && !queue->closed)
+    {
+        double start = resizeNow();
+        while (!queue->count && !queue->closed)
+        {
+            pthread_cond_wait(&queue->notEmpty, &queue->lock);
+        }
+        queue->emptyWait += resizeNow() - start;
+    }
+
+    if (queue->count)
+    {
+        job = queue->jobs[queue->head];
+        queue->head = (queue->head + 1) % queue->capacity;
+        queue->count--;
+        pthread_cond_signal(&queue->notFull);
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return job;
+}
+
+/**
+ * Marks a queue as closed, consumers finish once it is empty
+ * @param queue Queue
+ */
+static void resizeQueueClose(resize_queue_t *queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    queue->closed = true;
+    pthread_cond_broadcast(&queue->notEmpty);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+/**
+ * Load stage, reads and deinterleaves the source bitmap
+ * @param job Job
+ * @param bytes Variable to store bytes read to
+ * @return Success flag
+ */
+static bool resizeLoad(resize_job_t *job, uint64_t *bytes)
+{
+    RET_ERR(!(job->img = imgLoadBitmap(job->src)));
+    *bytes = imgBitmapSize(job->img);
+    return true;
+
+error:
+    return false;
+}
+
+/**
+ * Resize stage, replaces the loaded image by the resized one
+ * @param job Job
+ * @param bytes Variable to store bytes of the resized image to
+ * @return Success flag
+ */
+static bool resizeResize(resize_job_t *job, uint64_t *bytes)
+{
+    image_t *newImg = imgResize(job->img, job->newWidth, job->newHeight);
+
+    /* the source buffer goes back to the pool before the next load needs one */
+    imgDestroy(job->img);
+    job->img = newImg;
+    RET_ERR(!newImg);
+    *bytes = (uint64_t)3 * newImg->width * newImg->height;
+    return true;
+
+error:
+    return false;
+}
+
+/**
+ * Save stage, writes the resized bitmap
+ * @param job Job
+ * @param bytes Variable to store bytes written to
+ * @return Success flag
+ */
+static bool resizeSave(resize_job_t *job, uint64_t *bytes)
+{
+    RET_ERR(!imgSaveBitmap(job->img, job->dst));
+    *bytes = imgBitmapSize(job->img);
+    return true;
+
+error:
+    return false;
+}
+
+/**
+ * Thread of a stage, processes jobs until its input queue is closed and empty
+ * @param arg Stage
+ * @return NULL
+ */
+static void *resizeStageThread(void *arg)
+{
+    resize_stage_t  *stage = arg;
+    resize_job_t    *job = NULL;
+
+    while ((job = resizeQueuePop(stage->in)))
+    {
+        uint64_t    bytes = 0;
+        double      start = resizeNow();
+        bool        ok = stage->process(job, &bytes);
+
+        __atomic_fetch_add(&stage->busyNs, (uint64_t)((resizeNow() - start) * 1e9), __ATOMIC_RELAXED);
+        __atomic_fetch_add(&stage->bytes, bytes, __ATOMIC_RELAXED);
+        __atomic_fetch_add(ok ? &stage->nDone : &stage->nFailed, 1, __ATOMIC_RELAXED);
+
+        if (!ok)
+        {
+            fprintf(stderr, "%s: failed to %s\n", job->src, stage->name);
+            resizeJobDestroy(job);
+        }
+        else if (stage->out)
+        {
+            resizeQueuePush(stage->out, job);
+        }
+        else
+        {
+            resizeJobDestroy(job);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Starts threads of a stage
+ * @param stage Stage with all but the threads set
+ * @param nThreads Number of threads
+ * @return Success flag, started threads are left running on error
+ */
+static bool resizeStageStart(resize_stage_t *stage, size_t nThreads)
+{
+    RET_ERR_MSG(!(stage->threads = malloc(sizeof(pthread_t) * nThreads)), "Allocation error\n");
+    for (stage->nThreads = 0; stage->nThreads < nThreads; stage->nThreads++)
+    {
+        RET_ERR_MSG(pthread_create(&stage->threads[stage->nThreads], NULL, resizeStageThread, stage),
+                    "Failed to start thread\n");
+    }
+    return true;
+
+error:
+    return false;
+}
+
+/**
+ * Joins threads of a stage once its input is closed, then closes its output, nThreads is kept for statistics
+ * @param stage Stage
+ */
+static void resizeStageJoin(resize_stage_t *stage)
+{
+    for (size_t i = 0; i < stage->nThreads; i++)
+    {
+        pthread_join(stage->threads[i], NULL);
+    }
+    free(stage->threads);
+    stage->threads = NULL;
+
+    if (stage->out)
+    {
+        resizeQueueClose(stage->out);
+    }
+}
+
+/**
+ * Parses a WIDTHxHEIGHT size
+ * @param str String to parse
+ * @param width Variable to store the width to
+ * @param height Variable to store the height to
+ * @return Success flag
+ */
+static bool resizeParseSize(const char *str, size_t *width, size_t *height)
+{
+    char    *end = NULL;
+    size_t  w = strtoul(str, &end, 10);
+
+    RET_ERR(end == str || *end != 'x');
+    str = end + 1;
+    *height = strtoul(str, &end, 10);
+    RET_ERR(end == str || *end);
+    *width = w;
+    return true;
+
+error:
+    return false;
+}
+
+/**
+ * Queues a job to the first stage, blocks while the queue is full
+ * @param queue Queue of the load stage
+ * @param src Source bitmap, copied
+ * @param dst Destination bitmap, copied
+ * @param newWidth Width of the resized image
+ * @param newHeight Height of the resized image
+ * @return Success flag
+ */
+static bool resizeSubmit(resize_queue_t *queue, const char *src, const char *dst, size_t newWidth,
+                         size_t newHeight)
+{
+    resize_job_t *job = NULL;
+
+    RET_ERR_MSG(!newWidth || !newHeight, "No size of resized images, use -s or a manifest size\n");
+    RET_ERR_MSG(!(job = calloc(1, sizeof(resize_job_t))), "Allocation error\n");
+    RET_ERR_MSG(!(job->src = strdup(src)) || !(job->dst = strdup(dst)), "Allocation error\n");
+    job->newWidth = newWidth;
+    job->newHeight = newHeight;
+
+    resizeQueuePush(queue, job);
+    return true;
+
+error:
+    resizeJobDestroy(job);
+    return false;
+}
+
+/**
+ * Queues "src dst [WIDTHxHEIGHT]" lines of a manifest, empty lines and lines starting with # are skipped
+ * @param queue Queue of the load stage
+ * @param f Manifest stream
+ * @param newWidth Width of lines without a size
+ * @param newHeight Height of lines without a size
+ * @return Success flag
+ */
+static bool resizeSubmitManifest(resize_queue_t *queue, FILE *f, size_t newWidth, size_t newHeight)
+{
+    char    *line = NULL;
+    size_t  lineSize = 0;
+
+    while (getline(&line, &lineSize, f) != -1)
+    {
+        char    *save = NULL;
+        char    *src = strtok_r(line, RESIZE_MANIFEST_SEP, &save);
+        char    *dst = strtok_r(NULL, RESIZE_MANIFEST_SEP, &save);
+        char    *size = strtok_r(NULL, RESIZE_MANIFEST_SEP, &save);
+        size_t  w = newWidth;
+        size_t  h = newHeight;
+
+        if (!src || src[0] == '#')
+        {
+            continue;
+        }
+        RET_ERR_MSG(!dst, "Manifest line without a destination\n");
+        RET_ERR_MSG(size && !resizeParseSize(size, &w, &h), "Invalid manifest size\n");
+        RET_ERR(!resizeSubmit(queue, src, dst, w, h));
+    }
+
+    free(line);
+    return true;
+
+error:
+    free(line);
+    return false;
+}
+
+/**
+ * Prints throughput of stages and depths of queues
+ * @param stages Stages
+ * @param queues Queues
+ * @param seconds Wall time of the batch
+ */
+static void resizePrintStats(const resize_stage_t stages[3], const resize_queue_t queues[3], double seconds)
+{
+    uint64_t nSaved = stages[2].nDone;
+    uint64_t nFailed = stages[0].nFailed + stages[1].nFailed + stages[2].nFailed;
+
+    printf("resized %" PRIu64 " images, %" PRIu64 " failed, %.3f s, %.1f images/s\n", nSaved, nFailed, seconds,
+           seconds > 0.0 ? nSaved / seconds : 0.0);
+
+    printf("%-8s %7s %7s %9s %6s %9s\n", "stage", "threads", "images", "busy s", "util", "MB/s");
+    for (size_t i = 0; i < 3; i++)
+    {
+        const resize_stage_t *stage = &stages[i];
+        double busy = stage->busyNs * 1e-9;
+        double util = (seconds > 0.0) ? busy / (seconds * stage->nThreads) : 0.0;
+
+        printf("%-8s %7zu %7" PRIu64 " %9.3f %5.0f%% %9.1f\n", stage->name, stage->nThreads, stage->nDone, busy,
+               util * 100.0, seconds > 0.0 ? stage->bytes / seconds * 1e-6 : 0.0);
+    }
+
+    /* full s is producers blocked on a full queue, empty s consumers blocked on an empty one */
+    printf("%-8s %7s %7s %9s %6s %9s %9s\n", "queue", "depth", "pushed", "avg depth", "max", "full s", "empty s");
+    for (size_t i = 0; i < 3; i++)
+    {
+        const resize_queue_t *queue = &queues[i];
+
+        printf("%-8s %7zu %7zu %9.2f %6zu %9.3f %9.3f\n", queue->name, queue->capacity, queue->nPushed,
+               queue->nPushed ? (double)queue->depthSum / queue->nPushed : 0.0, queue->maxDepth,
+               queue->fullWait, queue->emptyWait);
+    }
+}
+
+int cmdResize(int argc, char *argv[])
+{
+    resize_queue_t  queues[3];
+    resize_stage_t  stages[3];
+    size_t          nThreads[3] = { RESIZE_LOADERS, 0, RESIZE_WRITERS };
+    img_pool_t      *imgPool = NULL;
+    size_t          depth = RESIZE_QUEUE_DEPTH;
+    size_t          newWidth = 0;
+    size_t          newHeight = 0;
+    size_t          nQueues = 0;
+    size_t          nStages = 0;
+    double          start = 0.0;
+    bool            ok = true;
+    int             opt = 0;
+
+    memset(queues, 0, sizeof(queues));
+    memset(stages, 0, sizeof(stages));
+
+    /* first pass parses options only, manifests are read once the pipeline runs */
+    while ((opt = getopt(argc, argv, "s:j:l:w:q:m:")) != -1)
+    {
+        switch (opt)
+        {
+            case 's':
+                RET_ERR_MSG(!resizeParseSize(optarg, &newWidth, &newHeight), RESIZE_USAGE);
+                break;
+            case 'j':
+                nThreads[1] = strtoul(optarg, NULL, 10);
+                break;
+            case 'l':
+                nThreads[0] = strtoul(optarg, NULL, 10);
+                break;
+            case 'w':
+                nThreads[2] = strtoul(optarg, NULL, 10);
+                break;
+            case 'q':
+                depth = strtoul(optarg, NULL, 10);
+                break;
+            case 'm':
+                break;
+            default:
+                RET_ERR_MSG(true, RESIZE_USAGE);
+        }
+    }
+    RET_ERR_MSG(!nThreads[0] || !nThreads[2] || !depth, RESIZE_USAGE);
+    nThreads[1] = nThreads[1] ? nThreads[1] : threadPoolCpuCount();
+
+    /* images of a batch tend to have few sizes, their buffers are recycled */
+    RET_ERR_MSG(!(imgPool = imgPoolCreate(0, IMG_POOL_HUGE_PAGES)), "Failed to create image pool\n");
+    /* no more are cached than the queues, loaders, writers and workers (source and result) hold */
+    imgPoolSetMaxCachedBuffers(imgPool, 2 * depth + nThreads[0] + 2 * nThreads[1] + nThreads[2]);
+    imgPoolSetDefault(imgPool);
+
+    const char *queueNames[3] = { "jobs", "loaded", "resized" };
+    for (nQueues = 0; nQueues < 3; nQueues++)
+    {
+        RET_ERR(!resizeQueueInit(&queues[nQueues], queueNames[nQueues], depth));
+    }
+
+    const char *stageNames[3] = { "load", "resize", "save" };
+    bool (*const stageFns[3])(resize_job_t *, uint64_t *) = { resizeLoad, resizeResize, resizeSave };
+    start = resizeNow();
+    for (nStages = 0; nStages < 3; nStages++)
+    {
+        resize_stage_t *stage = &stages[nStages];
+
+        stage->name = stageNames[nStages];
+        stage->process = stageFns[nStages];
+        stage->in = &queues[nStages];
+        stage->out = (nStages + 1 < 3) ? &queues[nStages + 1] : NULL;
+        RET_ERR(!resizeStageStart(stage, nThreads[nStages]));
+    }
+
+    optind = 1;
+    while (ok && (opt = getopt(argc, argv, "s:j:l:w:q:m:")) != -1)
+    {
+        if (opt == 'm')
+        {
+            FILE *f = fopen(optarg, "r");
+
+            ok = f && resizeSubmitManifest(&queues[0], f, newWidth, newHeight);
+            if (!f) { fprintf(stderr, "%s: failed to open manifest\n", optarg); }
+            if (f) { fclose(f); }
+        }
+    }
+
+    for (int i = optind; ok && i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-"))
+        {
+            ok = resizeSubmitManifest(&queues[0], stdin, newWidth, newHeight);
+        }
+        else if (i + 1 < argc)
+        {
+            ok = resizeSubmit(&queues[0], argv[i], argv[i + 1], newWidth, newHeight);
+            i++;
+        }
+        else
+        {
+            fprintf(stderr, "%s: no destination\n", argv[i]);
+            ok = false;
+        }
+    }
+
+    /* every stage drains its input before the next one is told to stop */
+    resizeQueueClose(&queues[0]);
+    for (size_t i = 0; i < 3; i++)
+    {
+        resizeStageJoin(&stages[i]);
+    }
+    resizePrintStats(stages, queues, resizeNow() - start);
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        resizeQueueDestroy(&queues[i]);
+    }
+    imgPoolSetDefault(NULL);
+    imgPoolDestroy(imgPool);
+
+    return (ok && !stages[0].nFailed && !stages[1].nFailed && !stages[2].nFailed) ? 0 : 1;
+
+error:
+    /* started threads finish the jobs queued so far */
+    if (nQueues == 3)
+    {
+        resizeQueueClose(&queues[0]);
+        for (size_t i = 0; i < 3; i++)
+        {
+            resizeStageJoin(&stages[i]);
+        }
+    }
+    for (size_t i = 0; i < nQueues; i++)
+    {
+        resizeQueueDestroy(&queues[i]);
+    }
+    if (imgPool) { imgPoolSetDefault(NULL); imgPoolDestroy(imgPool); }
+    return 1;
+}
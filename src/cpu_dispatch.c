@@ -0,0 +1,112 @@
+#define _POSIX_C_SOURCE 200809L
+#include <cpuid.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "cpu_dispatch.h"
+
+#define XCR0_SSE_AVX_STATE      0x06        // XMM and YMM registers
+#define XCR0_AVX512_STATE       0xE0        // opmask, ZMM0-15 upper halves, ZMM16-31
+
+static const char *simdLevelNames[SIMD_LEVEL_COUNT] = { "scalar", "sse2", "avx", "avx2", "avx512" };
+
+/**
+ * Reads the extended control register 0
+ * @return Lower 32 bits of XCR0
+ */
+static uint32_t readXcr0(void)
+{
+    uint32_t eax = 0;
+    uint32_t edx = 0;
+
+    __asm__ volatile ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return eax;
+}
+
+simd_level_t cpuDetectSimdLevel(void)
+{
+    unsigned int eax = 0;
+    unsigned int ebx = 0;
+    unsigned int ecx = 0;
+    unsigned int edx = 0;
+    uint32_t xcr0 = 0;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(edx & bit_SSE2))
+    {
+        return SIMD_LEVEL_SCALAR;
+    }
+
+    /* AVX registers must be enabled by the OS as well */
+    if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)
+        || ((xcr0 = readXcr0()) & XCR0_SSE_AVX_STATE) != XCR0_SSE_AVX_STATE)
+    {
+        return SIMD_LEVEL_SSE2;
+    }
+
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) || !(ebx & bit_AVX2))
+    {
+        return SIMD_LEVEL_AVX;
+    }
+
+    if (!(ebx & bit_AVX512F) || !(ebx & bit_AVX512BW)
+        || (xcr0 & XCR0_AVX512_STATE) != XCR0_AVX512_STATE)
+    {
+        return SIMD_LEVEL_AVX2;
+    }
+
+    return SIMD_LEVEL_AVX512;
+}
+
+static pthread_once_t   simdLevelOnce = PTHREAD_ONCE_INIT;
+static simd_level_t     simdLevel = SIMD_LEVEL_SCALAR;
+
+/**
+ * Detects the SIMD level and applies CPU_DISPATCH_ENV, runs once
+ */
+static void cpuSimdLevelInit(void)
+{
+    const char      *forced = NULL;
+    simd_level_t    detected = cpuDetectSimdLevel();
+
+    if ((forced = getenv(CPU_DISPATCH_ENV)) && *forced)
+    {
+        simd_level_t l;
+        for (l = SIMD_LEVEL_SCALAR; l < SIMD_LEVEL_COUNT; l++)
+        {
+            if (!strcmp(forced, simdLevelNames[l]))
+            {
+                break;
+            }
+        }
+
+        if (l == SIMD_LEVEL_COUNT)
+        {
+            fprintf(stderr, "Unknown %s=%s, using %s\n", CPU_DISPATCH_ENV, forced,
+                    simdLevelNames[detected]);
+        }
+        else if (l > detected)
+        {
+            fprintf(stderr, "%s=%s is not supported by this CPU, using %s\n", CPU_DISPATCH_ENV,
+                    forced, simdLevelNames[detected]);
+        }
+        else
+        {
+            detected = l;
+        }
+    }
+
+    simdLevel = detected;
+}
+
+simd_level_t cpuSimdLevel(void)
+{
+    pthread_once(&simdLevelOnce, cpuSimdLevelInit);
+    return simdLevel;
+}
+
+const char *cpuSimdLevelName(simd_level_t level)
+{
+    return (level < SIMD_LEVEL_COUNT) ? simdLevelNames[level] : "unknown";
+}
@@ -0,0 +1,449 @@
+#include <endian.h>
+#include <string.h>
+#include "hash_index.h"
+#include "utils.h"
+
+/* hashes inserted since the last merge that are scanned linearly, bounds the cost of queries */
+#define HASH_INDEX_MAX_PENDING      4096
+/* substring radius above which probing buckets is slower than scanning everything */
+#define HASH_INDEX_MAX_PROBE_RADIUS 2
+
+/* Query in progress */
+typedef struct
+{
+    const hash_index_t  *index;
+    uint64_t            hash;           ///< query hash
+    size_t              radius;         ///< maximal distance of whole hashes
+    size_t              chunkRadius;    ///< maximal distance of substrings
+    uint32_t            *ids;
+    size_t              maxIds;
+    size_t              nFound;
+} hash_query_t;
+
+/**
+ * Extracts a substring of a hash
+ * @param hash Hash
+ * @param chunk Substring index
+ * @return Substring value
+ */
+static inline uint32_t hashChunk(uint64_t hash, size_t chunk)
+{
+    return (uint32_t)(hash >> (chunk * HASH_INDEX_CHUNK_BITS)) & (HASH_INDEX_N_BUCKETS - 1);
+}
+
+/**
+ * Verifies a candidate and records it when within the radius
+ * @param query Query
+ * @param id Candidate id
+ */
+static inline void queryReport(hash_query_t *query, uint32_t id)
+{
+    if (hemmingDistance(query->index->hashes[id], query->hash) <= query->radius)
+    {
+        if (query->ids && query->nFound < query->maxIds)
+        {
+            query->ids[query->nFound] = id;
+        }
+        query->nFound++;
+    }
+}
+
+/**
+ * Verifies all candidates of a bucket
+ * A candidate is verified only in the first substring that lies within chunkRadius, so that
+ * every hash is reported at most once.
+ * @param query Query
+ * @param chunk Substring index
+ * @param value Substring value of the bucket
+ */
+static void queryBucket(hash_query_t *query, size_t chunk, uint32_t value)
+{
+    const hash_index_t *index = query->index;
+    const uint32_t *ids = index->bucketIds[chunk];
+
+    for (uint32_t i = index->bucketStarts[chunk][value]; i < index->bucketStarts[chunk][value + 1]; i++)
+    {
+        uint64_t candidate = index->hashes[ids[i]];
+        bool seen = false;
+
+        for (size_t prev = 0; prev < chunk && !seen; prev++)
+        {
+            seen = hemmingDistance(hashChunk(candidate, prev), hashChunk(query->hash, prev))
+                    <= query->chunkRadius;
+        }
+
+        if (!seen)
+        {
+            queryReport(query, ids[i]);
+        }
+    }
+}
+
+/**
+ * Visits all buckets within a distance of a substring value
+ * @param query Query
+ * @param chunk Substring index
+ * @param value Substring value
+ * @param firstBit Lowest bit that may still be flipped
+ * @param budget Number of bits that may still be flipped
+ */
+static void queryProbe(hash_query_t *query, size_t chunk, uint32_t value, size_t firstBit, size_t budget)
+{
+    queryBucket(query, chunk, value);
+
+    if (budget == 0)
+    {
+        return;
+    }
+
+    for (size_t bit = firstBit; bit < HASH_INDEX_CHUNK_BITS; bit++)
+    {
+        queryProbe(query, chunk, value ^ (1u << bit), bit + 1, budget - 1);
+    }
+}
+
+hash_index_t *hashIndexCreate(void)
+{
+    hash_index_t *index = NULL;
+
+    RET_ERR_MSG(!(index = calloc(1, sizeof(hash_index_t))), "Allocation error\n");
+
+    for (size_t chunk = 0; chunk < HASH_INDEX_N_CHUNKS; chunk++)
+    {
+        RET_ERR_MSG(!(index->bucketStarts[chunk] = calloc(HASH_INDEX_N_BUCKETS + 1, sizeof(uint32_t))),
+                    "Allocation error\n");
+    }
+
+    return index;
+
+error:
+    hashIndexDestroy(index);
+    return NULL;
+}
+
+hash_index_t *hashIndexBuild(const uint64_t *hashes, size_t n)
+{
+    hash_index_t *index = NULL;
+
+    RET_ERR_MSG(!hashes && n, "NULL hashes\n");
+    RET_ERR_MSG(n > UINT32_MAX, "Too many hashes\n");
+    RET_ERR(!(index = hashIndexCreate()));
+
+    if (n)
+    {
+        RET_ERR_MSG(!(index->hashes = malloc(sizeof(uint64_t) * n)), "Allocation error\n");
+        memcpy(index->hashes, hashes, sizeof(uint64_t) * n);
+        index->nHashes = n;
+        index->capacity = n;
+    }
+
+    RET_ERR(!hashIndexRebuild(index));
+    return index;
+
+error:
+    hashIndexDestroy(index);
+    return NULL;
+}
+
+void hashIndexDestroy(hash_index_t *index)
+{
+    if (!index)
+    {
+        return;
+    }
+
+    for (size_t chunk = 0; chunk < HASH_INDEX_N_CHUNKS; chunk++)
+    {
+        free(index->bucketStarts[chunk]);
+        free(index->bucketIds[chunk]);
+    }
+    free(index->hashes);
+    free(index);
+}
+
+/**
+ * Adds hashes inserted since the last merge to the buckets
+ * Pending ids are counting sorted by substring value and appended to their buckets while the
+ * buckets are shifted in place from the last one, so the cost does not depend on how many hashes
+ * a full rebuild would sort.
+ * @param index Index
+ * @return Success flag, buckets stay consistent on error
+ */
+static bool hashIndexMerge(hash_index_t *index)
+{
+    uint32_t    *pendingStarts = NULL;
+    uint32_t    *pendingIds = NULL;
+    size_t      nIndexed = index->nIndexed;
+    size_t      nPending = index->nHashes - nIndexed;
+
+    RET_ERR_MSG(!(pendingStarts = malloc(sizeof(uint32_t) * (HASH_INDEX_N_BUCKETS + 1))), "Allocation error\n");
+    RET_ERR_MSG(!(pendingIds = malloc(sizeof(uint32_t) * nPending)), "Allocation error\n");
+
+    /* grow all bucket arrays first, nothing can fail once buckets start moving */
+    for (size_t chunk = 0; chunk < HASH_INDEX_N_CHUNKS; chunk++)
+    {
+        uint32_t *ids = realloc(index->bucketIds[chunk], sizeof(uint32_t) * index->nHashes);
+
+        RET_ERR_MSG(!ids, "Allocation error\n");
+        index->bucketIds[chunk] = ids;
+    }
+
+    for (size_t chunk = 0; chunk < HASH_INDEX_N_CHUNKS; chunk++)
+    {
+        uint32_t *starts = index->bucketStarts[chunk];
+        uint32_t *ids = index->bucketIds[chunk];
+
+        /* counting sort of pending ids, pendingStarts[value] ends as the end of the bucket */
+        memset(pendingStarts, 0, sizeof(uint32_t) * (HASH_INDEX_N_BUCKETS + 1));
+        for (size_t id = nIndexed; id < index->nHashes; id++)
+        {
+            pendingStarts[hashChunk(index->hashes[id], chunk) + 1]++;
+        }
+        for (size_t value = 0; value < HASH_INDEX_N_BUCKETS; value++)
+        {
+            pendingStarts[value + 1] += pendingStarts[value];
+        }
+        for (size_t id = nIndexed; id < index->nHashes; id++)
+        {
+            pendingIds[pendingStarts[hashChunk(index->hashes[id], chunk)]++] = (uint32_t)id;
+        }
+
+        /* bucket value moves right by the pending ids of lower buckets, pendingStarts[value - 1] */
+        for (size_t value = HASH_INDEX_N_BUCKETS; value-- > 0;)
+        {
+            uint32_t pendingBegin = value ? pendingStarts[value - 1] : 0;
+            uint32_t nOld = starts[value + 1] - starts[value];
+            uint32_t begin = starts[value] + pendingBegin;
+
+            if (pendingBegin)
+            {
+                memmove(&ids[begin], &ids[starts[value]], sizeof(uint32_t) * nOld);
+            }
+            memcpy(&ids[begin + nOld], &pendingIds[pendingBegin],
+                   sizeof(uint32_t) * (pendingStarts[value] - pendingBegin));
+            starts[value + 1] = starts[value + 1] + pendingStarts[value];
+        }
+    }
+
+    index->nIndexed = index->nHashes;
+    free(pendingIds);
+    free(pendingStarts);
+    return true;
+
+error:
+    free(pendingIds);
+    free(pendingStarts);
+    return false;
+}
+
+bool hashIndexInsert(hash_index_t *index, uint64_t hash, uint32_t *id)
+{
+    RET_ERR_MSG(!index, "NULL index\n");
+    RET_ERR_MSG(index->nHashes >= UINT32_MAX, "Too many hashes\n");
+
+    if (index->nHashes == index->capacity)
+    {
+        size_t capacity = index->capacity ? index->capacity * 2 : HASH_INDEX_MAX_PENDING;
+        uint64_t *hashes = realloc(index->hashes, sizeof(uint64_t) * capacity);
+
+        RET_ERR_MSG(!hashes, "Allocation error\n");
+        index->hashes = hashes;
+        index->capacity = capacity;
+    }
+
+    if (id)
+    {
+        *id = (uint32_t)index->nHashes;
+    }
+    index->hashes[index->nHashes++] = hash;
+
+    if (index->nHashes - index->nIndexed >= HASH_INDEX_MAX_PENDING)
+    {
+        RET_ERR(!hashIndexMerge(index));
+    }
+
+    return true;
+
+error:
+    return false;
+}
+
+bool hashIndexRebuild(hash_index_t *index)
+{
+    size_t n = 0;
+
+    RET_ERR_MSG(!index, "NULL index\n");
+    n = index->nHashes;
+
+    for (size_t chunk = 0; chunk < HASH_INDEX_N_CHUNKS; chunk++)
+    {
+        uint32_t *starts = index->bucketStarts[chunk];
+        uint32_t *ids = NULL;
+
+        RET_ERR_MSG(!(ids = realloc(index->bucketIds[chunk], sizeof(uint32_t) * (n ? n : 1))),
+                    "Allocation error\n");
+        index->bucketIds[chunk] = ids;
+
+        /* counting sort of ids by substring value */
+        memset(starts, 0, sizeof(uint32_t) * (HASH_INDEX_N_BUCKETS + 1));
+        for (size_t id = 0; id < n; id++)
+        {
+            starts[hashChunk(index->hashes[id], chunk) + 1]++;
+        }
+        for (size_t value = 0; value < HASH_INDEX_N_BUCKETS; value++)
+        {
+            starts[value + 1] += starts[value];
+        }
+        for (size_t id = 0; id < n; id++)
+        {
+            ids[starts[hashChunk(index->hashes[id], chunk)]++] = (uint32_t)id;
+        }
+
+        /* filling advanced every start to the next bucket, shift them back */
+        memmove(&starts[1], &starts[0], sizeof(uint32_t) * HASH_INDEX_N_BUCKETS);
+        starts[0] = 0;
+    }
+
+    index->nIndexed = n;
+    return true;
+
+error:
+    /* buckets may be inconsistent, fall back to scanning everything */
+    if (index)
+    {
+        for (size_t chunk = 0; chunk < HASH_INDEX_N_CHUNKS; chunk++)
+        {
+            memset(index->bucketStarts[chunk], 0, sizeof(uint32_t) * (HASH_INDEX_N_BUCKETS + 1));
+        }
+        index->nIndexed = 0;
+    }
+    return false;
+}
+
+size_t hashIndexQuery(const hash_index_t *index, uint64_t hash, size_t radius, uint32_t *ids,
+                      size_t maxIds)
+{
+    hash_query_t    query;
+    size_t          firstScanned = 0;
+
+    if (!index)
+    {
+        return 0;
+    }
+
+    query.index = index;
+    query.hash = hash;
+    query.radius = radius;
+    query.chunkRadius = radius / HASH_INDEX_N_CHUNKS;
+    query.ids = ids;
+    query.maxIds = maxIds;
+    query.nFound = 0;
+
+    if (query.chunkRadius <= HASH_INDEX_MAX_PROBE_RADIUS)
+    {
+        for (size_t chunk = 0; chunk < HASH_INDEX_N_CHUNKS; chunk++)
+        {
+            queryProbe(&query, chunk, hashChunk(hash, chunk), 0, query.chunkRadius);
+        }
+        firstScanned = index->nIndexed;
+    }
+
+    /* hashes inserted since the last rebuild, or all of them for large radii */
+    for (size_t id = firstScanned; id < index->nHashes; id++)
+    {
+        queryReport(&query, (uint32_t)id);
+    }
+
+    return query.nFound;
+}
+
+bool hashIndexSave(const hash_index_t *index, const char *file)
+{
+    FILE        *f = NULL;
+    uint32_t    hdr[2] = { HASH_INDEX_MAGIC, HASH_INDEX_VERSION };
+    uint64_t    nHashes = 0;
+    int         closeErr = 0;
+
+    RET_ERR_MSG(!index, "NULL index\n");
+    RET_ERR_MSG(!file, "NULL file name\n");
+    RET_ERR_MSG(!(f = fopen(file, "wb")), "Failed to open saving file\n");
+
+    nHashes = index->nHashes;
+
+#if __BYTE_ORDER == __BIG_ENDIAN
+    hdr[0] = swap32(hdr[0]);
+    hdr[1] = swap32(hdr[1]);
+    nHashes = swap64(nHashes);
+#endif
+
+    RET_ERR_MSG(fwrite(hdr, sizeof(hdr), 1, f) != 1, "Write error\n");
+    RET_ERR_MSG(fwrite(&nHashes, sizeof(nHashes), 1, f) != 1, "Write error\n");
+
+#if __BYTE_ORDER == __BIG_ENDIAN
+    for (size_t i = 0; i < index->nHashes; i++)
+    {
+        uint64_t hash = swap64(index->hashes[i]);
+        RET_ERR_MSG(fwrite(&hash, sizeof(hash), 1, f) != 1, "Write error\n");
+    }
+#else
+    RET_ERR_MSG(fwrite(index->hashes, sizeof(uint64_t), index->nHashes, f) != index->nHashes,
+                "Write error\n");
+#endif
+
+    closeErr = fclose(f);
+    f = NULL;
+    RET_ERR_MSG(closeErr, "Write error\n");
+    return true;
+
+error:
+    if (f) { fclose(f); }
+    return false;
+}
+
+hash_index_t *hashIndexLoad(const char *file)
+{
+    FILE            *f = NULL;
+    hash_index_t    *index = NULL;
+    uint32_t        hdr[2] = { 0, 0 };
+    uint64_t        nHashes = 0;
+
+    RET_ERR_MSG(!file, "NULL file name\n");
+    RET_ERR_MSG(!(f = fopen(file, "rb")), "Failed to open file\n");
+    RET_ERR_MSG(fread(hdr, sizeof(hdr), 1, f) != 1, "Reading error\n");
+    RET_ERR_MSG(fread(&nHashes, sizeof(nHashes), 1, f) != 1, "Reading error\n");
+
+#if __BYTE_ORDER == __BIG_ENDIAN
+    hdr[0] = swap32(hdr[0]);
+    hdr[1] = swap32(hdr[1]);
+    nHashes = swap64(nHashes);
+#endif
+
+    RET_ERR_MSG(hdr[0] != HASH_INDEX_MAGIC, "File is not a hash index\n");
+    RET_ERR_MSG(hdr[1] != HASH_INDEX_VERSION, "Unsupported hash index version\n");
+    RET_ERR_MSG(nHashes > UINT32_MAX, "Too many hashes\n");
+
+    RET_ERR(!(index = hashIndexCreate()));
+    if (nHashes)
+    {
+        RET_ERR_MSG(!(index->hashes = malloc(sizeof(uint64_t) * nHashes)), "Allocation error\n");
+        index->capacity = nHashes;
+        RET_ERR_MSG(fread(index->hashes, sizeof(uint64_t), nHashes, f) != nHashes, "Reading error\n");
+        index->nHashes = nHashes;
+    }
+
+#if __BYTE_ORDER == __BIG_ENDIAN
+    for (size_t i = 0; i < index->nHashes; i++)
+    {
+        index->hashes[i] = swap64(index->hashes[i]);
+    }
+#endif
+
+    RET_ERR(!hashIndexRebuild(index));
+    fclose(f);
+    return index;
+
+error:
+    if (f) { fclose(f); }
+    hashIndexDestroy(index);
+    return NULL;
+}
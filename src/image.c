@@ -1,137 +1,193 @@
+#define _POSIX_C_SOURCE 200809L
 #include <endian.h>
-#include "image.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "image_bmp.h"
+#include "image_color.h"
+#include "image_pool.h"
+#include "trace.h"
+
+/* Row converters of every SIMD level, levels without own primitives reuse the best lower ones */
+static const bmp_deinterleave_fn_t bmpDeinterleaveKernels[SIMD_LEVEL_COUNT] =
+{
+    [SIMD_LEVEL_SCALAR] = bmpDeinterleaveScalar,
+    [SIMD_LEVEL_SSE2]   = bmpDeinterleaveScalar,
+    [SIMD_LEVEL_AVX]    = bmpDeinterleaveAvx,
+    [SIMD_LEVEL_AVX2]   = bmpDeinterleaveAvx,
+    [SIMD_LEVEL_AVX512] = bmpDeinterleaveAvx,
+};
+
+static const bmp_interleave_fn_t bmpInterleaveKernels[SIMD_LEVEL_COUNT] =
+{
+    [SIMD_LEVEL_SCALAR] = bmpInterleaveScalar,
+    [SIMD_LEVEL_SSE2]   = bmpInterleaveScalar,
+    [SIMD_LEVEL_AVX]    = bmpInterleaveAvx,
+    [SIMD_LEVEL_AVX2]   = bmpInterleaveAvx,
+    [SIMD_LEVEL_AVX512] = bmpInterleaveAvx,
+};
+
+static const img_color_kernel_t imgColorKernels[SIMD_LEVEL_COUNT] =
+{
+    [SIMD_LEVEL_SCALAR] = { imgLumaRowScalar, imgBWRowScalar },
+    [SIMD_LEVEL_SSE2]   = { imgLumaRowScalar, imgBWRowScalar },
+    [SIMD_LEVEL_AVX]    = { imgLumaRowScalar, imgBWRowScalar },
+    [SIMD_LEVEL_AVX2]   = { imgLumaRowAvx2, imgBWRowAvx2 },
+    [SIMD_LEVEL_AVX512] = { imgLumaRowAvx2, imgBWRowAvx2 },
+};
+
+bmp_deinterleave_fn_t bmpDeinterleaveKernel(void)
+{
+    return bmpDeinterleaveKernels[cpuSimdLevel()];
+}
 
-image_t *imgLoadBitmap(const char *bmpFile)
+bmp_interleave_fn_t bmpInterleaveKernel(void)
 {
-    FILE        *f = NULL;
-    image_t     *img = NULL;
-    uint8_t     *pixelArray = NULL;
-    size_t      pixelArrayLen = 0;
-    size_t      nPixels = 0;
-    size_t      nPadding = 0;
-    size_t      nRead = 0;
-    bmp_hdr_t   bmpHdr;                     // used as dummy here
-    dib_hdr_t   dibHdr;
-    size_t      width = 0;
-    size_t      height = 0;
-    uint8_t     *rChannel = NULL;
-    uint8_t     *gChannel = NULL;
-    uint8_t     *bChannel = NULL;
+    return bmpInterleaveKernels[cpuSimdLevel()];
+}
 
-    RET_ERR_MSG(!bmpFile, "NULL file name\n");
-    RET_ERR_MSG(!(f = fopen(bmpFile, "rb")), "Failed to open file\n");
-    RET_ERR_MSG((nRead = fread(&bmpHdr, sizeof(bmpHdr), 1, f)) != 1, "Reading error\n");
+const img_color_kernel_t *imgColorKernel(void)
+{
+    return &imgColorKernels[cpuSimdLevel()];
+}
+
+void bmpDeinterleaveScalar(const uint8_t *bgr, uint8_t *rRow, uint8_t *gRow, uint8_t *bRow, size_t width)
+{
+    for (size_t c = 0; c < width; c++, bgr += 3)
+    {
+        rRow[c] = bgr[2];
+        gRow[c] = bgr[1];
+        bRow[c] = bgr[0];
+    }
+}
+
+void bmpInterleaveScalar(const uint8_t *rRow, const uint8_t *gRow, const uint8_t *bRow, uint8_t *bgr,
+                         size_t width)
+{
+    for (size_t c = 0; c < width; c++, bgr += 3)
+    {
+        bgr[0] = bRow[c];
+        bgr[1] = gRow[c];
+        bgr[2] = rRow[c];
+    }
+}
+
+bool bmpParseHeaders(const uint8_t hdr[BMP_HEADERS_SIZE], bmp_hdr_t *bmpHdr, dib_hdr_t *dibHdr)
+{
+    memcpy(bmpHdr, hdr, sizeof(bmp_hdr_t));
 
 #if __BYTE_ORDER == __BIG_ENDIAN
-    bmpHdr.magicNumber = swap16(magicNumber);
-    bmpHdr.fileSize = swap32(fileSize);
-    bmpHdr.reserved1 = swap16(reserved1);
-    bmpHdr.reserved2 = swap16(reserved2);
-    bmpHdr.pixelsOffset = swap32(pixelsOffset);
+    bmpHdr->magicNumber = swap16(bmpHdr->magicNumber);
+    bmpHdr->fileSize = swap32(bmpHdr->fileSize);
+    bmpHdr->reserved1 = swap16(bmpHdr->reserved1);
+    bmpHdr->reserved2 = swap16(bmpHdr->reserved2);
+    bmpHdr->pixelsOffset = swap32(bmpHdr->pixelsOffset);
 #endif
 
-    // dumpBmpHeader(&bmpHdr);
-    RET_ERR_MSG(bmpHdr.magicNumber != BMP_MAGIC_NUMBER, "File is not a bitmap\n");
-    RET_ERR_MSG((nRead = fread(&dibHdr, sizeof(dibHdr), 1, f)) != 1, "Reading error\n");
+    // dumpBmpHeader(bmpHdr);
+    RET_ERR_MSG(bmpHdr->magicNumber != BMP_MAGIC_NUMBER, "File is not a bitmap\n");
+    memcpy(dibHdr, hdr + sizeof(bmp_hdr_t), sizeof(dib_hdr_t));
 
 #if __BYTE_ORDER == __BIG_ENDIAN
-    dibHdr.hdrSize = swap32(hdrSize);
-    dibHdr.width = swap32(width);
-    dibHdr.height = swap32(height);
-    dibHdr.cPlanes = swap16(cPlanes);
-    dibHdr.bpp = swap16(bpp);
-    dibHdr.compression = swap32(compression);
-    dibHdr.imgSize = swap32(imgSize);
-    dibHdr.hResolution = swap32(hResolution);
-    dibHdr.vResolution = swap32(vResolution);
-    dibHdr.nColors = swap32(nColors);
-    dibHdr.nImpColors = swap32(nImpColors);
+    dibHdr->hdrSize = swap32(dibHdr->hdrSize);
+    dibHdr->width = swap32(dibHdr->width);
+    dibHdr->height = swap32(dibHdr->height);
+    dibHdr->cPlanes = swap16(dibHdr->cPlanes);
+    dibHdr->bpp = swap16(dibHdr->bpp);
+    dibHdr->compression = swap32(dibHdr->compression);
+    dibHdr->imgSize = swap32(dibHdr->imgSize);
+    dibHdr->hResolution = swap32(dibHdr->hResolution);
+    dibHdr->vResolution = swap32(dibHdr->vResolution);
+    dibHdr->nColors = swap32(dibHdr->nColors);
+    dibHdr->nImpColors = swap32(dibHdr->nImpColors);
 #endif
 
-    // dumpDibHeader(&dibHdr);
+    // dumpDibHeader(dibHdr);
 
-    RET_ERR_MSG(dibHdr.cPlanes != 1, "Corrupted DIB color planes\n");
-    RET_ERR_MSG(dibHdr.compression != 0, "DIB compression is unsupported\n");
-    RET_ERR_MSG(dibHdr.bpp != 24, "DIB bpp other than 24bpp is unsupported\n");
-    RET_ERR_MSG(dibHdr.width < 0 || dibHdr.height < 0, "Negative DIB dimenstions unsupported\n");
+    RET_ERR_MSG(dibHdr->cPlanes != 1, "Corrupted DIB color planes\n");
+    RET_ERR_MSG(dibHdr->compression != 0, "DIB compression is unsupported\n");
+    RET_ERR_MSG(dibHdr->bpp != 24, "DIB bpp other than 24bpp is unsupported\n");
+    RET_ERR_MSG(dibHdr->width < 0 || dibHdr->height < 0, "Negative DIB dimenstions unsupported\n");
 
-    RET_ERR_MSG(!(img = imgCreate(dibHdr.width, dibHdr.height)), "Allocation error\n");
+    return true;
 
-    width = img->width;
-    height = img->height;
-    rChannel = img->rChannel;
-    gChannel = img->gChannel;
-    bChannel = img->bChannel;
-    nPadding = 4 - (width * 3) % 4;
-    nPadding = (nPadding == 4) ? 0 : nPadding;
-    nPixels = dibHdr.width * dibHdr.height;
-    pixelArrayLen = nPixels * 3 + nPadding * height;
+error:
+    return false;
+}
 
-    RET_ERR_MSG(!(pixelArray = malloc(sizeof(uint8_t) * pixelArrayLen)), "Allocation error\n");
+image_t *imgLoadBitmap(const char *bmpFile)
+{
+    int                     fd = -1;
+    struct stat             st;
+    const uint8_t           *map = MAP_FAILED;
+    size_t                  mapLen = 0;
+    image_t                 *img = NULL;
+    bmp_hdr_t               bmpHdr;
+    dib_hdr_t               dibHdr;
+    size_t                  width = 0;
+    size_t                  height = 0;
+    size_t                  stride = 0;
+    bmp_deinterleave_fn_t   deinterleave = NULL;
+
+    TRACE_BEGIN(loadSpan);
+    RET_ERR_MSG(!bmpFile, "NULL file name\n");
+    RET_ERR_MSG((fd = open(bmpFile, O_RDONLY)) < 0, "Failed to open file\n");
+    RET_ERR_MSG(fstat(fd, &st) || !S_ISREG(st.st_mode), "Failed to open file\n");
+    RET_ERR_MSG((size_t)st.st_size < BMP_HEADERS_SIZE, "Reading error\n");
 
-    RET_ERR_MSG((nRead = fread(pixelArray, sizeof(uint8_t), pixelArrayLen, f)) != pixelArrayLen,
-                "Reading error\n");
+    /* pixels are converted straight from the page cache, no copy of the file is made */
+    mapLen = st.st_size;
+    RET_ERR_MSG((map = mmap(NULL, mapLen, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED,
+                "Failed to map file\n");
+    posix_madvise((void *)map, mapLen, POSIX_MADV_SEQUENTIAL);
 
-    const uint8_t *pixel = pixelArray;
-    for (size_t i = 0; i < nPixels; i++, pixel += 3)
-    {
-        rChannel[i] = pixel[2];
-        gChannel[i] = pixel[1];
-        bChannel[i] = pixel[0];
+    RET_ERR(!bmpParseHeaders(map, &bmpHdr, &dibHdr));
 
-        if ((i % width) == width - 1)
-        {
-            pixel += nPadding;
-        }
-    }
+    width = dibHdr.width;
+    height = dibHdr.height;
+    stride = BMP_ROW_STRIDE(width);
+    RET_ERR_MSG(bmpHdr.pixelsOffset > mapLen, "Reading error\n");
+    RET_ERR_MSG(width && (mapLen - bmpHdr.pixelsOffset) / stride < height, "Reading error\n");
 
+    RET_ERR_MSG(!(img = imgCreate(width, height)), "Allocation error\n");
+
+    /* padding is skipped once per row */
+    deinterleave = bmpDeinterleaveKernel();
+    TRACE_BEGIN(deinterleaveSpan);
+    for (size_t r = 0; r < height; r++)
+    {
+        deinterleave(map + bmpHdr.pixelsOffset + r * stride, &img->rChannel[r * img->stride],
+                     &img->gChannel[r * img->stride], &img->bChannel[r * img->stride], width);
+    }
+    TRACE_END(deinterleaveSpan, TRACE_DEINTERLEAVE, (uint64_t)stride * height, (uint64_t)width * height);
 
     // imgDump(img);
 
-    free(pixelArray);
-    fclose(f);
+    munmap((void *)map, mapLen);
+    close(fd);
+    TRACE_END(loadSpan, TRACE_LOAD, mapLen, (uint64_t)width * height);
     return img;
 
 error:
-    if (f) { fclose(f); }
-    if (pixelArray) { free(pixelArray); }
+    if (map != MAP_FAILED) { munmap((void *)map, mapLen); }
+    if (fd >= 0) { close(fd); }
     if (img) { imgDestroy(img); }
     return NULL;    
 }
 
-bool imgSaveBitmap(const image_t *img, const char *bmpFile)
+void bmpWriteHeaders(size_t width, size_t height, uint8_t hdr[BMP_HEADERS_SIZE])
 {
-    bmp_hdr_t       bmpHdr;
-    dib_hdr_t       dibHdr;
-    FILE            *f = NULL;
-    size_t          nPixels = 0;
-    size_t          nChars = 0;
-    const uint8_t   padding = 0x00;
-    size_t          nPadding = 0;
-    size_t          width = 0;
-    size_t          height = 0;
-    const uint8_t   *rChannel = NULL;
-    const uint8_t   *gChannel = NULL;
-    const uint8_t   *bChannel = NULL;
-
-    RET_ERR_MSG(!img, "NULL image\n");
-    RET_ERR_MSG(!bmpFile, "NULL file name\n");
-    RET_ERR_MSG(!(f = fopen(bmpFile, "wb")), "Failed to open saving file\n");
-
-    width = img->width;
-    height = img->height;
-    rChannel = img->rChannel;
-    gChannel = img->gChannel;
-    bChannel = img->bChannel;
-    nPixels = width * height;
-    nPadding = 4 - (width * 3) % 4;
-    nPadding = (nPadding == 4) ? 0 : nPadding;
+    bmp_hdr_t   bmpHdr;
+    dib_hdr_t   dibHdr;
+    size_t      pixelsSize = BMP_ROW_STRIDE(width) * height;
 
     bmpHdr.magicNumber = BMP_MAGIC_NUMBER;
-    bmpHdr.fileSize = sizeof(bmpHdr) + sizeof(dibHdr) + nPixels * 3 + nPadding * height;
+    bmpHdr.fileSize = BMP_HEADERS_SIZE + pixelsSize;
     bmpHdr.reserved1 = 0x0000;
     bmpHdr.reserved2 = 0x0000;
-    bmpHdr.pixelsOffset = sizeof(bmpHdr) + sizeof(dibHdr);
+    bmpHdr.pixelsOffset = BMP_HEADERS_SIZE;
 
     dibHdr.hdrSize = sizeof(dibHdr);
     dibHdr.width = width;
@@ -139,7 +195,7 @@ bool imgSaveBitmap(const image_t *img, const char *bmpFile)
     dibHdr.cPlanes = 1;
     dibHdr.bpp = 24;
     dibHdr.compression = 0;
-    dibHdr.imgSize = nPixels * 3 + nPadding * height;
+    dibHdr.imgSize = pixelsSize;
     dibHdr.hResolution = 0x00000000;
     dibHdr.vResolution = 0x00000000;
     dibHdr.nColors = 0x00000000;
@@ -165,123 +221,215 @@ bool imgSaveBitmap(const image_t *img, const char *bmpFile)
     dibHdr.nImpColors = swap32(dibHdr.nImpColors);
 #endif
 
-    RET_ERR_MSG((nChars = fwrite(&bmpHdr, sizeof(bmpHdr), 1, f)) != 1, "Write error\n");
-    RET_ERR_MSG((nChars = fwrite(&dibHdr, sizeof(dibHdr), 1, f)) != 1, "Write error\n");
+    memcpy(hdr, &bmpHdr, sizeof(bmpHdr));
+    memcpy(hdr + sizeof(bmpHdr), &dibHdr, sizeof(dibHdr));
+}
 
-    for (size_t r = 0; r < height; r++)
+/**
+ * Interleaves a range of rows to padded BGR rows
+ * @param interleave Row converter
+ * @param img Image
+ * @param rBegin First row
+ * @param rEnd Row past the range
+ * @param dst Buffer to store (rEnd - rBegin) padded rows to
+ */
+static void bmpWriteRows(bmp_interleave_fn_t interleave, const image_t *img, size_t rBegin, size_t rEnd,
+                         uint8_t *dst)
+{
+    size_t width = img->width;
+    size_t stride = BMP_ROW_STRIDE(width);
+
+    for (size_t r = rBegin; r < rEnd; r++, dst += stride)
     {
-        for (size_t c = 0; c < width; c++)
-        {
-            RET_ERR_MSG((nChars = fwrite(&imgReadChannel(bChannel, width, r, c),
-                                    sizeof(uint8_t), 1, f)) != 1, "Write error\n");
-            RET_ERR_MSG((nChars = fwrite(&imgReadChannel(gChannel, width, r, c),
-                                    sizeof(uint8_t), 1, f)) != 1, "Write error\n");
-            RET_ERR_MSG((nChars = fwrite(&imgReadChannel(rChannel, width, r, c),
-                                    sizeof(uint8_t), 1, f)) != 1, "Write error\n");
-        }
+        interleave(&img->rChannel[r * img->stride], &img->gChannel[r * img->stride],
+                   &img->bChannel[r * img->stride], dst, width);
+        memset(dst + width * 3, 0x00, stride - width * 3);
+    }
+}
+
+size_t imgBitmapSize(const image_t *img)
+{
+    return img ? BMP_HEADERS_SIZE + BMP_ROW_STRIDE(img->width) * img->height : 0;
+}
+
+bool imgSaveBitmap(const image_t *img, const char *bmpFile)
+{
+    FILE                *f = NULL;
+    uint8_t             *buffer = NULL;
+    size_t              stride = 0;
+    size_t              rowsPerWrite = 0;
+    uint8_t             hdr[BMP_HEADERS_SIZE];
+    bmp_interleave_fn_t interleave = NULL;
+    int                 closeErr = 0;
+
+    TRACE_BEGIN(saveSpan);
+    RET_ERR_MSG(!img, "NULL image\n");
+    RET_ERR_MSG(!bmpFile, "NULL file name\n");
+    RET_ERR_MSG(!(f = fopen(bmpFile, "wb")), "Failed to open saving file\n");
+
+    /* rows are interleaved to a buffer of BMP_WRITE_BUFFER_SIZE bytes, at least one row */
+    stride = BMP_ROW_STRIDE(img->width);
+    rowsPerWrite = stride ? BMP_WRITE_BUFFER_SIZE / stride : 1;
+    rowsPerWrite = rowsPerWrite ? rowsPerWrite : 1;
+    RET_ERR_MSG(!(buffer = malloc(rowsPerWrite * stride)), "Allocation error\n");
+    interleave = bmpInterleaveKernel();
 
-        /* add padding */
-        RET_ERR_MSG((nChars = fwrite(&padding, sizeof(uint8_t), nPadding, f)) != nPadding, "Write error\n");
+    bmpWriteHeaders(img->width, img->height, hdr);
+    RET_ERR_MSG(fwrite(hdr, sizeof(hdr), 1, f) != 1, "Write error\n");
+
+    for (size_t r = 0; r < img->height; r += rowsPerWrite)
+    {
+        size_t rEnd = (r + rowsPerWrite < img->height) ? r + rowsPerWrite : img->height;
+        size_t len = (rEnd - r) * stride;
+
+        bmpWriteRows(interleave, img, r, rEnd, buffer);
+        RET_ERR_MSG(fwrite(buffer, sizeof(uint8_t), len, f) != len, "Write error\n");
     }
 
-    fclose(f);
+    free(buffer);
+    buffer = NULL;
+    closeErr = fclose(f);
+    f = NULL;
+    RET_ERR_MSG(closeErr, "Write error\n");
+    TRACE_END(saveSpan, TRACE_SAVE, imgBitmapSize(img), (uint64_t)img->width * img->height);
     return true;
 
 error:
     if (f) { fclose(f); }
+    if (buffer) { free(buffer); }
     return false;
 }
 
-bool imgToGrayscale(image_t *img)
+bool imgSaveBitmapToMemory(const image_t *img, uint8_t *buffer, size_t bufferSize, size_t *written)
 {
-    size_t      width = 0;
-    size_t      height = 0;
-    uint8_t     *rChannel = NULL;
-    uint8_t     *gChannel = NULL;
-    uint8_t     *bChannel = NULL;
+    size_t size = 0;
 
-    RET_ERR_MSG(!img, "NULL image");
+    TRACE_BEGIN(saveSpan);
+    RET_ERR_MSG(!img, "NULL image\n");
+    RET_ERR_MSG(!buffer, "NULL buffer\n");
+    RET_ERR_MSG((size = imgBitmapSize(img)) > bufferSize, "Buffer too small\n");
 
-    width = img->width;
-    height = img->height;
-    rChannel = img->rChannel;
-    gChannel = img->gChannel;
-    bChannel = img->bChannel;
+    bmpWriteHeaders(img->width, img->height, buffer);
+    bmpWriteRows(bmpInterleaveKernel(), img, 0, img->height, buffer + BMP_HEADERS_SIZE);
 
-    for (size_t r = 0; r < height; r++)
+    if (written)
     {
-        for (size_t c = 0; c < width; c++)
-        {
-            uint8_t red = imgReadChannel(rChannel, width, r, c);
-            uint8_t green = imgReadChannel(gChannel, width, r, c);
-            uint8_t blue = imgReadChannel(bChannel, width, r, c);
-
-            uint8_t intensity = 0.2126 * red + 0.7152 * green + 0.0722 * blue;
-
-            imgWriteChannel(rChannel, width, r, c, intensity);
-            imgWriteChannel(gChannel, width, r, c, intensity);
-            imgWriteChannel(bChannel, width, r, c, intensity);
-        }
+        *written = size;
     }
-
+    TRACE_END(saveSpan, TRACE_SAVE, size, (uint64_t)img->width * img->height);
     return true;
 
 error:
     return false;
 }
 
-bool imgToBW(image_t *img)
+void imgLumaRowScalar(uint8_t *rRow, uint8_t *gRow, uint8_t *bRow, size_t width, bool triplicate)
 {
-    size_t      width = 0;
-    size_t      height = 0;
-    uint8_t     *rChannel = NULL;
-    uint8_t     *gChannel = NULL;
-    uint8_t     *bChannel = NULL;
-
-    RET_ERR_MSG(!img, "NULL image\n");
-    RET_ERR_MSG(!imgToGrayscale(img), "Failed to convert to grayscale\n");
+    for (size_t c = 0; c < width; c++)
+    {
+        uint8_t intensity = imgLumaPixel(rRow[c], gRow[c], bRow[c]);
 
-    width = img->width;
-    height = img->height;
-    rChannel = img->rChannel;
-    gChannel = img->gChannel;
-    bChannel = img->bChannel;
+        rRow[c] = intensity;
+        if (triplicate)
+        {
+            gRow[c] = intensity;
+            bRow[c] = intensity;
+        }
+    }
+}
 
-    for (size_t r = 0; r < height; r++)
+void imgBWRowScalar(uint8_t *rRow, uint8_t *gRow, uint8_t *bRow, size_t width, bool triplicate)
+{
+    for (size_t c = 0; c < width; c++)
     {
-        for (size_t c = 0; c < width; c++)
+        uint8_t val = (imgLumaPixel(rRow[c], gRow[c], bRow[c]) > BW_TRASHHOLD) ? 0xFF : 0;
+
+        rRow[c] = val;
+        if (triplicate)
         {
-            uint8_t intensity = imgReadChannel(rChannel, width, r, c);
+            gRow[c] = val;
+            bRow[c] = val;
+        }
+    }
+}
 
-            uint8_t val = (intensity > BW_TRASHHOLD) ? 0xFF : 0;
+/**
+ * Converts all rows of an image in place
+ * @param img Image to convert
+ * @param bw Whether to threshold the luma to black and white
+ * @param triplicate Whether to store the result to all channels or to the red one only
+ * @return Success flag
+ */
+static bool imgConvertColor(image_t *img, bool bw, bool triplicate)
+{
+    const img_color_kernel_t    *kernel = imgColorKernel();
+    size_t                      stride = 0;
+
+    TRACE_BEGIN(colorSpan);
+    RET_ERR_MSG(!img, "NULL image\n");
+
+    stride = img->stride;
+    for (size_t r = 0; r < img->height; r++)
+    {
+        uint8_t *rRow = &imgReadChannel(img->rChannel, stride, r, 0);
+        uint8_t *gRow = &imgReadChannel(img->gChannel, stride, r, 0);
+        uint8_t *bRow = &imgReadChannel(img->bChannel, stride, r, 0);
 
-            imgWriteChannel(rChannel, width, r, c, val);
-            imgWriteChannel(gChannel, width, r, c, val);
-            imgWriteChannel(bChannel, width, r, c, val);
+        if (bw)
+        {
+            kernel->bw(rRow, gRow, bRow, img->width, triplicate);
+        }
+        else
+        {
+            kernel->luma(rRow, gRow, bRow, img->width, triplicate);
         }
     }
 
+    TRACE_END(colorSpan, TRACE_GRAYSCALE, (uint64_t)(triplicate ? 3 : 1) * img->width * img->height,
+              (uint64_t)img->width * img->height);
     return true;
+
 error:
     return false;
 }
 
+bool imgToGrayscale(image_t *img)
+{
+    return imgConvertColor(img, false, true);
+}
+
+bool imgToGrayscalePlane(image_t *img)
+{
+    return imgConvertColor(img, false, false);
+}
+
+bool imgToBW(image_t *img)
+{
+    return imgConvertColor(img, true, true);
+}
+
+bool imgToBWPlane(image_t *img)
+{
+    return imgConvertColor(img, true, false);
+}
+
 bool imgAvgHash(const image_t *img, uint64_t *res)
 {
     image_t         *tmpImg = NULL;
     uint64_t        avgHash = 0x0000000000000000;
-    size_t          width = 0;
+    size_t          stride = 0;
     const uint8_t   *rChannel = NULL;
 
+    TRACE_BEGIN(hashSpan);
     RET_ERR_MSG(!img, "NULL image\n");
 
     RET_ERR_MSG(!(tmpImg = imgResize(img, AVG_HASH_IMG_DIM, AVG_HASH_IMG_DIM)),
                 "Failed to resize image\n");
 
-    RET_ERR_MSG(!imgToGrayscale(tmpImg), "Failed to convert to grayscale\n");
-    RET_ERR_MSG(!imgToBW(tmpImg), "Failed to convert to BW\n");
+    /* only the red channel is read below */
+    RET_ERR_MSG(!imgToBWPlane(tmpImg), "Failed to convert to BW\n");
 
-    width = tmpImg->width;
+    stride = tmpImg->stride;
     rChannel = tmpImg->rChannel;
 
     for (size_t r = 0; r < AVG_HASH_IMG_DIM; r++)
@@ -289,19 +437,20 @@ bool imgAvgHash(const image_t *img, uint64_t *res)
         uint8_t byte = 0x0;
         for (size_t c = 0; c < AVG_HASH_IMG_DIM; c++)
         {
-            uint8_t bit = (imgReadChannel(rChannel, width, r, c) == 0) ? 0 : 1;
+            uint8_t bit = (imgReadChannel(rChannel, stride, r, c) == 0) ? 0 : 1;
             byte |= bit << c;
         }
 
-        avgHash |= byte << (r * 8);
+        avgHash |= (uint64_t)byte << (r * 8);
     }
 
     *res = avgHash;
-    free (tmpImg);
+    imgDestroy(tmpImg);
+    TRACE_END(hashSpan, TRACE_HASH, (uint64_t)3 * img->width * img->height, (uint64_t)img->width * img->height);
     return true;
 
 error:
-    if (tmpImg) { free(tmpImg); }
+    if (tmpImg) { imgDestroy(tmpImg); }
     return false;
 }
 
@@ -309,20 +458,30 @@ image_t *imgCreate(size_t width, size_t height)
 {
     image_t *img = NULL;
     uint8_t *rChannel, *gChannel, *bChannel;
+    size_t  stride = IMG_ROW_STRIDE(width);
+    void    *chunk = NULL;
     rChannel = gChannel = bChannel = NULL;
 
+    if (imgPoolDefault())
+    {
+        return imgPoolAcquire(imgPoolDefault(), width, height);
+    }
+
     RET_ERR(!(img = malloc(sizeof(image_t))));
 
-    /* create one memory chunk for all channels */
-    RET_ERR(!(rChannel = malloc(sizeof(uint8_t) * width * height * 3)));
-    gChannel = rChannel + sizeof(uint8_t) * width * height;
-    bChannel = gChannel + sizeof(uint8_t) * width * height;
+    /* create one aligned memory chunk for all channels, strides keep every channel aligned */
+    RET_ERR(posix_memalign(&chunk, IMG_ALIGN, sizeof(uint8_t) * stride * height * 3 + IMG_CHANNEL_SLACK));
+    rChannel = chunk;
+    gChannel = rChannel + sizeof(uint8_t) * stride * height;
+    bChannel = gChannel + sizeof(uint8_t) * stride * height;
 
     img->width = width;
     img->height = height;
+    img->stride = stride;
     img->rChannel = rChannel;
     img->gChannel = gChannel;
     img->bChannel = bChannel;
+    img->pool = NULL;
     return img;
 
 error:
@@ -337,13 +496,71 @@ void imgDestroy(image_t *img)
     {
         return;
     }
-    
+
+    if (img->pool)
+    {
+        imgPoolRelease(img);
+        return;
+    }
+
     img->width = 0;
     img->height = 0;
     free(img->rChannel);
     free(img);
 }
 
+packed_image_t *packedImgCreate(size_t width, size_t height, size_t nChannels)
+{
+    packed_image_t  *img = NULL;
+    uint8_t         *pixels = NULL;
+
+    RET_ERR_MSG(nChannels != 3 && nChannels != 4, "Unsupported number of channels\n");
+    RET_ERR(!(pixels = malloc(sizeof(uint8_t) * width * height * nChannels + IMG_CHANNEL_SLACK)));
+    RET_ERR(!(img = packedImgWrap(pixels, width, height, nChannels, width * nChannels)));
+    img->ownsPixels = true;
+    return img;
+
+error:
+    if (pixels) { free(pixels); }
+    return NULL;
+}
+
+packed_image_t *packedImgWrap(uint8_t *pixels, size_t width, size_t height, size_t nChannels,
+                              size_t stride)
+{
+    packed_image_t *img = NULL;
+
+    RET_ERR_MSG(!pixels, "NULL pixels\n");
+    RET_ERR_MSG(nChannels != 3 && nChannels != 4, "Unsupported number of channels\n");
+    RET_ERR_MSG(stride < width * nChannels, "Stride shorter than row\n");
+    RET_ERR(!(img = malloc(sizeof(packed_image_t))));
+
+    img->width = width;
+    img->height = height;
+    img->nChannels = nChannels;
+    img->stride = stride;
+    img->pixels = pixels;
+    img->ownsPixels = false;
+    return img;
+
+error:
+    return NULL;
+}
+
+void packedImgDestroy(packed_image_t *img)
+{
+    if (!img)
+    {
+        return;
+    }
+
+    if (img->ownsPixels)
+    {
+        free(img->pixels);
+    }
+    free(img);
+}
+
 void imgDump(const image_t *img)
 {
     if (!img)
@@ -364,7 +581,10 @@ void imgDump(const image_t *img)
     size_t nPixels = (width * height > 50) ? 50 : width * height;
     for (size_t i = 0; i < nPixels; i++)
     {
-        fprintf(stderr, "[%3u,%3u,%3u]", rChannel[i], gChannel[i], bChannel[i]);
+        size_t r = i / width;
+        size_t c = i % width;
+        fprintf(stderr, "[%3u,%3u,%3u]", imgReadChannel(rChannel, img->stride, r, c),
+                imgReadChannel(gChannel, img->stride, r, c), imgReadChannel(bChannel, img->stride, r, c));
 
         if (i % 5 == 4)
         {
@@ -0,0 +1,93 @@
+#include <immintrin.h>
+#include "image_bmp.h"
+
+#define BMP_VEC_N_PIXELS    16
+
+/*
+** Necessary extensions:
+**      AVX (128 bit VEX pshufb)
+** Converts 16 pixels (48 bytes) per iteration, every output vector gathers its bytes from the three
+** input vectors with one shuffle each
+*/
+
+void bmpDeinterleaveAvx(const uint8_t *bgr, uint8_t *rRow, uint8_t *gRow, uint8_t *bRow, size_t width)
+{
+    /* byte 3 * i + k of the 48 byte block, -1 zeroes bytes that lie in another input vector */
+    const __m128i b_from_0_vec = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i b_from_1_vec = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+    const __m128i b_from_2_vec = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+    const __m128i g_from_0_vec = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i g_from_1_vec = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+    const __m128i g_from_2_vec = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+    const __m128i r_from_0_vec = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i r_from_1_vec = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+    const __m128i r_from_2_vec = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+
+    /* process BMP_VEC_N_PIXELS pixels in one iteration */
+    size_t c;
+    for (c = 0; c + BMP_VEC_N_PIXELS <= width; c += BMP_VEC_N_PIXELS)
+    {
+        const uint8_t *block = &bgr[c * 3];
+        __m128i in_0_vec = _mm_loadu_si128((const __m128i *)&block[0]);
+        __m128i in_1_vec = _mm_loadu_si128((const __m128i *)&block[16]);
+        __m128i in_2_vec = _mm_loadu_si128((const __m128i *)&block[32]);
+
+        __m128i b_vec = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(in_0_vec, b_from_0_vec),
+                                                  _mm_shuffle_epi8(in_1_vec, b_from_1_vec)),
+                                     _mm_shuffle_epi8(in_2_vec, b_from_2_vec));
+        __m128i g_vec = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(in_0_vec, g_from_0_vec),
+                                                  _mm_shuffle_epi8(in_1_vec, g_from_1_vec)),
+                                     _mm_shuffle_epi8(in_2_vec, g_from_2_vec));
+        __m128i r_vec = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(in_0_vec, r_from_0_vec),
+                                                  _mm_shuffle_epi8(in_1_vec, r_from_1_vec)),
+                                     _mm_shuffle_epi8(in_2_vec, r_from_2_vec));
+
+        _mm_storeu_si128((__m128i *)&bRow[c], b_vec);
+        _mm_storeu_si128((__m128i *)&gRow[c], g_vec);
+        _mm_storeu_si128((__m128i *)&rRow[c], r_vec);
+    }
+
+    /* finished the rest */
+    bmpDeinterleaveScalar(&bgr[c * 3], &rRow[c], &gRow[c], &bRow[c], width - c);
+}
+
+void bmpInterleaveAvx(const uint8_t *rRow, const uint8_t *gRow, const uint8_t *bRow, uint8_t *bgr, size_t width)
+{
+    /* channel byte of every byte of the 48 byte block, -1 zeroes bytes of other channels */
+    const __m128i b_to_0_vec = _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5);
+    const __m128i g_to_0_vec = _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1);
+    const __m128i r_to_0_vec = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+    const __m128i b_to_1_vec = _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1);
+    const __m128i g_to_1_vec = _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10);
+    const __m128i r_to_1_vec = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1);
+    const __m128i b_to_2_vec = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1);
+    const __m128i g_to_2_vec = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1);
+    const __m128i r_to_2_vec = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15);
+
+    /* process BMP_VEC_N_PIXELS pixels in one iteration */
+    size_t c;
+    for (c = 0; c + BMP_VEC_N_PIXELS <= width; c += BMP_VEC_N_PIXELS)
+    {
+        uint8_t *block = &bgr[c * 3];
+        __m128i b_vec = _mm_loadu_si128((const __m128i *)&bRow[c]);
+        __m128i g_vec = _mm_loadu_si128((const __m128i *)&gRow[c]);
+        __m128i r_vec = _mm_loadu_si128((const __m128i *)&rRow[c]);
+
+        __m128i out_0_vec = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(b_vec, b_to_0_vec),
+                                                      _mm_shuffle_epi8(g_vec, g_to_0_vec)),
+                                         _mm_shuffle_epi8(r_vec, r_to_0_vec));
+        __m128i out_1_vec = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(b_vec, b_to_1_vec),
+                                                      _mm_shuffle_epi8(g_vec, g_to_1_vec)),
+                                         _mm_shuffle_epi8(r_vec, r_to_1_vec));
+        __m128i out_2_vec = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(b_vec, b_to_2_vec),
+                                                      _mm_shuffle_epi8(g_vec, g_to_2_vec)),
+                                         _mm_shuffle_epi8(r_vec, r_to_2_vec));
+
+        _mm_storeu_si128((__m128i *)&block[0], out_0_vec);
+        _mm_storeu_si128((__m128i *)&block[16], out_1_vec);
+        _mm_storeu_si128((__m128i *)&block[32], out_2_vec);
+    }
+
+    /* finished the rest */
+    bmpInterleaveScalar(&rRow[c], &gRow[c], &bRow[c], &bgr[c * 3], width - c);
+}
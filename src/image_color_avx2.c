@@ -0,0 +1,100 @@
+#include <immintrin.h>
+#include "image_color.h"
+
+#define AVX2_REG_N_BYTES    32
+
+/*
+** Necessary extensions:
+**      AVX2
+** Converts 32 pixels per iteration, (r, g) and (b, 0) word pairs are weighted with _mm256_madd_epi16
+*/
+
+/**
+ * Computes luma of 32 pixels
+ * This function substitues the scalar alternative imgLumaPixel()
+ * @param r_vec Red
+ * @param g_vec Green
+ * @param b_vec Blue
+ * @return Luma, 32 x uint8
+ */
+static inline __m256i lumaVec(__m256i r_vec, __m256i g_vec, __m256i b_vec)
+{
+    const __m256i zero_vec = _mm256_setzero_si256();
+    const __m256i w_rg_vec = _mm256_set1_epi32(IMG_LUMA_R | (IMG_LUMA_G << 16));
+    const __m256i w_b_vec = _mm256_set1_epi32(IMG_LUMA_B);
+
+    /* bytes to words, lanes hold pixels (0 .. 7, 16 .. 23) and (8 .. 15, 24 .. 31) */
+    __m256i r_lo_vec = _mm256_unpacklo_epi8(r_vec, zero_vec);
+    __m256i r_hi_vec = _mm256_unpackhi_epi8(r_vec, zero_vec);
+    __m256i g_lo_vec = _mm256_unpacklo_epi8(g_vec, zero_vec);
+    __m256i g_hi_vec = _mm256_unpackhi_epi8(g_vec, zero_vec);
+    __m256i b_lo_vec = _mm256_unpacklo_epi8(b_vec, zero_vec);
+    __m256i b_hi_vec = _mm256_unpackhi_epi8(b_vec, zero_vec);
+
+    /* R * r + G * g + B * b as dwords, 4 pixels per lane of every sum */
+    __m256i l0_vec = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(r_lo_vec, g_lo_vec), w_rg_vec),
+                                      _mm256_madd_epi16(_mm256_unpacklo_epi16(b_lo_vec, zero_vec), w_b_vec));
+    __m256i l1_vec = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(r_lo_vec, g_lo_vec), w_rg_vec),
+                                      _mm256_madd_epi16(_mm256_unpackhi_epi16(b_lo_vec, zero_vec), w_b_vec));
+    __m256i l2_vec = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(r_hi_vec, g_hi_vec), w_rg_vec),
+                                      _mm256_madd_epi16(_mm256_unpacklo_epi16(b_hi_vec, zero_vec), w_b_vec));
+    __m256i l3_vec = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(r_hi_vec, g_hi_vec), w_rg_vec),
+                                      _mm256_madd_epi16(_mm256_unpackhi_epi16(b_hi_vec, zero_vec), w_b_vec));
+
+    l0_vec = _mm256_srli_epi32(l0_vec, IMG_LUMA_BITS);
+    l1_vec = _mm256_srli_epi32(l1_vec, IMG_LUMA_BITS);
+    l2_vec = _mm256_srli_epi32(l2_vec, IMG_LUMA_BITS);
+    l3_vec = _mm256_srli_epi32(l3_vec, IMG_LUMA_BITS);
+
+    /* packing within lanes undoes the unpacking, pixels come out in order */
+    return _mm256_packus_epi16(_mm256_packus_epi32(l0_vec, l1_vec), _mm256_packus_epi32(l2_vec, l3_vec));
+}
+
+/**
+ * Stores converted pixels
+ * @param v_vec Converted pixels
+ * @param rRow Red channel row
+ * @param gRow Green channel row
+ * @param bRow Blue channel row
+ * @param triplicate Whether to store to gRow and bRow as well
+ */
+static inline void storeVec(__m256i v_vec, uint8_t *rRow, uint8_t *gRow, uint8_t *bRow, bool triplicate)
+{
+    _mm256_store_si256((__m256i *)rRow, v_vec);
+    if (triplicate)
+    {
+        _mm256_store_si256((__m256i *)gRow, v_vec);
+        _mm256_store_si256((__m256i *)bRow, v_vec);
+    }
+}
+
+void imgLumaRowAvx2(uint8_t *rRow, uint8_t *gRow, uint8_t *bRow, size_t width, bool triplicate)
+{
+    /* process AVX2_REG_N_BYTES pixels in one iteration, the last one runs into the padding of the rows */
+    for (size_t c = 0; c < width; c += AVX2_REG_N_BYTES)
+    {
+        __m256i l_vec = lumaVec(_mm256_load_si256((const __m256i *)&rRow[c]),
+                                _mm256_load_si256((const __m256i *)&gRow[c]),
+                                _mm256_load_si256((const __m256i *)&bRow[c]));
+
+        storeVec(l_vec, &rRow[c], &gRow[c], &bRow[c], triplicate);
+    }
+}
+
+void imgBWRowAvx2(uint8_t *rRow, uint8_t *gRow, uint8_t *bRow, size_t width, bool triplicate)
+{
+    const __m256i above_vec = _mm256_set1_epi8((char)(BW_TRASHHOLD + 1));
+
+    /* process AVX2_REG_N_BYTES pixels in one iteration, the last one runs into the padding of the rows */
+    for (size_t c = 0; c < width; c += AVX2_REG_N_BYTES)
+    {
+        __m256i l_vec = lumaVec(_mm256_load_si256((const __m256i *)&rRow[c]),
+                                _mm256_load_si256((const __m256i *)&gRow[c]),
+                                _mm256_load_si256((const __m256i *)&bRow[c]));
+
+        /* unsigned luma > BW_TRASHHOLD, max(l, BW_TRASHHOLD + 1) == l */
+        __m256i bw_vec = _mm256_cmpeq_epi8(_mm256_max_epu8(l_vec, above_vec), l_vec);
+
+        storeVec(bw_vec, &rRow[c], &gRow[c], &bRow[c], triplicate);
+    }
+}
@@ -0,0 +1,104 @@
+#include "image_hash.h"
+#include "trace.h"
+
+/* Row primitives of every SIMD level, levels without own primitives reuse the best lower ones */
+static const avg_hash_row_fn_t avgHashRowKernels[SIMD_LEVEL_COUNT] =
+{
+    [SIMD_LEVEL_SCALAR] = avgHashRowSumsScalar,
+    [SIMD_LEVEL_SSE2]   = avgHashRowSumsScalar,
+    [SIMD_LEVEL_AVX]    = avgHashRowSumsScalar,
+    [SIMD_LEVEL_AVX2]   = avgHashRowSumsAvx2,
+    [SIMD_LEVEL_AVX512] = avgHashRowSumsAvx2,
+};
+
+/**
+ * Source range of a cell, every cell covers at least one pixel even in tiny images
+ * @param n Source dimension
+ * @param cell Cell index
+ * @param begin Variable to store the first coordinate to
+ * @param end Variable to store the coordinate past the cell to
+ */
+static inline void avgHashCellRange(size_t n, size_t cell, size_t *begin, size_t *end)
+{
+    *begin = cell * n / AVG_HASH_IMG_DIM;
+    *end = (cell + 1) * n / AVG_HASH_IMG_DIM;
+
+    if (*end <= *begin)
+    {
+        *end = *begin + 1;
+    }
+}
+
+void avgHashRowSumsScalar(const uint8_t *row, const avg_hash_cells_t *cells,
+                          uint64_t sums[AVG_HASH_IMG_DIM])
+{
+    for (size_t cell = 0; cell < AVG_HASH_IMG_DIM; cell++)
+    {
+        uint64_t sum = 0;
+        for (size_t c = cells->starts[cell]; c < cells->ends[cell]; c++)
+        {
+            sum += row[c];
+        }
+        sums[cell] += sum;
+    }
+}
+
+bool imgAvgHashFused(const image_t *img, uint64_t *res)
+{
+    avg_hash_row_fn_t   rowSums = NULL;
+    avg_hash_cells_t    cells;
+    uint64_t            avgHash = 0x0000000000000000;
+    size_t              width = 0;
+    size_t              height = 0;
+
+    TRACE_BEGIN(hashSpan);
+    RET_ERR_MSG(!img, "NULL image\n");
+    RET_ERR_MSG(!res, "NULL result\n");
+    RET_ERR_MSG(!img->width || !img->height, "Empty image\n");
+
+    width = img->width;
+    height = img->height;
+    rowSums = avgHashRowKernels[cpuSimdLevel()];
+
+    for (size_t cell = 0; cell < AVG_HASH_IMG_DIM; cell++)
+    {
+        avgHashCellRange(width, cell, &cells.starts[cell], &cells.ends[cell]);
+    }
+
+    for (size_t cellR = 0; cellR < AVG_HASH_IMG_DIM; cellR++)
+    {
+        uint64_t    rSums[AVG_HASH_IMG_DIM] = { 0 };
+        uint64_t    gSums[AVG_HASH_IMG_DIM] = { 0 };
+        uint64_t    bSums[AVG_HASH_IMG_DIM] = { 0 };
+        size_t      rBegin, rEnd;
+
+        avgHashCellRange(height, cellR, &rBegin, &rEnd);
+
+        for (size_t r = rBegin; r < rEnd; r++)
+        {
+            rowSums(&img->rChannel[r * img->stride], &cells, rSums);
+            rowSums(&img->gChannel[r * img->stride], &cells, gSums);
+            rowSums(&img->bChannel[r * img->stride], &cells, bSums);
+        }
+
+        for (size_t cellC = 0; cellC < AVG_HASH_IMG_DIM; cellC++)
+        {
+            /* mean luma of the cell, luma is linear so it is applied to the channel sums */
+            uint64_t nPixels = (uint64_t)(rEnd - rBegin) * (cells.ends[cellC] - cells.starts[cellC]);
+            uint64_t luma = IMG_LUMA_R * rSums[cellC] + IMG_LUMA_G * gSums[cellC] + IMG_LUMA_B * bSums[cellC];
+            uint64_t intensity = luma / (nPixels << IMG_LUMA_BITS);
+
+            if (intensity > BW_TRASHHOLD)
+            {
+                avgHash |= (uint64_t)1 << (cellR * AVG_HASH_IMG_DIM + cellC);
+            }
+        }
+    }
+
+    *res = avgHash;
+    TRACE_END(hashSpan, TRACE_HASH, (uint64_t)3 * width * height, (uint64_t)width * height);
+    return true;
+
+error:
+    return false;
+}
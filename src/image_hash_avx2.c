@@ -0,0 +1,56 @@
+#include <immintrin.h>
+#include "image_hash.h"
+
+#define AVX2_REG_N_BYTES    32
+
+/*
+** Necessary extensions:
+**      AVX2
+** Sums 32 pixels per instruction with _mm256_sad_epu8
+*/
+
+/**
+ * Sums a span of pixels
+ * The last partial vector is loaded whole and masked, over-read is covered by IMG_CHANNEL_SLACK
+ * @param p First pixel
+ * @param n Number of pixels
+ * @return Sum of pixels
+ */
+static inline uint64_t spanSum(const uint8_t *p, size_t n)
+{
+    const __m256i zero_vec = _mm256_setzero_si256();
+    const __m256i lane_idx_vec = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+                                                  16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29,
+                                                  30, 31);
+    __m256i sum_vec = _mm256_setzero_si256();
+
+    size_t i;
+    for (i = 0; i + AVX2_REG_N_BYTES <= n; i += AVX2_REG_N_BYTES)
+    {
+        /* 4 x uint64 sums of 8 bytes each */
+        sum_vec = _mm256_add_epi64(sum_vec, _mm256_sad_epu8(_mm256_loadu_si256((const __m256i *)&p[i]),
+                                                            zero_vec));
+    }
+
+    if (i < n)
+    {
+        /* keep lanes below n - i, 0 < n - i < 32 */
+        __m256i keep_vec = _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(n - i)), lane_idx_vec);
+        __m256i tail_vec = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&p[i]), keep_vec);
+        sum_vec = _mm256_add_epi64(sum_vec, _mm256_sad_epu8(tail_vec, zero_vec));
+    }
+
+    __m128i sum_128_vec = _mm_add_epi64(_mm256_castsi256_si128(sum_vec),
+                                        _mm256_extracti128_si256(sum_vec, 1));
+    sum_128_vec = _mm_add_epi64(sum_128_vec, _mm_unpackhi_epi64(sum_128_vec, sum_128_vec));
+    return (uint64_t)_mm_cvtsi128_si64(sum_128_vec);
+}
+
+void avgHashRowSumsAvx2(const uint8_t *row, const avg_hash_cells_t *cells,
+                        uint64_t sums[AVG_HASH_IMG_DIM])
+{
+    for (size_t cell = 0; cell < AVG_HASH_IMG_DIM; cell++)
+    {
+        sums[cell] += spanSum(&row[cells->starts[cell]], cells->ends[cell] - cells->starts[cell]);
+    }
+}
@@ -0,0 +1,330 @@
+#define _DEFAULT_SOURCE
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "image_pool.h"
+
+static img_pool_t *defaultPool = NULL;
+
+/**
+ * Finds the smallest size class holding given number of bytes
+ * @param bytes Requested bytes
+ * @return Size class
+ */
+static size_t poolSizeClass(size_t bytes)
+{
+    size_t exp = 0;
+    size_t base = IMG_POOL_MIN_BYTES;
+
+    while (bytes > base * 2)
+    {
+        base *= 2;
+        exp++;
+    }
+
+    if (bytes <= base)
+    {
+        return exp * IMG_POOL_CLASS_STEPS;
+    }
+
+    /* classes of the power of two are base + step * base / IMG_POOL_CLASS_STEPS */
+    return exp * IMG_POOL_CLASS_STEPS + ((bytes - base) * IMG_POOL_CLASS_STEPS + base - 1) / base;
+}
+
+/**
+ * Size of buffers of a size class
+ * @param sizeClass Size class
+ * @return Bytes
+ */
+static size_t poolClassBytes(size_t sizeClass)
+{
+    size_t base = (size_t)IMG_POOL_MIN_BYTES << (sizeClass / IMG_POOL_CLASS_STEPS);
+    return base + base / IMG_POOL_CLASS_STEPS * (sizeClass % IMG_POOL_CLASS_STEPS);
+}
+
+/**
+ * Maps channels of a large buffer aligned to IMG_POOL_HUGE_PAGE_SIZE
+ * @param buffer Buffer to map the channels of
+ * @return Success flag
+ */
+static bool poolMapHuge(img_pool_buffer_t *buffer)
+{
+    size_t  len = (buffer->capacity + IMG_POOL_HUGE_PAGE_SIZE - 1) & ~(size_t)(IMG_POOL_HUGE_PAGE_SIZE - 1);
+    uint8_t *map = NULL;
+    uint8_t *aligned = NULL;
+
+    /* over-map by a huge page and unmap the unaligned head and tail */
+    map = mmap(NULL, len + IMG_POOL_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    RET_ERR(map == MAP_FAILED);
+
+    aligned = (uint8_t *)(((uintptr_t)map + IMG_POOL_HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(IMG_POOL_HUGE_PAGE_SIZE - 1));
+    if (aligned > map)
+    {
+        munmap(map, aligned - map);
+    }
+    if (aligned + len < map + len + IMG_POOL_HUGE_PAGE_SIZE)
+    {
+        munmap(aligned + len, map + len + IMG_POOL_HUGE_PAGE_SIZE - (aligned + len));
+    }
+
+    /* a hint only, the mapping works without huge pages */
+    madvise(aligned, len, MADV_HUGEPAGE);
+
+    buffer->mapping = aligned;
+    buffer->mappingLen = len;
+    buffer->capacity = len;
+    return true;
+
+error:
+    return false;
+}
+
+/**
+ * Faults in all pages of channels
+ * @param channels Channels
+ * @param len Length of channels
+ */
+static void poolPrefault(uint8_t *channels, size_t len)
+{
+#ifdef MADV_POPULATE_WRITE
+    if (!madvise(channels, len, MADV_POPULATE_WRITE))
+    {
+        return;
+    }
+#endif
+
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    for (size_t i = 0; i < len; i += pageSize)
+    {
+        ((volatile uint8_t *)channels)[i] = 0;
+    }
+}
+
+/**
+ * Allocates a buffer of a size class
+ * @param pool Pool
+ * @param sizeClass Size class
+ * @return New buffer or NULL on error
+ */
+static img_pool_buffer_t *poolBufferCreate(const img_pool_t *pool, size_t sizeClass)
+{
+    img_pool_buffer_t   *buffer = NULL;
+    void                *chunk = NULL;
+
+    RET_ERR(!(buffer = malloc(sizeof(img_pool_buffer_t))));
+    memset(buffer, 0, sizeof(img_pool_buffer_t));
+    buffer->capacity = poolClassBytes(sizeClass);
+    buffer->sizeClass = sizeClass;
+
+    if ((pool->flags & IMG_POOL_HUGE_PAGES) && buffer->capacity >= IMG_POOL_HUGE_PAGE_SIZE
+        && poolMapHuge(buffer))
+    {
+        chunk = buffer->mapping;
+    }
+    else
+    {
+        RET_ERR(posix_memalign(&chunk, IMG_ALIGN, buffer->capacity));
+    }
+
+    if (pool->flags & IMG_POOL_PREFAULT)
+    {
+        poolPrefault(chunk, buffer->capacity);
+    }
+
+    buffer->img.rChannel = chunk;
+    return buffer;
+
+error:
+    if (buffer) { free(buffer); }
+    return NULL;
+}
+
+/**
+ * Deallocates a buffer
+ * @param buffer Buffer to destroy
+ */
+static void poolBufferDestroy(img_pool_buffer_t *buffer)
+{
+    if (buffer->mapping)
+    {
+        munmap(buffer->mapping, buffer->mappingLen);
+    }
+    else
+    {
+        free(buffer->img.rChannel);
+    }
+    free(buffer);
+}
+
+img_pool_t *imgPoolCreate(size_t maxCachedBytes, unsigned flags)
+{
+    img_pool_t *pool = NULL;
+
+    RET_ERR_MSG(!(pool = malloc(sizeof(img_pool_t))), "Allocation error\n");
+    memset(pool, 0, sizeof(img_pool_t));
+    pool->flags = flags;
+    pool->maxCachedBytes = maxCachedBytes;
+    RET_ERR_MSG(pthread_mutex_init(&pool->lock, NULL), "Failed to create mutex\n");
+
+    return pool;
+
+error:
+    if (pool) { free(pool); }
+    return NULL;
+}
+
+void imgPoolSetMaxCachedBuffers(img_pool_t *pool, size_t maxCachedBuffers)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->maxCachedBuffers = maxCachedBuffers;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void imgPoolDestroy(img_pool_t *pool)
+{
+    if (!pool)
+    {
+        return;
+    }
+
+    imgPoolTrim(pool);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+image_t *imgPoolAcquire(img_pool_t *pool, size_t width, size_t height)
+{
+    img_pool_buffer_t   *buffer = NULL;
+    size_t              stride = IMG_ROW_STRIDE(width);
+    size_t              bytes = sizeof(uint8_t) * stride * height * 3 + IMG_CHANNEL_SLACK;
+    size_t              sizeClass = poolSizeClass(bytes);
+
+    RET_ERR_MSG(!pool, "NULL pool\n");
+    RET_ERR_MSG(sizeClass >= IMG_POOL_N_CLASSES, "Image too large\n");
+
+    pthread_mutex_lock(&pool->lock);
+    if ((buffer = pool->free[sizeClass]))
+    {
+        pool->free[sizeClass] = buffer->next;
+        pool->stats.hits++;
+        pool->stats.nCached--;
+        pool->stats.cachedBytes -= buffer->capacity;
+    }
+    else
+    {
+        pool->stats.misses++;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    /* new buffers are allocated out of the lock, faulting pages in may take a while */
+    if (!buffer)
+    {
+        RET_ERR_MSG(!(buffer = poolBufferCreate(pool, sizeClass)), "Allocation error\n");
+
+        pthread_mutex_lock(&pool->lock);
+        pool->stats.nBuffers++;
+        pool->stats.allocatedBytes += buffer->capacity;
+        if (pool->stats.allocatedBytes > pool->stats.peakAllocatedBytes)
+        {
+            pool->stats.peakAllocatedBytes = pool->stats.allocatedBytes;
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    buffer->next = NULL;
+    buffer->img.width = width;
+    buffer->img.height = height;
+    buffer->img.stride = stride;
+    buffer->img.gChannel = buffer->img.rChannel + sizeof(uint8_t) * stride * height;
+    buffer->img.bChannel = buffer->img.gChannel + sizeof(uint8_t) * stride * height;
+    buffer->img.pool = pool;
+    return &buffer->img;
+
+error:
+    return NULL;
+}
+
+void imgPoolRelease(image_t *img)
+{
+    img_pool_buffer_t   *buffer = (img_pool_buffer_t *)img;
+    img_pool_t          *pool = NULL;
+    bool                keep = false;
+
+    if (!img || !img->pool)
+    {
+        return;
+    }
+
+    pool = img->pool;
+    img->width = 0;
+    img->height = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    keep = (!pool->maxCachedBytes || pool->stats.cachedBytes + buffer->capacity <= pool->maxCachedBytes)
+            && (!pool->maxCachedBuffers || pool->stats.nCached < pool->maxCachedBuffers);
+    if (keep)
+    {
+        buffer->next = pool->free[buffer->sizeClass];
+        pool->free[buffer->sizeClass] = buffer;
+        pool->stats.nCached++;
+        pool->stats.cachedBytes += buffer->capacity;
+    }
+    else
+    {
+        pool->stats.nBuffers--;
+        pool->stats.allocatedBytes -= buffer->capacity;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    if (!keep)
+    {
+        poolBufferDestroy(buffer);
+    }
+}
+
+void imgPoolTrim(img_pool_t *pool)
+{
+    img_pool_buffer_t *released = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+    for (size_t sizeClass = 0; sizeClass < IMG_POOL_N_CLASSES; sizeClass++)
+    {
+        while (pool->free[sizeClass])
+        {
+            img_pool_buffer_t *buffer = pool->free[sizeClass];
+
+            pool->free[sizeClass] = buffer->next;
+            pool->stats.nBuffers--;
+            pool->stats.allocatedBytes -= buffer->capacity;
+            buffer->next = released;
+            released = buffer;
+        }
+    }
+    pool->stats.nCached = 0;
+    pool->stats.cachedBytes = 0;
+    pthread_mutex_unlock(&pool->lock);
+
+    while (released)
+    {
+        img_pool_buffer_t *next = released->next;
+        poolBufferDestroy(released);
+        released = next;
+    }
+}
+
+void imgPoolStats(img_pool_t *pool, img_pool_stats_t *stats)
+{
+    pthread_mutex_lock(&pool->lock);
+    *stats = pool->stats;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void imgPoolSetDefault(img_pool_t *pool)
+{
+    defaultPool = pool;
+}
+
+img_pool_t *imgPoolDefault(void)
+{
+    return defaultPool;
+}
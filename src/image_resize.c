@@ -1,79 +1,153 @@
-#include "image.h"
+#include "image_resize.h"
+#include "resize_fixed.h"
 
-image_t *imgResize(const image_t *img, size_t newWidth, size_t newHeight)
+void resizeHorizontalFloatScalar(const img_resize_plan_t *plan, const uint8_t *row, float *hRow)
 {
-    float           sr = 0.0;               // row scale
-    float           sc = 0.0;               // column scale
-    size_t          height = 0;
-    size_t          width = 0;
-    const uint8_t   *rChannel = NULL;
-    const uint8_t   *gChannel = NULL;
-    const uint8_t   *bChannel = NULL;
-    image_t         *newImg = NULL;
-    uint8_t         *newRChannel = NULL;
-    uint8_t         *newGChannel = NULL;
-    uint8_t         *newBChannel = NULL;
-
-    RET_ERR_MSG(!img, "NULL image\n");
-    RET_ERR_MSG(newWidth <= 1 || newHeight <= 1, "Invalid dimension\n");
-
-    RET_ERR_MSG(!(newImg = imgCreate(newWidth, newHeight)), "Allocation error\n");
-
-    height = img->height;
-    width = img->width;
-    rChannel = img->rChannel;
-    gChannel = img->gChannel;
-    bChannel = img->bChannel;
-    newRChannel = newImg->rChannel;
-    newGChannel = newImg->gChannel;
-    newBChannel = newImg->bChannel;
-    sr = (float)height / (float)newHeight;
-    sc = (float)width / (float)newWidth;
-
-
-    float rf = 0.0;
-    for (size_t rNew = 0; rNew < newHeight; rNew++, rf += sr)
+    for (size_t cNew = 0; cNew < plan->newWidth; cNew++)
     {
-        size_t r = (size_t)rf;
-        r = (r > height - 2) ? height - 2 : r;
-        float deltaR = rf - r;
-        float oneMinusDeltaR = 1.0 - deltaR;
+        hRow[cNew] = resizeHorizontalFloatPixel(row, plan->cTable[cNew], plan->deltaCTable[cNew]);
+    }
+}
+
+void resizeVerticalFloatScalar(const float *h0Row, const float *h1Row, float deltaR,
+                               uint8_t *newRow, size_t newWidth)
+{
+    for (size_t cNew = 0; cNew < newWidth; cNew++)
+    {
+        newRow[cNew] = resizeVerticalFloatPixel(h0Row[cNew], h1Row[cNew], deltaR);
+    }
+}
 
-        float cf = 0.0;
-        for (size_t cNew = 0; cNew < newWidth; cNew++, cf += sc)
+void resizeHorizontalPackedScalar(const img_resize_plan_t *plan, const uint8_t *row, size_t nChannels,
+                                  float *hRow)
+{
+    for (size_t cNew = 0; cNew < plan->newWidth; cNew++, hRow += nChannels)
+    {
+        const uint8_t *pixel = &row[plan->cTable[cNew] * nChannels];
+        for (size_t ch = 0; ch < nChannels; ch++)
         {
-            size_t c = (size_t)cf;
-            c = (c > width - 2) ? width - 2 : c;
-            float deltaC = cf - c;
-            float w1 = oneMinusDeltaR * (1.0 - deltaC);
-            float w2 = deltaR * (1.0 - deltaC);
-            float w3 = oneMinusDeltaR * deltaC;
-            float w4 = deltaR * deltaC;
-
-            float redNew = imgReadChannel(rChannel, width, r, c) * w1
-                            + imgReadChannel(rChannel, width, r + 1, c) * w2
-                            + imgReadChannel(rChannel, width, r, c + 1) * w3
-                            + imgReadChannel(rChannel, width, r + 1, c + 1) * w4;
-
-            float greenNew = imgReadChannel(gChannel, width, r, c) * w1
-                            + imgReadChannel(gChannel, width, r + 1, c) * w2
-                            + imgReadChannel(gChannel, width, r, c + 1) * w3
-                            + imgReadChannel(gChannel, width, r + 1, c + 1) * w4;
-
-            float blueNew = imgReadChannel(bChannel, width, r, c) * w1
-                            + imgReadChannel(bChannel, width, r + 1, c) * w2
-                            + imgReadChannel(bChannel, width, r, c + 1) * w3
-                            + imgReadChannel(bChannel, width, r + 1, c + 1) * w4;
-
-            imgWriteChannel(newRChannel, newWidth, rNew, cNew, redNew);
-            imgWriteChannel(newGChannel, newWidth, rNew, cNew, greenNew);
-            imgWriteChannel(newBChannel, newWidth, rNew, cNew, blueNew);
+            hRow[ch] = resizeHorizontalPackedPixel(&pixel[ch], nChannels, plan->deltaCTable[cNew]);
         }
     }
+}
 
-    return newImg;
+void resizeHorizontalFixedScalar(const img_resize_plan_t *plan, const uint8_t *row, uint16_t *hRow)
+{
+    for (size_t cNew = 0; cNew < plan->newWidth; cNew++)
+    {
+        hRow[cNew] = resizeFixedHorizontal(row, plan->cFixedTable[cNew], plan->wFixedTable[cNew] >> 8);
+    }
+}
 
-error:
-    if (newImg) { imgDestroy(newImg); }
-    return NULL;
-}
\ No newline at end of file
+void resizeVerticalFixedScalar(const uint16_t *h0Row, const uint16_t *h1Row, uint8_t fy,
+                               uint8_t *newRow, size_t newWidth)
+{
+    for (size_t cNew = 0; cNew < newWidth; cNew++)
+    {
+        newRow[cNew] = resizeFixedVertical(h0Row[cNew], h1Row[cNew], fy);
+    }
+}
+
+void resizeVerticalAreaScalar(const uint8_t *row, float weight, float *accRow, size_t width)
+{
+    for (size_t c = 0; c < width; c++)
+    {
+        accRow[c] = resizeVerticalAreaPixel(accRow[c], weight, row[c]);
+    }
+}
+
+void resizeVerticalAreaSplitScalar(const uint8_t *row, float weight, float *accRow, float nextWeight,
+                                   float *nextAccRow, size_t width)
+{
+    for (size_t c = 0; c < width; c++)
+    {
+        accRow[c] = resizeVerticalAreaPixel(accRow[c], weight, row[c]);
+        nextAccRow[c] = resizeVerticalAreaPixel(0.0f, nextWeight, row[c]);
+    }
+}
+
+void resizeHorizontalFilterScalar(const resize_filter_plan_t *plan, const uint8_t *row, int16_t *hRow)
+{
+    for (size_t cNew = 0; cNew < plan->newWidth; cNew++)
+    {
+        const uint8_t   *p = &row[plan->cStart[cNew]];
+        int32_t         acc = 0;
+
+        for (size_t tap = 0; tap < plan->nTapsX; tap++)
+        {
+            acc += resizeFilterWeightX(plan, cNew, tap) * p[tap];
+        }
+
+        hRow[cNew] = (int16_t)((acc + (1 << (RESIZE_FILTER_W_BITS - RESIZE_FILTER_H_BITS - 1)))
+                                >> (RESIZE_FILTER_W_BITS - RESIZE_FILTER_H_BITS));
+    }
+}
+
+void resizeVerticalFilterScalar(const int16_t *const *rows, const int16_t *weights, size_t nTaps,
+                                uint8_t *newRow, size_t newWidth)
+{
+    for (size_t cNew = 0; cNew < newWidth; cNew++)
+    {
+        int32_t acc = 0;
+
+        for (size_t tap = 0; tap < nTaps; tap++)
+        {
+            acc += weights[tap] * rows[tap][cNew];
+        }
+
+        newRow[cNew] = resizeFilterPixel(acc);
+    }
+}
+
+void resizeDownscaleRatioScalar(const uint8_t *row, size_t factorLog2, uint8_t *newRow, size_t newWidth)
+{
+    for (size_t cNew = 0; cNew < newWidth; cNew++)
+    {
+        newRow[cNew] = row[cNew << factorLog2];
+    }
+}
+
+/**
+ * Interpolates a new row of an integer ratio upscale
+ * Called with constant factors, so the loops are specialized for each of them
+ * @param row0 Upper source row
+ * @param row1 Lower source row
+ * @param fy Vertical phase of the new row
+ * @param factorLog2 Log2 of the upscale factor
+ * @param newRow Row to store the result to
+ * @param width Source row length
+ */
+static inline void upscaleRatioRow(const uint8_t *row0, const uint8_t *row1, size_t fy, size_t factorLog2,
+                                   uint8_t *newRow, size_t width)
+{
+    size_t f = (size_t)1 << factorLog2;
+    size_t cLast = width - 1;
+
+    for (size_t c = 0; c < cLast; c++, newRow += f)
+    {
+        for (size_t fx = 0; fx < f; fx++)
+        {
+            newRow[fx] = resizeUpscaleRatioPixel(row0[c], row0[c + 1], row1[c], row1[c + 1], fx, fy, factorLog2);
+        }
+    }
+
+    /* the last pixel is held instead of extrapolated */
+    for (size_t fx = 0; fx < f; fx++)
+    {
+        newRow[fx] = resizeUpscaleRatioPixel(row0[cLast], row0[cLast], row1[cLast], row1[cLast], fx, fy,
+                                             factorLog2);
+    }
+}
+
+void resizeUpscaleRatioScalar(const uint8_t *row0, const uint8_t *row1, size_t fy, size_t factorLog2,
+                              uint8_t *newRow, size_t width)
+{
+    if (factorLog2 == 1)
+    {
+        upscaleRatioRow(row0, row1, fy, 1, newRow, width);
+    }
+    else
+    {
+        upscaleRatioRow(row0, row1, fy, 2, newRow, width);
+    }
+}
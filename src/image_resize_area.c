@@ -0,0 +1,218 @@
+#define _POSIX_C_SOURCE 200809L
+#include <string.h>
+#include "image_resize.h"
+
+/**
+ * Computes coverage of source pixels along a single axis
+ * @param len Source length
+ * @param newLen Destination length, at most len
+ * @param first Table of first covered pixels to fill
+ * @param last Table of last covered pixels to fill
+ * @param wFirst Table of coverages of first pixels to fill
+ * @param wLast Table of coverages of last pixels to fill
+ */
+static void resizeAreaAxis(size_t len, size_t newLen, uint32_t *first, uint32_t *last, float *wFirst,
+                           float *wLast)
+{
+    double scale = (double)len / (double)newLen;
+
+    for (size_t i = 0; i < newLen; i++)
+    {
+        double begin = i * scale;
+        double end = (i + 1 == newLen) ? (double)len : (i + 1) * scale;
+        size_t iFirst = (size_t)begin;
+        size_t iLast = (size_t)end;
+
+        /* an edge on a pixel boundary does not cover the pixel past it */
+        iLast = (iLast > iFirst && (double)iLast == end) ? iLast - 1 : iLast;
+        first[i] = iFirst;
+        last[i] = iLast;
+
+        if (iFirst == iLast)
+        {
+            wFirst[i] = (float)(end - begin);
+            wLast[i] = 0.0f;
+        }
+        else
+        {
+            wFirst[i] = (float)(iFirst + 1 - begin);
+            wLast[i] = (float)(end - iLast);
+        }
+    }
+}
+
+resize_area_plan_t *resizeAreaPlanCreate(size_t width, size_t height, size_t newWidth, size_t newHeight)
+{
+    resize_area_plan_t  *plan = NULL;
+    void                *tables = NULL;
+
+    RET_ERR_MSG(!width || !height, "Invalid source dimension\n");
+    RET_ERR_MSG(!newWidth || !newHeight || newWidth > width || newHeight > height, "Invalid dimension\n");
+    RET_ERR_MSG(width > UINT32_MAX || height > UINT32_MAX, "Image too large\n");
+
+    RET_ERR_MSG(!(plan = malloc(sizeof(resize_area_plan_t))), "Allocation error\n");
+
+    /* create one memory chunk for all tables */
+    RET_ERR_MSG(!(tables = malloc((newWidth + newHeight) * (sizeof(uint32_t) * 2 + sizeof(float) * 2))),
+                "Allocation error\n");
+
+    plan->width = width;
+    plan->height = height;
+    plan->newWidth = newWidth;
+    plan->newHeight = newHeight;
+    plan->cFirst = tables;
+    plan->cLast = plan->cFirst + newWidth;
+    plan->rFirst = plan->cLast + newWidth;
+    plan->rLast = plan->rFirst + newHeight;
+    plan->cWFirst = (float *)(plan->rLast + newHeight);
+    plan->cWLast = plan->cWFirst + newWidth;
+    plan->rWFirst = plan->cWLast + newWidth;
+    plan->rWLast = plan->rWFirst + newHeight;
+    plan->norm = (float)((double)newWidth * newHeight / ((double)width * height));
+
+    resizeAreaAxis(width, newWidth, plan->cFirst, plan->cLast, plan->cWFirst, plan->cWLast);
+    resizeAreaAxis(height, newHeight, plan->rFirst, plan->rLast, plan->rWFirst, plan->rWLast);
+
+    return plan;
+
+error:
+    if (plan) { free(plan); }
+    return NULL;
+}
+
+void resizeAreaPlanDestroy(resize_area_plan_t *plan)
+{
+    if (!plan)
+    {
+        return;
+    }
+
+    free(plan->cFirst);
+    free(plan);
+}
+
+/**
+ * Sums accumulated source columns covered by every new column and rounds their means to nearest
+ * @param plan Area plan
+ * @param accRow Source row accumulated by vertical coverage
+ * @param newRow Row to store the pixels to
+ */
+static void resizeAreaFinishRow(const resize_area_plan_t *plan, const float *accRow, uint8_t *newRow)
+{
+    for (size_t cNew = 0; cNew < plan->newWidth; cNew++)
+    {
+        size_t  first = plan->cFirst[cNew];
+        size_t  last = plan->cLast[cNew];
+        float   sum = plan->cWFirst[cNew] * accRow[first];
+
+        for (size_t c = first + 1; c < last; c++)
+        {
+            sum += accRow[c];
+        }
+        sum += plan->cWLast[cNew] * accRow[last];
+
+        float v = sum * plan->norm + 0.5f;
+        newRow[cNew] = (v < 255.0f) ? (uint8_t)v : 255;
+    }
+}
+
+bool resizeBandArea(const resize_kernel_t *kernel, const resize_area_plan_t *plan, const image_t *img,
+                    image_t *newImg, size_t rBegin, size_t rEnd)
+{
+    float           *accRows[2] = { NULL, NULL };
+    void            *chunk = NULL;
+    size_t          width = 0;
+    size_t          stride = 0;
+    size_t          newStride = 0;
+    size_t          paddedWidth = 0;
+    const uint8_t   *channels[3] = { NULL, NULL, NULL };
+    uint8_t         *newChannels[3] = { NULL, NULL, NULL };
+
+    TRACE_BEGIN(resizeSpan);
+    width = img->width;
+    stride = img->stride;
+    newStride = newImg->stride;
+    paddedWidth = RESIZE_PADDED_LEN(width);
+    channels[0] = img->rChannel;
+    channels[1] = img->gChannel;
+    channels[2] = img->bChannel;
+    newChannels[0] = newImg->rChannel;
+    newChannels[1] = newImg->gChannel;
+    newChannels[2] = newImg->bChannel;
+
+    /* padding of the accumulated rows is processed by vertical primitives */
+    RET_ERR_MSG(posix_memalign(&chunk, IMG_ALIGN, sizeof(float) * 2 * paddedWidth), "Allocation error\n");
+    accRows[0] = chunk;
+    accRows[1] = accRows[0] + paddedWidth;
+
+    for (size_t ch = 0; ch < 3; ch++)
+    {
+        bool started = false;               // accRows[rNew % 2] already holds the first row of rNew
+
+        for (size_t rNew = rBegin; rNew < rEnd; rNew++)
+        {
+            float   *accRow = accRows[rNew % 2];
+            size_t  first = plan->rFirst[rNew];
+            size_t  last = plan->rLast[rNew];
+            size_t  r = first;
+
+            if (started)
+            {
+                r++;
+            }
+            else
+            {
+                memset(accRow, 0x00, sizeof(float) * paddedWidth);
+            }
+            started = false;
+
+            for ( ; r <= last; r++)
+            {
+                const uint8_t   *row = &channels[ch][r * stride];
+                float           weight = (r == first) ? plan->rWFirst[rNew] : (r == last) ? plan->rWLast[rNew] : 1.0f;
+
+                /* the last row is read once for both new rows covering it */
+                if (r == last && rNew + 1 < rEnd && plan->rFirst[rNew + 1] == r)
+                {
+                    kernel->verticalAreaSplit(row, weight, accRow, plan->rWFirst[rNew + 1], accRows[(rNew + 1) % 2],
+                                              width);
+                    started = true;
+                }
+                else
+                {
+                    kernel->verticalArea(row, weight, accRow, width);
+                }
+            }
+
+            resizeAreaFinishRow(plan, accRow, &newChannels[ch][rNew * newStride]);
+        }
+    }
+
+    free(chunk);
+    TRACE_END(resizeSpan, TRACE_RESIZE, (uint64_t)3 * newImg->width * (rEnd - rBegin),
+              (uint64_t)newImg->width * (rEnd - rBegin));
+    return true;
+
+error:
+    return false;
+}
+
+image_t *imgResizeArea(const image_t *img, size_t newWidth, size_t newHeight)
+{
+    resize_area_plan_t  *plan = NULL;
+    image_t             *newImg = NULL;
+
+    RET_ERR_MSG(!img, "NULL image\n");
+    RET_ERR_MSG(!(plan = resizeAreaPlanCreate(img->width, img->height, newWidth, newHeight)),
+                "Failed to create resize plan\n");
+    RET_ERR_MSG(!(newImg = imgCreate(newWidth, newHeight)), "Allocation error\n");
+    RET_ERR(!resizeBandArea(resizeKernel(), plan, img, newImg, 0, newHeight));
+
+    resizeAreaPlanDestroy(plan);
+    return newImg;
+
+error:
+    if (newImg) { imgDestroy(newImg); }
+    if (plan) { resizeAreaPlanDestroy(plan); }
+    return NULL;
+}
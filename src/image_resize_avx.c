@@ -1,231 +1,198 @@
-#include "image.h"
+#include <string.h>
+#include "image_resize.h"
 #include "avx_general.h"
 
-/**
- * Reads interpolated channel value
- * This function substitues the scalar alternative:
- * float redNew = imgReadChannel(rChannel, width, r, c) * (1.0 - deltaR) * (1.0 - deltaC)
- *                          + imgReadChannel(rChannel, width, r + 1, c) * deltaR * (1.0 - deltaC)
- *                          + imgReadChannel(rChannel, width, r, c + 1) * (1.0 - deltaR) * deltaC
- *                          + imgReadChannel(rChannel, width, r + 1, c + 1) * deltaR * deltaC;
- * @param channel Channel to read from
- * @param width Width of image
- * @param r Row (indexed from 0)
- * @param c_int_vec Vector of columns (indexed from 0)
- * @param delta_r_flt_vec Vector of deltaR
- * @param delta_c_flt_vec Vector of deltaC
- * @param one_minus_delta_r_flt_vec Vector of (1.0 - deltaR)
- * @param one_minus_delta_c_flt_vec Vector of (1.0 - deltaC)
- * @return Interpolated channel value vector
- */
-static inline __m256 readNewChannel(const uint8_t *channel, size_t width, size_t r, __m256i c_int_vec,
-                                    __m256 w1_vec, __m256 w2_vec, __m256 w3_vec, __m256 w4_vec)
-{
-    float values[AVX_REG_N_FLOATS] __attribute__((aligned(32)));
-    __m256 tmp_flt_vec;
-    __m256 new_val_flt_vec;
-
-    /* new_val_flt_vec = imgReadChannel(channel, width, r, c) */
-    avxImgReadChannelVec(channel, width, r, c_int_vec, 0, values);
-    new_val_flt_vec = _mm256_load_ps(&values[0]);
-
-    /* new_val_flt_vec *= (1.0 - deltaR) * (1.0 - deltaC) */
-    new_val_flt_vec = _mm256_mul_ps(new_val_flt_vec, w1_vec);
-
-
-
-    /* tmp = imgReadChannel(channel, width, r + 1, c) */
-    avxImgReadChannelVec(channel, width, r + 1, c_int_vec, 0, values);
-    tmp_flt_vec = _mm256_load_ps(&values[0]);
-
-    /* tmp *= deltaR * (1.0 - deltaC) */
-    tmp_flt_vec = _mm256_mul_ps(tmp_flt_vec, w2_vec);
-
-    /* new_val_flt_vec += tmp_flt_vec */
-    new_val_flt_vec = _mm256_add_ps(new_val_flt_vec, tmp_flt_vec);
-
-
-
-    /* tmp = imgReadChannel(channel, width, r, c + 1) */
-    avxImgReadChannelVec(channel, width, r, c_int_vec, 1, values);
-    tmp_flt_vec = _mm256_load_ps(&values[0]);
-
-    /* tmp *= (1.0 - deltaR) * deltaC */
-    tmp_flt_vec = _mm256_mul_ps(tmp_flt_vec, w3_vec);
-
-    /* new_val_flt_vec += tmp_flt_vec */
-    new_val_flt_vec = _mm256_add_ps(new_val_flt_vec, tmp_flt_vec);
-
-
-
-    /* tmp = imgReadChannel(channel, width, r + 1, c + 1) */
-    avxImgReadChannelVec(channel, width, r + 1, c_int_vec, 1, values);
-    tmp_flt_vec = _mm256_load_ps(&values[0]);
-
-    /* tmp *= deltaR * deltaC */
-    tmp_flt_vec = _mm256_mul_ps(tmp_flt_vec, w4_vec);
-
-    /* new_val_flt_vec += tmp_flt_vec */
-    new_val_flt_vec = _mm256_add_ps(new_val_flt_vec, tmp_flt_vec);  
-
-    return new_val_flt_vec;
-}
-
 /*
 ** Necessary extensions:
 **      AVX
-** Suggested additional extensions:
-**      AVX512
-**          - process 16 pixels instead of 8
+** See image_resize_avx512.c for the 16 pixel AVX512 variant
 */
 
-image_t *imgResize(const image_t *img, size_t newWidth, size_t newHeight)
+/**
+ * Zero extends 4 bytes to floats
+ * @param bytes_vec Bytes in the lowest dword
+ * @return 4 x float
+ */
+static inline __m128 bytesToFloats(__m128i bytes_vec)
 {
-    float           sr = 0.0;                                       // row scale
-    float           sc __attribute__((aligned (32))) = 0.0;         // column scale
-    uint32_t        height = 0;
-    uint32_t        width = 0;
-    const uint8_t   *rChannel = NULL;
-    const uint8_t   *gChannel = NULL;
-    const uint8_t   *bChannel = NULL;
-    image_t         *newImg = NULL;
-    uint8_t         *newRChannel = NULL;
-    uint8_t         *newGChannel = NULL;
-    uint8_t         *newBChannel = NULL;
-
-    __m256 index_vec = _mm256_set_ps(0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0);
-    __m256 eight_flt_vec = _mm256_set_ps(8.0, 8.0, 8.0, 8.0, 8.0, 8.0, 8.0, 8.0);
-    __m256 one_flt_vec = _mm256_set_ps(1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0);
-
-    RET_ERR_MSG(!img, "NULL image\n");
-    RET_ERR_MSG(newWidth <= 1 || newHeight <= 1, "Invalid dimension\n");
-
-    RET_ERR_MSG(!(newImg = imgCreate(newWidth, newHeight)), "Allocation error\n");
-
-    height = (uint32_t)img->height;
-    width = (uint32_t)img->width;
-    rChannel = img->rChannel;
-    gChannel = img->gChannel;
-    bChannel = img->bChannel;
-    newRChannel = newImg->rChannel;
-    newGChannel = newImg->gChannel;
-    newBChannel = newImg->bChannel;
-    sr = (float)height / (float)newHeight;
-    sc = (float)width / (float)newWidth;
-
-    /* max_width = width - 2 */
-    float max_width __attribute__((aligned (32))) = width - 2.0;
-    __m256 max_width_vec = _mm256_broadcast_ss(&max_width);
-
-    float rf = 0.0;
-    for (size_t rNew = 0; rNew < newHeight; rNew++, rf += sr)
-    {
-        size_t r = (size_t)rf;
-        r = (r > height - 2) ? height - 2 : r;
-        const float deltaR __attribute__((aligned (32))) = rf - r;
-        const float oneMinusDeltaR = 1.0 - deltaR;
-
-        /* deltaR = rf - r */
-        __m256 delta_r_flt_vec = _mm256_broadcast_ss(&deltaR);
-        /* (1.0 - deltaR) */
-        __m256 one_minus_delta_r_flt_vec = _mm256_broadcast_ss(&oneMinusDeltaR);
-
-        /* cf_flt_vec = [0sc | 1sc | 2sc | 3sc | 4sc | ...] */
-        __m256 sc_flt_vec = _mm256_broadcast_ss(&sc);
-        __m256 cf_flt_vec = _mm256_mul_ps(index_vec, sc_flt_vec);
-        __m256 eight_sc_flt_vec = _mm256_mul_ps(eight_flt_vec, sc_flt_vec);
-        /* process AVX_REG_N_FLOATS pixels in one iteration */
-        size_t cNew;
-        for (cNew = 0; cNew + AVX_REG_N_FLOATS < newWidth; cNew += AVX_REG_N_FLOATS)
-        {
-            __m256 new_val_flt_vec;
-
-            /* c = (uint32_t)cf */
-            __m256 c_flt_vec = _mm256_floor_ps(cf_flt_vec);
-            /* c = (c <= maxWidth) ? c : maxWidth */
-            __m256 mask_vec = _mm256_cmp_ps(c_flt_vec, max_width_vec, _CMP_LE_OS);
-            c_flt_vec = _mm256_and_ps(c_flt_vec, mask_vec);
-            mask_vec = avx_mm256_not_ps(mask_vec);
-            c_flt_vec = _mm256_or_ps(c_flt_vec, _mm256_and_ps(max_width_vec, mask_vec));
-            __m256i c_int_vec = _mm256_cvttps_epi32(c_flt_vec);
+    return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(bytes_vec));
+}
 
-            /* deltaC = cf - c */
-            __m256 delta_c_flt_vec = _mm256_sub_ps(cf_flt_vec, c_flt_vec);
-            /* (1.0 - deltaC) */
-            __m256 one_minus_delta_c_flt_vec = _mm256_sub_ps(one_flt_vec, delta_c_flt_vec);
+void resizeHorizontalFloatAvx(const img_resize_plan_t *plan, const uint8_t *row, float *hRow)
+{
+    float   p0[AVX_REG_N_FLOATS] __attribute__((aligned(32)));
+    float   p1[AVX_REG_N_FLOATS] __attribute__((aligned(32)));
+    size_t  newWidth = plan->newWidth;
 
-            /*
-                w1 = (1.0 - deltaR) * (1.0 - deltaC);
-                w2 = deltaR * (1.0 - deltaC);
-                w3 = (1.0 - deltaR) * deltaC;
-                w4 = deltaR * deltaC;
-            */
-            __m256 w1_vec = _mm256_mul_ps(one_minus_delta_r_flt_vec, one_minus_delta_c_flt_vec);
-            __m256 w2_vec = _mm256_mul_ps(delta_r_flt_vec, one_minus_delta_c_flt_vec);
-            __m256 w3_vec = _mm256_mul_ps(one_minus_delta_r_flt_vec, delta_c_flt_vec);
-            __m256 w4_vec = _mm256_mul_ps(delta_r_flt_vec, delta_c_flt_vec);
+    __m256 one_flt_vec = _mm256_set1_ps(1.0f);
 
+    /* process AVX_REG_N_FLOATS pixels in one iteration, the last one runs into the padding of the row */
+    for (size_t cNew = 0; cNew < newWidth; cNew += AVX_REG_N_FLOATS)
+    {
+        /* deltaC = plan->deltaCTable[cNew] */
+        __m256 delta_c_flt_vec = _mm256_load_ps(&plan->deltaCTable[cNew]);
+        /* (1.0 - deltaC) */
+        __m256 one_minus_delta_c_flt_vec = _mm256_sub_ps(one_flt_vec, delta_c_flt_vec);
+
+        /* p0 = row[c], p1 = row[c + 1] */
+        __m256 p0_flt_vec, p1_flt_vec;
+        if (resizeShuffleFits(plan->cTable, cNew))
+        {
+            /* bytes of the block are shuffled to (p0 x 8, p1 x 8), source rows have slack for the load */
+            __m128i src_vec = _mm_loadu_si128((const __m128i *)&row[plan->cTable[cNew]]);
+            __m128i pairs_vec = _mm_shuffle_epi8(src_vec,
+                                                 _mm_load_si128((const __m128i *)&plan->cShuffleTable[2 * cNew]));
+
+            p0_flt_vec = _mm256_insertf128_ps(_mm256_castps128_ps256(bytesToFloats(pairs_vec)),
+                                              bytesToFloats(_mm_srli_si128(pairs_vec, 4)), 1);
+            p1_flt_vec = _mm256_insertf128_ps(_mm256_castps128_ps256(bytesToFloats(_mm_srli_si128(pairs_vec, 8))),
+                                              bytesToFloats(_mm_srli_si128(pairs_vec, 12)), 1);
+        }
+        else
+        {
+            /* c = plan->cTable[cNew] */
+            __m256i c_int_vec = _mm256_load_si256((const __m256i *)&plan->cTable[cNew]);
 
+            avxImgReadChannelVec(row, 0, 0, c_int_vec, 0, p0);
+            avxImgReadChannelVec(row, 0, 0, c_int_vec, 1, p1);
+            p0_flt_vec = _mm256_load_ps(p0);
+            p1_flt_vec = _mm256_load_ps(p1);
+        }
 
-            /* new_val_flt_vec = imgReadChannel(...) * ... * + imgReadChannel(...) * ... * ... */
-            new_val_flt_vec = readNewChannel(rChannel, width, r, c_int_vec,
-                                            w1_vec, w2_vec, w3_vec, w4_vec);
+        /* h = p0 * (1.0 - deltaC) + p1 * deltaC */
+        __m256 h_flt_vec = _mm256_mul_ps(p0_flt_vec, one_minus_delta_c_flt_vec);
+        h_flt_vec = _mm256_add_ps(h_flt_vec, _mm256_mul_ps(p1_flt_vec, delta_c_flt_vec));
 
-            /* imgWriteChannel(newRChannel, newWidth, rNew, cNew, redNew) */
-            avxImgWriteChannelVec(newRChannel, newWidth, rNew, cNew, new_val_flt_vec);
+        _mm256_store_ps(&hRow[cNew], h_flt_vec);
+    }
+}
 
-            /* new_val_flt_vec = imgReadChannel(...) * ... * + imgReadChannel(...) * ... * ... */
-            new_val_flt_vec = readNewChannel(gChannel, width, r, c_int_vec,
-                                            w1_vec, w2_vec, w3_vec, w4_vec);
+/**
+ * Loads channels of a packed pixel as 4 x int32
+ * @param pixel First channel of the pixel, 4 bytes are read
+ * @return Channels
+ */
+static inline __m128i packedPixelVec(const uint8_t *pixel)
+{
+    int32_t bytes = 0;
+    memcpy(&bytes, pixel, sizeof(bytes));
+    return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes));
+}
 
-            /* imgWriteChannel(newGChannel, newWidth, rNew, cNew, redNew) */
-            avxImgWriteChannelVec(newGChannel, newWidth, rNew, cNew, new_val_flt_vec);
+void resizeHorizontalPackedAvx(const img_resize_plan_t *plan, const uint8_t *row, size_t nChannels,
+                               float *hRow)
+{
+    size_t          newWidth = plan->newWidth;
+    const uint32_t  *cTable = plan->cTable;
+    const float     *deltaCTable = plan->deltaCTable;
+
+    __m256 one_flt_vec = _mm256_set1_ps(1.0f);
+
+    /*
+    ** Two new pixels per iteration, one per 128 bit lane. RGB pixels are loaded and stored as 4 values,
+    ** so the loop stops before the right neighbour is the last source pixel (4th byte past the row)
+    ** and before the last new pixel (4th value past the row), the rest is finished by scalar code.
+    */
+    size_t cEnd = (nChannels == 4) ? plan->width : plan->width - 1;
+    size_t cNewEnd = (nChannels == 4) ? newWidth : newWidth - 1;
+
+    size_t cNew;
+    for (cNew = 0; cNew + 2 <= cNewEnd && cTable[cNew + 1] + 1 < cEnd; cNew += 2)
+    {
+        const uint8_t *pixel0 = &row[cTable[cNew] * nChannels];
+        const uint8_t *pixel1 = &row[cTable[cNew + 1] * nChannels];
+
+        /* p0 = (left pixel of cNew, left pixel of cNew + 1), p1 = their right neighbours */
+        __m256 p0_flt_vec = _mm256_cvtepi32_ps(_mm256_insertf128_si256(
+                    _mm256_castsi128_si256(packedPixelVec(pixel0)), packedPixelVec(pixel1), 1));
+        __m256 p1_flt_vec = _mm256_cvtepi32_ps(_mm256_insertf128_si256(
+                    _mm256_castsi128_si256(packedPixelVec(pixel0 + nChannels)),
+                    packedPixelVec(pixel1 + nChannels), 1));
+        __m256 delta_c_flt_vec = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(deltaCTable[cNew])),
+                                                      _mm_set1_ps(deltaCTable[cNew + 1]), 1);
+
+        /* h = p0 * (1.0 - deltaC) + p1 * deltaC */
+        __m256 h_flt_vec = _mm256_mul_ps(p0_flt_vec, _mm256_sub_ps(one_flt_vec, delta_c_flt_vec));
+        h_flt_vec = _mm256_add_ps(h_flt_vec, _mm256_mul_ps(p1_flt_vec, delta_c_flt_vec));
+
+        /* RGB: the 4th value of the first pixel is overwritten by the second one */
+        _mm_storeu_ps(&hRow[cNew * nChannels], _mm256_castps256_ps128(h_flt_vec));
+        _mm_storeu_ps(&hRow[(cNew + 1) * nChannels], _mm256_extractf128_ps(h_flt_vec, 1));
+    }
 
-            /* new_val_flt_vec = imgReadChannel(...) * ... * + imgReadChannel(...) * ... * ... */
-            new_val_flt_vec = readNewChannel(bChannel, width, r, c_int_vec,
-                                            w1_vec, w2_vec, w3_vec, w4_vec);
+    /* finished the rest */
+    for ( ; cNew < newWidth; cNew++)
+    {
+        const uint8_t *pixel = &row[cTable[cNew] * nChannels];
+        for (size_t ch = 0; ch < nChannels; ch++)
+        {
+            hRow[cNew * nChannels + ch] = resizeHorizontalPackedPixel(&pixel[ch], nChannels, deltaCTable[cNew]);
+        }
+    }
+}
 
-            /* imgWriteChannel(newBChannel, newWidth, rNew, cNew, redNew) */
-            avxImgWriteChannelVec(newBChannel, newWidth, rNew, cNew, new_val_flt_vec);
+void resizeVerticalFloatAvx(const float *h0Row, const float *h1Row, float deltaR,
+                            uint8_t *newRow, size_t newWidth)
+{
+    const float oneMinusDeltaR = 1.0f - deltaR;
 
+    /* deltaR */
+    __m256 delta_r_flt_vec = _mm256_broadcast_ss(&deltaR);
+    /* (1.0 - deltaR) */
+    __m256 one_minus_delta_r_flt_vec = _mm256_broadcast_ss(&oneMinusDeltaR);
 
+    /* process AVX_REG_N_FLOATS pixels in one iteration, the last one runs into the padding of the rows */
+    for (size_t cNew = 0; cNew < newWidth; cNew += AVX_REG_N_FLOATS)
+    {
+        /* v = h0 * (1.0 - deltaR) + h1 * deltaR */
+        __m256 v_flt_vec = _mm256_mul_ps(_mm256_load_ps(&h0Row[cNew]), one_minus_delta_r_flt_vec);
+        v_flt_vec = _mm256_add_ps(v_flt_vec, _mm256_mul_ps(_mm256_load_ps(&h1Row[cNew]), delta_r_flt_vec));
+
+        /* truncate and pack 8 x int32 to 8 x uint8 */
+        __m256i v_int_vec = _mm256_cvttps_epi32(v_flt_vec);
+        __m128i v_words_vec = _mm_packus_epi32(_mm256_castsi256_si128(v_int_vec),
+                                               _mm256_extractf128_si256(v_int_vec, 1));
+        _mm_storel_epi64((__m128i *)&newRow[cNew], _mm_packus_epi16(v_words_vec, v_words_vec));
+    }
+}
 
-            /* cf = (8 * sc) + cf */
-            cf_flt_vec = _mm256_add_ps(eight_sc_flt_vec, cf_flt_vec);
-        }
+void resizeVerticalAreaAvx(const uint8_t *row, float weight, float *accRow, size_t width)
+{
+    __m256 weight_flt_vec = _mm256_broadcast_ss(&weight);
 
-        /* finished the rest */
-        float cf = cNew * sc;
-        for ( ; cNew < newWidth; cNew++, cf += sc)
-        {
-            size_t c = (size_t)cf;
-            c = (c > width - 2) ? width - 2 : c;
-            float deltaC = cf - c;
-
-            float redNew = imgReadChannel(rChannel, width, r, c) * (1.0 - deltaR) * (1.0 - deltaC)
-                            + imgReadChannel(rChannel, width, r + 1, c) * deltaR * (1.0 - deltaC)
-                            + imgReadChannel(rChannel, width, r, c + 1) * (1.0 - deltaR) * deltaC
-                            + imgReadChannel(rChannel, width, r + 1, c + 1) * deltaR * deltaC;
-
-            float greenNew = imgReadChannel(gChannel, width, r, c) * (1.0 - deltaR) * (1.0 - deltaC)
-                            + imgReadChannel(gChannel, width, r + 1, c) * deltaR * (1.0 - deltaC)
-                            + imgReadChannel(gChannel, width, r, c + 1) * (1.0 - deltaR) * deltaC
-                            + imgReadChannel(gChannel, width, r + 1, c + 1) * deltaR * deltaC;
-
-            float blueNew = imgReadChannel(bChannel, width, r, c) * (1.0 - deltaR) * (1.0 - deltaC)
-                            + imgReadChannel(bChannel, width, r + 1, c) * deltaR * (1.0 - deltaC)
-                            + imgReadChannel(bChannel, width, r, c + 1) * (1.0 - deltaR) * deltaC
-                            + imgReadChannel(bChannel, width, r + 1, c + 1) * deltaR * deltaC;
-
-            imgWriteChannel(newRChannel, newWidth, rNew, cNew, redNew);
-            imgWriteChannel(newGChannel, newWidth, rNew, cNew, greenNew);
-            imgWriteChannel(newBChannel, newWidth, rNew, cNew, blueNew);
-        }
+    /* process AVX_REG_N_FLOATS pixels in one iteration, the last one runs into the padding of the rows */
+    for (size_t c = 0; c < width; c += AVX_REG_N_FLOATS)
+    {
+        /* 8 x uint8 to 8 x float */
+        __m128i p_vec = _mm_loadl_epi64((const __m128i *)&row[c]);
+        __m256i p_int_vec = _mm256_insertf128_si256(_mm256_castsi128_si256(_mm_cvtepu8_epi32(p_vec)),
+                                                    _mm_cvtepu8_epi32(_mm_srli_si128(p_vec, 4)), 1);
+
+        /* acc = acc + weight * p */
+        __m256 acc_flt_vec = _mm256_add_ps(_mm256_load_ps(&accRow[c]),
+                                           _mm256_mul_ps(weight_flt_vec, _mm256_cvtepi32_ps(p_int_vec)));
+        _mm256_store_ps(&accRow[c], acc_flt_vec);
     }
+}
 
-    return newImg;
+void resizeVerticalAreaSplitAvx(const uint8_t *row, float weight, float *accRow, float nextWeight,
+                                float *nextAccRow, size_t width)
+{
+    __m256 weight_flt_vec = _mm256_broadcast_ss(&weight);
+    __m256 next_weight_flt_vec = _mm256_broadcast_ss(&nextWeight);
 
-error:
-    if (newImg) { imgDestroy(newImg); }
-    return NULL;
-}
\ No newline at end of file
+    /* process AVX_REG_N_FLOATS pixels in one iteration, the last one runs into the padding of the rows */
+    for (size_t c = 0; c < width; c += AVX_REG_N_FLOATS)
+    {
+        /* 8 x uint8 to 8 x float */
+        __m128i p_vec = _mm_loadl_epi64((const __m128i *)&row[c]);
+        __m256i p_int_vec = _mm256_insertf128_si256(_mm256_castsi128_si256(_mm_cvtepu8_epi32(p_vec)),
+                                                    _mm_cvtepu8_epi32(_mm_srli_si128(p_vec, 4)), 1);
+        __m256 p_flt_vec = _mm256_cvtepi32_ps(p_int_vec);
+
+        /* acc = acc + weight * p, next = nextWeight * p */
+        __m256 acc_flt_vec = _mm256_add_ps(_mm256_load_ps(&accRow[c]), _mm256_mul_ps(weight_flt_vec, p_flt_vec));
+        _mm256_store_ps(&accRow[c], acc_flt_vec);
+        _mm256_store_ps(&nextAccRow[c], _mm256_mul_ps(next_weight_flt_vec, p_flt_vec));
+    }
+}
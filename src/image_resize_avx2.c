@@ -0,0 +1,357 @@
+#include "image_resize.h"
+#include "avx_general.h"
+#include "resize_fixed.h"
+
+#define AVX2_REG_N_WORDS        16
+
+/**
+ * Horizontally interpolates 16 pixels of a row
+ * This function substitues the scalar alternative resizeFixedHorizontal()
+ * @param row Source row
+ * @param c_lo_vec Columns of pixels 0 .. 7
+ * @param c_hi_vec Columns of pixels 8 .. 15
+ * @param w_vec Byte pairs of weights (128 - fx, fx)
+ * @return Interpolated values scaled by RESIZE_FIXED_ONE, 16 x uint16
+ */
+static inline __m256i horizontalFixed(const uint8_t *row, __m256i c_lo_vec, __m256i c_hi_vec,
+                                      __m256i w_vec)
+{
+    const __m256i low_word_mask_vec = _mm256_set1_epi32(0x0000FFFF);
+    const __m256i sign_flip_vec = _mm256_set1_epi8((char)0x80);
+    const __m256i bias_vec = _mm256_set1_epi16(RESIZE_FIXED_ONE * 128);
+
+    /* load (p[c], p[c + 1], ...) dwords, over-read is covered by IMG_CHANNEL_SLACK */
+    __m256i lo_vec = _mm256_i32gather_epi32((const int *)row, c_lo_vec, 1);
+    __m256i hi_vec = _mm256_i32gather_epi32((const int *)row, c_hi_vec, 1);
+
+    /* keep the (p[c], p[c + 1]) pairs only and pack them to 16 words */
+    lo_vec = _mm256_and_si256(lo_vec, low_word_mask_vec);
+    hi_vec = _mm256_and_si256(hi_vec, low_word_mask_vec);
+    __m256i pairs_vec = _mm256_packus_epi32(lo_vec, hi_vec);
+    pairs_vec = _mm256_permute4x64_epi64(pairs_vec, 0xD8);
+
+    /* p - 128 fits signed bytes, (p0 - 128) * w0 + (p1 - 128) * w1 never saturates */
+    pairs_vec = _mm256_xor_si256(pairs_vec, sign_flip_vec);
+    __m256i h_vec = _mm256_maddubs_epi16(w_vec, pairs_vec);
+
+    /* add back 128 * (w0 + w1) */
+    return _mm256_add_epi16(h_vec, bias_vec);
+}
+
+/**
+ * Vertically interpolates and rounds 16 pixels
+ * This function substitues the scalar alternative resizeFixedVertical()
+ * @param h0_vec Upper row values
+ * @param h1_vec Lower row values
+ * @param fy_vec Vector of fy << 8
+ * @return Pixel values, 16 x uint16
+ */
+static inline __m256i verticalFixed(__m256i h0_vec, __m256i h1_vec, __m256i fy_vec)
+{
+    const __m256i half_vec = _mm256_set1_epi16(RESIZE_FIXED_ONE >> 1);
+
+    __m256i v_vec = _mm256_mulhrs_epi16(_mm256_sub_epi16(h1_vec, h0_vec), fy_vec);
+    v_vec = _mm256_add_epi16(h0_vec, v_vec);
+    v_vec = _mm256_add_epi16(v_vec, half_vec);
+    return _mm256_srli_epi16(v_vec, RESIZE_FIXED_FRAC_BITS);
+}
+
+/*
+** Necessary extensions:
+**      AVX2
+** Processes 16 pixels per iteration with 16 bit fixed-point arithmetic
+*/
+
+void resizeHorizontalFixedAvx2(const img_resize_plan_t *plan, const uint8_t *row, uint16_t *hRow)
+{
+    size_t          newWidth = plan->newWidth;
+    const int32_t   *cTable = plan->cFixedTable;
+    const uint16_t  *wTable = plan->wFixedTable;
+
+    /* process AVX2_REG_N_WORDS pixels in one iteration */
+    size_t cNew;
+    for (cNew = 0; cNew + AVX2_REG_N_WORDS <= newWidth; cNew += AVX2_REG_N_WORDS)
+    {
+        __m256i c_lo_vec = _mm256_loadu_si256((const __m256i *)&cTable[cNew]);
+        __m256i c_hi_vec = _mm256_loadu_si256((const __m256i *)&cTable[cNew + 8]);
+        __m256i w_vec = _mm256_loadu_si256((const __m256i *)&wTable[cNew]);
+
+        _mm256_storeu_si256((__m256i *)&hRow[cNew], horizontalFixed(row, c_lo_vec, c_hi_vec, w_vec));
+    }
+
+    /* finished the rest */
+    for ( ; cNew < newWidth; cNew++)
+    {
+        hRow[cNew] = resizeFixedHorizontal(row, cTable[cNew], wTable[cNew] >> 8);
+    }
+}
+
+void resizeVerticalFixedAvx2(const uint16_t *h0Row, const uint16_t *h1Row, uint8_t fy,
+                             uint8_t *newRow, size_t newWidth)
+{
+    __m256i fy_vec = _mm256_set1_epi16((int16_t)(fy << 8));
+
+    /* process AVX2_REG_N_WORDS pixels in one iteration, rows are contiguous */
+    size_t cNew;
+    for (cNew = 0; cNew + AVX2_REG_N_WORDS <= newWidth; cNew += AVX2_REG_N_WORDS)
+    {
+        __m256i h0_vec = _mm256_loadu_si256((const __m256i *)&h0Row[cNew]);
+        __m256i h1_vec = _mm256_loadu_si256((const __m256i *)&h1Row[cNew]);
+        __m256i v_vec = verticalFixed(h0_vec, h1_vec, fy_vec);
+
+        /* 16 words to 16 bytes */
+        __m256i bytes_vec = _mm256_packus_epi16(v_vec, v_vec);
+        bytes_vec = _mm256_permute4x64_epi64(bytes_vec, 0xD8);
+        _mm_storeu_si128((__m128i *)&newRow[cNew], _mm256_castsi256_si128(bytes_vec));
+    }
+
+    /* finished the rest */
+    for ( ; cNew < newWidth; cNew++)
+    {
+        newRow[cNew] = resizeFixedVertical(h0Row[cNew], h1Row[cNew], fy);
+    }
+}
+
+void resizeVerticalAreaAvx2(const uint8_t *row, float weight, float *accRow, size_t width)
+{
+    __m256 weight_flt_vec = _mm256_set1_ps(weight);
+
+    /* process 2 x AVX_REG_N_FLOATS pixels in one iteration, the last one runs into the padding of the rows */
+    for (size_t c = 0; c < width; c += 2 * AVX_REG_N_FLOATS)
+    {
+        __m128i p_vec = _mm_loadu_si128((const __m128i *)&row[c]);
+        __m256 p0_flt_vec = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(p_vec));
+        __m256 p1_flt_vec = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(p_vec, 8)));
+
+        /* acc = acc + weight * p */
+        _mm256_store_ps(&accRow[c], _mm256_add_ps(_mm256_load_ps(&accRow[c]),
+                                                  _mm256_mul_ps(weight_flt_vec, p0_flt_vec)));
+        _mm256_store_ps(&accRow[c + AVX_REG_N_FLOATS],
+                        _mm256_add_ps(_mm256_load_ps(&accRow[c + AVX_REG_N_FLOATS]),
+                                      _mm256_mul_ps(weight_flt_vec, p1_flt_vec)));
+    }
+}
+
+void resizeVerticalAreaSplitAvx2(const uint8_t *row, float weight, float *accRow, float nextWeight,
+                                 float *nextAccRow, size_t width)
+{
+    __m256 weight_flt_vec = _mm256_set1_ps(weight);
+    __m256 next_weight_flt_vec = _mm256_set1_ps(nextWeight);
+
+    /* process 2 x AVX_REG_N_FLOATS pixels in one iteration, the last one runs into the padding of the rows */
+    for (size_t c = 0; c < width; c += 2 * AVX_REG_N_FLOATS)
+    {
+        __m128i p_vec = _mm_loadu_si128((const __m128i *)&row[c]);
+        __m256 p0_flt_vec = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(p_vec));
+        __m256 p1_flt_vec = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(p_vec, 8)));
+
+        /* acc = acc + weight * p, next = nextWeight * p */
+        _mm256_store_ps(&accRow[c], _mm256_add_ps(_mm256_load_ps(&accRow[c]),
+                                                  _mm256_mul_ps(weight_flt_vec, p0_flt_vec)));
+        _mm256_store_ps(&accRow[c + AVX_REG_N_FLOATS],
+                        _mm256_add_ps(_mm256_load_ps(&accRow[c + AVX_REG_N_FLOATS]),
+                                      _mm256_mul_ps(weight_flt_vec, p1_flt_vec)));
+        _mm256_store_ps(&nextAccRow[c], _mm256_mul_ps(next_weight_flt_vec, p0_flt_vec));
+        _mm256_store_ps(&nextAccRow[c + AVX_REG_N_FLOATS], _mm256_mul_ps(next_weight_flt_vec, p1_flt_vec));
+    }
+}
+
+void resizeHorizontalFilterAvx2(const resize_filter_plan_t *plan, const uint8_t *row, int16_t *hRow)
+{
+    size_t          newWidth = plan->newWidth;
+    size_t          nTaps = plan->nTapsX;
+    const int16_t   *weights = plan->cWeights;
+
+    /* spread bytes (0, 1) and (2, 3) of every dword to words */
+    const __m256i pair01_shuffle_vec = _mm256_setr_epi8(0, -1, 1, -1, 4, -1, 5, -1, 8, -1, 9, -1, 12, -1, 13, -1,
+                                                        0, -1, 1, -1, 4, -1, 5, -1, 8, -1, 9, -1, 12, -1, 13, -1);
+    const __m256i pair23_shuffle_vec = _mm256_setr_epi8(2, -1, 3, -1, 6, -1, 7, -1, 10, -1, 11, -1, 14, -1, 15, -1,
+                                                        2, -1, 3, -1, 6, -1, 7, -1, 10, -1, 11, -1, 14, -1, 15, -1);
+    const __m256i round_vec = _mm256_set1_epi32(1 << (RESIZE_FILTER_W_BITS - RESIZE_FILTER_H_BITS - 1));
+
+    /* process RESIZE_FILTER_X_LANES pixels in one iteration, the last one runs into the padding of the row */
+    for (size_t cNew = 0; cNew < newWidth; cNew += RESIZE_FILTER_X_LANES)
+    {
+        __m256i c_vec = _mm256_load_si256((const __m256i *)&plan->cStart[cNew]);
+        __m256i acc_vec = _mm256_setzero_si256();
+
+        /* 4 taps per gather, taps past the window have zero weights, over-read is covered by padding */
+        for (size_t tap = 0; tap < nTaps; tap += 4, weights += 4 * RESIZE_FILTER_X_LANES)
+        {
+            __m256i p_vec = _mm256_i32gather_epi32((const int *)&row[tap], c_vec, 1);
+            __m256i w01_vec = _mm256_load_si256((const __m256i *)weights);
+            __m256i w23_vec = _mm256_load_si256((const __m256i *)(weights + 2 * RESIZE_FILTER_X_LANES));
+
+            acc_vec = _mm256_add_epi32(acc_vec, _mm256_madd_epi16(_mm256_shuffle_epi8(p_vec, pair01_shuffle_vec),
+                                                                  w01_vec));
+            acc_vec = _mm256_add_epi32(acc_vec, _mm256_madd_epi16(_mm256_shuffle_epi8(p_vec, pair23_shuffle_vec),
+                                                                  w23_vec));
+        }
+
+        acc_vec = _mm256_srai_epi32(_mm256_add_epi32(acc_vec, round_vec),
+                                    RESIZE_FILTER_W_BITS - RESIZE_FILTER_H_BITS);
+
+        /* 8 x int32 to 8 x int16 */
+        __m256i h_vec = _mm256_permute4x64_epi64(_mm256_packs_epi32(acc_vec, acc_vec), 0x08);
+        _mm_store_si128((__m128i *)&hRow[cNew], _mm256_castsi256_si128(h_vec));
+    }
+}
+
+void resizeVerticalFilterAvx2(const int16_t *const *rows, const int16_t *weights, size_t nTaps,
+                              uint8_t *newRow, size_t newWidth)
+{
+    const __m256i round_vec = _mm256_set1_epi32(1 << (RESIZE_FILTER_W_BITS + RESIZE_FILTER_H_BITS - 1));
+
+    /* process AVX2_REG_N_WORDS pixels in one iteration, the last one runs into the padding of the rows */
+    for (size_t cNew = 0; cNew < newWidth; cNew += AVX2_REG_N_WORDS)
+    {
+        __m256i acc_lo_vec = _mm256_setzero_si256();
+        __m256i acc_hi_vec = _mm256_setzero_si256();
+
+        /* pairs of rows, words of both rows interleaved are multiplied by the pair of weights */
+        for (size_t tap = 0; tap < nTaps; tap += 2)
+        {
+            __m256i h0_vec = _mm256_load_si256((const __m256i *)&rows[tap][cNew]);
+            __m256i h1_vec = _mm256_load_si256((const __m256i *)&rows[tap + 1][cNew]);
+            __m256i w_vec = _mm256_set1_epi32((int32_t)((uint16_t)weights[tap] | (uint32_t)(uint16_t)weights[tap + 1] << 16));
+
+            acc_lo_vec = _mm256_add_epi32(acc_lo_vec, _mm256_madd_epi16(_mm256_unpacklo_epi16(h0_vec, h1_vec), w_vec));
+            acc_hi_vec = _mm256_add_epi32(acc_hi_vec, _mm256_madd_epi16(_mm256_unpackhi_epi16(h0_vec, h1_vec), w_vec));
+        }
+
+        acc_lo_vec = _mm256_srai_epi32(_mm256_add_epi32(acc_lo_vec, round_vec),
+                                       RESIZE_FILTER_W_BITS + RESIZE_FILTER_H_BITS);
+        acc_hi_vec = _mm256_srai_epi32(_mm256_add_epi32(acc_hi_vec, round_vec),
+                                       RESIZE_FILTER_W_BITS + RESIZE_FILTER_H_BITS);
+
+        /* unpacked halves are packed back in order, saturation clamps to 0 .. 255 */
+        __m256i v_vec = _mm256_packs_epi32(acc_lo_vec, acc_hi_vec);
+        v_vec = _mm256_permute4x64_epi64(_mm256_packus_epi16(v_vec, v_vec), 0x08);
+        _mm_storeu_si128((__m128i *)&newRow[cNew], _mm256_castsi256_si128(v_vec));
+    }
+}
+
+void resizeDownscaleRatioAvx2(const uint8_t *row, size_t factorLog2, uint8_t *newRow, size_t newWidth)
+{
+    const __m256i low_byte_mask_vec = _mm256_set1_epi16(0x00FF);
+    const __m256i low_dword_byte_mask_vec = _mm256_set1_epi32(0x000000FF);
+    const __m256i dword_order_vec = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    /* 32 new pixels per iteration, the last one runs into the padding of both rows */
+    if (factorLog2 == 1)
+    {
+        for (size_t cNew = 0; cNew < newWidth; cNew += 32, row += 64)
+        {
+            /* keep even bytes, pack them and restore the order of 64 bit blocks */
+            __m256i a_vec = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)row), low_byte_mask_vec);
+            __m256i b_vec = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(row + 32)), low_byte_mask_vec);
+            __m256i v_vec = _mm256_permute4x64_epi64(_mm256_packus_epi16(a_vec, b_vec), 0xD8);
+            _mm256_storeu_si256((__m256i *)&newRow[cNew], v_vec);
+        }
+    }
+    else
+    {
+        for (size_t cNew = 0; cNew < newWidth; cNew += 32, row += 128)
+        {
+            /* keep every 4th byte, pack twice and restore the order of 32 bit blocks */
+            __m256i a_vec = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)row), low_dword_byte_mask_vec);
+            __m256i b_vec = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(row + 32)),
+                                             low_dword_byte_mask_vec);
+            __m256i c_vec = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(row + 64)),
+                                             low_dword_byte_mask_vec);
+            __m256i d_vec = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(row + 96)),
+                                             low_dword_byte_mask_vec);
+            __m256i v_vec = _mm256_packus_epi16(_mm256_packus_epi32(a_vec, b_vec), _mm256_packus_epi32(c_vec, d_vec));
+            v_vec = _mm256_permutevar8x32_epi32(v_vec, dword_order_vec);
+            _mm256_storeu_si256((__m256i *)&newRow[cNew], v_vec);
+        }
+    }
+}
+
+/**
+ * Interpolates 16 new pixels of an integer ratio upscale from pixels spread by a shuffle
+ * @param row0 Upper source row
+ * @param row1 Lower source row
+ * @param spread_vec Shuffle spreading source bytes to words of new pixels
+ * @param wp_vec Weights of left pixels, f - fx
+ * @param wq_vec Weights of right pixels, fx
+ * @param wy0_vec Weight of the upper row, f - fy
+ * @param wy1_vec Weight of the lower row, fy
+ * @param shift 2 * factorLog2
+ * @return New pixels, 16 x uint16
+ */
+static inline __m256i upscaleRatio(const uint8_t *row0, const uint8_t *row1, __m256i spread_vec, __m256i wp_vec,
+                                   __m256i wq_vec, __m256i wy0_vec, __m256i wy1_vec, __m128i shift)
+{
+    /* the same 16 source pixels and their right neighbours in both lanes */
+    __m256i p0_vec = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)row0));
+    __m256i q0_vec = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(row0 + 1)));
+    __m256i p1_vec = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)row1));
+    __m256i q1_vec = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(row1 + 1)));
+
+    /* h = (f - fx) * p + fx * q, no index math, every new pixel has its own fixed weights */
+    __m256i h0_vec = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_shuffle_epi8(p0_vec, spread_vec), wp_vec),
+                                      _mm256_mullo_epi16(_mm256_shuffle_epi8(q0_vec, spread_vec), wq_vec));
+    __m256i h1_vec = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_shuffle_epi8(p1_vec, spread_vec), wp_vec),
+                                      _mm256_mullo_epi16(_mm256_shuffle_epi8(q1_vec, spread_vec), wq_vec));
+
+    /* v = ((f - fy) * h0 + fy * h1) >> (2 * factorLog2), at most 255 * 16 */
+    __m256i v_vec = _mm256_add_epi16(_mm256_mullo_epi16(h0_vec, wy0_vec), _mm256_mullo_epi16(h1_vec, wy1_vec));
+    return _mm256_srl_epi16(v_vec, shift);
+}
+
+void resizeUpscaleRatioAvx2(const uint8_t *row0, const uint8_t *row1, size_t fy, size_t factorLog2,
+                            uint8_t *newRow, size_t width)
+{
+    int8_t  spread[2][32] __attribute__((aligned(32)));
+    int16_t wq[16] __attribute__((aligned(32)));
+    size_t  f = (size_t)1 << factorLog2;
+    size_t  step = 32 >> factorLog2;        // source pixels per iteration
+
+    /*
+    ** Word k of lane l of the first vector is new pixel l * 8 + k, the second vector continues at
+    ** 16 new pixels. Source bytes are spread to words, the high bytes are zeroed.
+    */
+    for (size_t v = 0; v < 2; v++)
+    {
+        for (size_t i = 0; i < 16; i++)
+        {
+            size_t l = i / 8;
+            size_t k = i % 8;
+            spread[v][i * 2] = (int8_t)((v * 16 + l * 8 + k) >> factorLog2);
+            spread[v][i * 2 + 1] = -1;
+        }
+    }
+    for (size_t i = 0; i < 16; i++)
+    {
+        wq[i] = (int16_t)(i & (f - 1));
+    }
+
+    const __m256i spread_a_vec = _mm256_load_si256((const __m256i *)spread[0]);
+    const __m256i spread_b_vec = _mm256_load_si256((const __m256i *)spread[1]);
+    const __m256i wq_vec = _mm256_load_si256((const __m256i *)wq);
+    const __m256i wp_vec = _mm256_sub_epi16(_mm256_set1_epi16((int16_t)f), wq_vec);
+    const __m256i wy0_vec = _mm256_set1_epi16((int16_t)(f - fy));
+    const __m256i wy1_vec = _mm256_set1_epi16((int16_t)fy);
+    const __m128i shift = _mm_cvtsi32_si128((int)(2 * factorLog2));
+
+    /*
+    ** 32 new pixels per iteration, the last one runs into the padding of both rows. Lanes of the spread
+    ** vectors are shuffled separately, so the halves come out as (a lo, b lo | a hi, b hi).
+    */
+    for (size_t c = 0; c < width; c += step)
+    {
+        __m256i a_vec = upscaleRatio(&row0[c], &row1[c], spread_a_vec, wp_vec, wq_vec, wy0_vec, wy1_vec, shift);
+        __m256i b_vec = upscaleRatio(&row0[c], &row1[c], spread_b_vec, wp_vec, wq_vec, wy0_vec, wy1_vec, shift);
+        __m256i v_vec = _mm256_permute4x64_epi64(_mm256_packus_epi16(a_vec, b_vec), 0xD8);
+        _mm256_storeu_si256((__m256i *)&newRow[c << factorLog2], v_vec);
+    }
+
+    /* the right neighbour of the last pixel was read from the padding, hold the last pixel instead */
+    size_t c = width - 1;
+    for (size_t fx = 0; fx < f; fx++)
+    {
+        newRow[(c << factorLog2) + fx] = resizeUpscaleRatioPixel(row0[c], row0[c], row1[c], row1[c], fx, fy,
+                                                                 factorLog2);
+    }
+}
@@ -0,0 +1,159 @@
+#include "image_resize.h"
+#include "avx512_general.h"
+#include "resize_fixed.h"
+
+/*
+** Necessary extensions:
+**      AVX512F     - float kernel, 16 pixels per iteration
+**      AVX512BW    - fixed-point kernel, 32 pixels per iteration
+** Row tails are processed with masked loads and stores, there is no scalar loop.
+*/
+
+void resizeHorizontalFloatAvx512(const img_resize_plan_t *plan, const uint8_t *row, float *hRow)
+{
+    size_t newWidth = plan->newWidth;
+
+    const __m512 one_flt_vec = _mm512_set1_ps(1.0f);
+    const __m512i byte_mask_vec = _mm512_set1_epi32(0xFF);
+
+    for (size_t cNew = 0; cNew < newWidth; cNew += AVX512_REG_N_FLOATS)
+    {
+        __mmask16 mask = avx512_tail_mask16(newWidth - cNew);
+
+        /* c = plan->cTable[cNew], deltaC = plan->deltaCTable[cNew] */
+        __m512i c_int_vec = _mm512_maskz_loadu_epi32(mask, &plan->cTable[cNew]);
+        __m512 delta_c_flt_vec = _mm512_maskz_loadu_ps(mask, &plan->deltaCTable[cNew]);
+        /* (1.0 - deltaC) */
+        __m512 one_minus_delta_c_flt_vec = _mm512_sub_ps(one_flt_vec, delta_c_flt_vec);
+
+        /* p0 = row[c], p1 = row[c + 1] */
+        __m512i pairs_vec = avx512ImgReadChannelPairVec(row, mask, c_int_vec);
+        __m512 p0_flt_vec = _mm512_cvtepi32_ps(_mm512_and_si512(pairs_vec, byte_mask_vec));
+        __m512 p1_flt_vec = _mm512_cvtepi32_ps(_mm512_and_si512(_mm512_srli_epi32(pairs_vec, 8),
+                                                                byte_mask_vec));
+
+        /* h = p0 * (1.0 - deltaC) + p1 * deltaC */
+        __m512 h_flt_vec = _mm512_mul_ps(p0_flt_vec, one_minus_delta_c_flt_vec);
+        h_flt_vec = _mm512_add_ps(h_flt_vec, _mm512_mul_ps(p1_flt_vec, delta_c_flt_vec));
+
+        _mm512_mask_storeu_ps(&hRow[cNew], mask, h_flt_vec);
+    }
+}
+
+void resizeVerticalFloatAvx512(const float *h0Row, const float *h1Row, float deltaR,
+                               uint8_t *newRow, size_t newWidth)
+{
+    /* deltaR */
+    const __m512 delta_r_flt_vec = _mm512_set1_ps(deltaR);
+    /* (1.0 - deltaR) */
+    const __m512 one_minus_delta_r_flt_vec = _mm512_set1_ps(1.0f - deltaR);
+
+    for (size_t cNew = 0; cNew < newWidth; cNew += AVX512_REG_N_FLOATS)
+    {
+        __mmask16 mask = avx512_tail_mask16(newWidth - cNew);
+
+        /* v = h0 * (1.0 - deltaR) + h1 * deltaR */
+        __m512 v_flt_vec = _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, &h0Row[cNew]),
+                                          one_minus_delta_r_flt_vec);
+        v_flt_vec = _mm512_add_ps(v_flt_vec, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, &h1Row[cNew]),
+                                                           delta_r_flt_vec));
+
+        /* truncate and narrow 16 x int32 to 16 x uint8 */
+        _mm512_mask_cvtusepi32_storeu_epi8(&newRow[cNew], mask, _mm512_cvttps_epi32(v_flt_vec));
+    }
+}
+
+void resizeHorizontalFixedAvx512(const img_resize_plan_t *plan, const uint8_t *row, uint16_t *hRow)
+{
+    size_t          newWidth = plan->newWidth;
+    const int32_t   *cTable = plan->cFixedTable;
+    const uint16_t  *wTable = plan->wFixedTable;
+
+    const __m512i low_word_mask_vec = _mm512_set1_epi32(0x0000FFFF);
+    const __m512i sign_flip_vec = _mm512_set1_epi8((char)0x80);
+    const __m512i bias_vec = _mm512_set1_epi16(RESIZE_FIXED_ONE * 128);
+    const __m512i qword_order_vec = _mm512_set_epi64(7, 5, 3, 1, 6, 4, 2, 0);
+
+    for (size_t cNew = 0; cNew < newWidth; cNew += AVX512_REG_N_WORDS)
+    {
+        __mmask32 mask = avx512_tail_mask32(newWidth - cNew);
+        __mmask16 lo_mask = (__mmask16)mask;
+        __mmask16 hi_mask = (__mmask16)(mask >> 16);
+
+        __m512i c_lo_vec = _mm512_maskz_loadu_epi32(lo_mask, &cTable[cNew]);
+        __m512i c_hi_vec = _mm512_maskz_loadu_epi32(hi_mask, &cTable[cNew + AVX512_REG_N_FLOATS]);
+        __m512i w_vec = _mm512_maskz_loadu_epi16(mask, &wTable[cNew]);
+
+        /* keep the (p[c], p[c + 1]) pairs only and pack them to 32 words */
+        __m512i lo_vec = _mm512_and_si512(avx512ImgReadChannelPairVec(row, lo_mask, c_lo_vec),
+                                          low_word_mask_vec);
+        __m512i hi_vec = _mm512_and_si512(avx512ImgReadChannelPairVec(row, hi_mask, c_hi_vec),
+                                          low_word_mask_vec);
+        __m512i pairs_vec = _mm512_packus_epi32(lo_vec, hi_vec);
+        pairs_vec = _mm512_permutexvar_epi64(qword_order_vec, pairs_vec);
+
+        /* (p0 - 128) * w0 + (p1 - 128) * w1 + 128 * (w0 + w1), see resize_fixed.h */
+        pairs_vec = _mm512_xor_si512(pairs_vec, sign_flip_vec);
+        __m512i h_vec = _mm512_add_epi16(_mm512_maddubs_epi16(w_vec, pairs_vec), bias_vec);
+
+        _mm512_mask_storeu_epi16(&hRow[cNew], mask, h_vec);
+    }
+}
+
+void resizeVerticalFixedAvx512(const uint16_t *h0Row, const uint16_t *h1Row, uint8_t fy,
+                               uint8_t *newRow, size_t newWidth)
+{
+    const __m512i fy_vec = _mm512_set1_epi16((int16_t)(fy << 8));
+    const __m512i half_vec = _mm512_set1_epi16(RESIZE_FIXED_ONE >> 1);
+
+    for (size_t cNew = 0; cNew < newWidth; cNew += AVX512_REG_N_WORDS)
+    {
+        __mmask32 mask = avx512_tail_mask32(newWidth - cNew);
+
+        __m512i h0_vec = _mm512_maskz_loadu_epi16(mask, &h0Row[cNew]);
+        __m512i h1_vec = _mm512_maskz_loadu_epi16(mask, &h1Row[cNew]);
+
+        /* v = (h0 + mulhrs(h1 - h0, fy << 8) + 64) >> 7 */
+        __m512i v_vec = _mm512_mulhrs_epi16(_mm512_sub_epi16(h1_vec, h0_vec), fy_vec);
+        v_vec = _mm512_add_epi16(_mm512_add_epi16(h0_vec, v_vec), half_vec);
+        v_vec = _mm512_srli_epi16(v_vec, RESIZE_FIXED_FRAC_BITS);
+
+        /* 32 words to 32 bytes */
+        _mm512_mask_cvtepi16_storeu_epi8(&newRow[cNew], mask, v_vec);
+    }
+}
+
+void resizeVerticalAreaAvx512(const uint8_t *row, float weight, float *accRow, size_t width)
+{
+    __m512 weight_flt_vec = _mm512_set1_ps(weight);
+
+    /* process AVX512_REG_N_FLOATS pixels in one iteration, the last one runs into the padding of the rows */
+    for (size_t c = 0; c < width; c += AVX512_REG_N_FLOATS)
+    {
+        /* 16 x uint8 to 16 x float */
+        __m512 p_flt_vec = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *)&row[c])));
+
+        /* acc = acc + weight * p */
+        __m512 acc_flt_vec = _mm512_add_ps(_mm512_load_ps(&accRow[c]), _mm512_mul_ps(weight_flt_vec, p_flt_vec));
+        _mm512_store_ps(&accRow[c], acc_flt_vec);
+    }
+}
+
+void resizeVerticalAreaSplitAvx512(const uint8_t *row, float weight, float *accRow, float nextWeight,
+                                   float *nextAccRow, size_t width)
+{
+    __m512 weight_flt_vec = _mm512_set1_ps(weight);
+    __m512 next_weight_flt_vec = _mm512_set1_ps(nextWeight);
+
+    /* process AVX512_REG_N_FLOATS pixels in one iteration, the last one runs into the padding of the rows */
+    for (size_t c = 0; c < width; c += AVX512_REG_N_FLOATS)
+    {
+        /* 16 x uint8 to 16 x float */
+        __m512 p_flt_vec = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *)&row[c])));
+
+        /* acc = acc + weight * p, next = nextWeight * p */
+        __m512 acc_flt_vec = _mm512_add_ps(_mm512_load_ps(&accRow[c]), _mm512_mul_ps(weight_flt_vec, p_flt_vec));
+        _mm512_store_ps(&accRow[c], acc_flt_vec);
+        _mm512_store_ps(&nextAccRow[c], _mm512_mul_ps(next_weight_flt_vec, p_flt_vec));
+    }
+}
@@ -0,0 +1,323 @@
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+#include "image_resize.h"
+
+#define FILTER_PI       3.14159265358979323846
+
+/* Continuous filter kernel and the radius of its support */
+typedef struct
+{
+    double (*eval)(double x);
+    double radius;
+} filter_desc_t;
+
+/**
+ * Keys cubic convolution kernel with a = -0.5 (Catmull-Rom)
+ * @param x Distance from the center in source pixels
+ * @return Weight
+ */
+static double filterBicubic(double x)
+{
+    const double a = -0.5;
+
+    x = (x < 0.0) ? -x : x;
+    if (x < 1.0)
+    {
+        return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+    }
+    if (x < 2.0)
+    {
+        return ((a * x - 5.0 * a) * x + 8.0 * a) * x - 4.0 * a;
+    }
+    return 0.0;
+}
+
+/**
+ * Lanczos kernel with 3 lobes
+ * @param x Distance from the center in source pixels
+ * @return Weight
+ */
+static double filterLanczos3(double x)
+{
+    x = (x < 0.0) ? -x : x;
+    if (x < 1e-9)
+    {
+        return 1.0;
+    }
+    if (x < 3.0)
+    {
+        return 3.0 * sin(FILTER_PI * x) * sin(FILTER_PI * x / 3.0) / (FILTER_PI * FILTER_PI * x * x);
+    }
+    return 0.0;
+}
+
+static const filter_desc_t filterDescs[] =
+{
+    [IMG_FILTER_BICUBIC]  = { filterBicubic, 2.0 },
+    [IMG_FILTER_LANCZOS3] = { filterLanczos3, 3.0 },
+};
+
+/**
+ * Number of source pixels of every window along a single axis
+ * @param desc Filter
+ * @param len Source length
+ * @param newLen Destination length
+ * @return Window length
+ */
+static size_t filterAxisTaps(const filter_desc_t *desc, size_t len, size_t newLen)
+{
+    double scale = (double)len / (double)newLen;
+    double support = desc->radius * ((scale > 1.0) ? scale : 1.0);
+    size_t nTaps = (size_t)ceil(support) * 2 + 1;
+
+    return (nTaps > len) ? len : nTaps;
+}
+
+/**
+ * Computes windows and fixed-point weights along a single axis
+ * Windows are clamped to the source, weights of pixels past the edges are folded to the edge pixels.
+ * Weights of every destination pixel sum to exactly 1 << RESIZE_FILTER_W_BITS.
+ * @param desc Filter
+ * @param len Source length
+ * @param newLen Destination length
+ * @param nTaps Window length
+ * @param start Table of first window pixels to fill
+ * @param weights Table of nTaps weights of every destination pixel to fill
+ * @param tmp Temporary space of nTaps doubles
+ */
+static void filterAxis(const filter_desc_t *desc, size_t len, size_t newLen, size_t nTaps, uint32_t *start,
+                       int16_t *weights, double *tmp)
+{
+    double scale = (double)len / (double)newLen;
+    double fscale = (scale > 1.0) ? scale : 1.0;
+    double support = desc->radius * fscale;
+
+    for (size_t i = 0; i < newLen; i++, weights += nTaps)
+    {
+        double      center = (i + 0.5) * scale;
+        ptrdiff_t   first = (ptrdiff_t)floor(center - support + 0.5);
+        ptrdiff_t   last = (ptrdiff_t)floor(center + support + 0.5);
+        ptrdiff_t   s = first;
+        double      sum = 0.0;
+        int32_t     qSum = 0;
+        size_t      largest = 0;
+
+        s = (s + (ptrdiff_t)nTaps > (ptrdiff_t)len) ? (ptrdiff_t)(len - nTaps) : s;
+        s = (s < 0) ? 0 : s;
+        start[i] = (uint32_t)s;
+
+        /* pixels past the edges repeat the edge pixels */
+        memset(tmp, 0, sizeof(double) * nTaps);
+        for (ptrdiff_t x = first; x < last; x++)
+        {
+            ptrdiff_t   xc = (x < 0) ? 0 : (x >= (ptrdiff_t)len) ? (ptrdiff_t)len - 1 : x;
+            double      w = desc->eval((x + 0.5 - center) / fscale);
+
+            tmp[xc - s] += w;
+            sum += w;
+        }
+
+        for (size_t k = 0; k < nTaps; k++)
+        {
+            double q = tmp[k] / sum * (1 << RESIZE_FILTER_W_BITS);
+
+            weights[k] = (int16_t)floor(q + 0.5);
+            qSum += weights[k];
+            largest = (weights[k] > weights[largest]) ? k : largest;
+        }
+
+        /* the rounding error goes to the largest weight, flat areas stay flat */
+        weights[largest] += (1 << RESIZE_FILTER_W_BITS) - qSum;
+    }
+}
+
+resize_filter_plan_t *resizeFilterPlanCreate(size_t width, size_t height, size_t newWidth, size_t newHeight,
+                                             img_filter_t filter)
+{
+    resize_filter_plan_t    *plan = NULL;
+    const filter_desc_t     *desc = NULL;
+    void                    *tables = NULL;
+    size_t                  tablesSize = 0;
+    size_t                  paddedWidth = 0;
+    size_t                  nX = 0;
+    int16_t                 *xWeights = NULL;
+    int16_t                 *yWeights = NULL;
+    double                  *tmp = NULL;
+
+    RET_ERR_MSG(!width || !height, "Invalid source dimension\n");
+    RET_ERR_MSG(!newWidth || !newHeight, "Invalid dimension\n");
+    RET_ERR_MSG(width > UINT32_MAX || height > UINT32_MAX, "Image too large\n");
+    RET_ERR_MSG(filter != IMG_FILTER_BICUBIC && filter != IMG_FILTER_LANCZOS3, "Unknown filter\n");
+
+    desc = &filterDescs[filter];
+    RET_ERR_MSG(!(plan = malloc(sizeof(resize_filter_plan_t))), "Allocation error\n");
+
+    plan->width = width;
+    plan->height = height;
+    plan->newWidth = newWidth;
+    plan->newHeight = newHeight;
+    nX = filterAxisTaps(desc, width, newWidth);
+    plan->nTapsX = (nX + RESIZE_FILTER_X_TAPS_ALIGN - 1) & ~(size_t)(RESIZE_FILTER_X_TAPS_ALIGN - 1);
+    plan->nRowsY = filterAxisTaps(desc, height, newHeight);
+    plan->nTapsY = (plan->nRowsY + RESIZE_FILTER_Y_TAPS_ALIGN - 1) & ~(size_t)(RESIZE_FILTER_Y_TAPS_ALIGN - 1);
+
+    /* create one aligned memory chunk for all tables, padded column tables keep the others aligned */
+    paddedWidth = RESIZE_PADDED_LEN(newWidth);
+    tablesSize = paddedWidth * (sizeof(uint32_t) + sizeof(int16_t) * plan->nTapsX)
+                + newHeight * (sizeof(uint32_t) + sizeof(int16_t) * plan->nTapsY);
+    RET_ERR_MSG(posix_memalign(&tables, IMG_ALIGN, tablesSize), "Allocation error\n");
+
+    plan->cStart = tables;
+    plan->cWeights = (int16_t *)(plan->cStart + paddedWidth);
+    plan->rStart = (uint32_t *)(plan->cWeights + paddedWidth * plan->nTapsX);
+    plan->rWeights = (int16_t *)(plan->rStart + newHeight);
+
+    /* weights are computed per pixel first and interleaved to blocks of columns below */
+    RET_ERR_MSG(!(xWeights = malloc(sizeof(int16_t) * newWidth * nX)), "Allocation error\n");
+    RET_ERR_MSG(!(yWeights = malloc(sizeof(int16_t) * newHeight * plan->nRowsY)), "Allocation error\n");
+    RET_ERR_MSG(!(tmp = malloc(sizeof(double) * ((nX > plan->nRowsY) ? nX : plan->nRowsY))),
+                "Allocation error\n");
+
+    filterAxis(desc, width, newWidth, nX, plan->cStart, xWeights, tmp);
+    filterAxis(desc, height, newHeight, plan->nRowsY, plan->rStart, yWeights, tmp);
+
+    /* padding columns repeat the last window with zero weights */
+    for (size_t cNew = newWidth; cNew < paddedWidth; cNew++)
+    {
+        plan->cStart[cNew] = plan->cStart[newWidth - 1];
+    }
+    for (size_t cNew = 0; cNew < paddedWidth; cNew++)
+    {
+        for (size_t tap = 0; tap < plan->nTapsX; tap++)
+        {
+            size_t  block = cNew / RESIZE_FILTER_X_LANES;
+            size_t  lane = cNew % RESIZE_FILTER_X_LANES;
+            size_t  pair = block * (plan->nTapsX / 2) + tap / 2;
+            int16_t w = (cNew < newWidth && tap < nX) ? xWeights[cNew * nX + tap] : 0;
+
+            plan->cWeights[(pair * RESIZE_FILTER_X_LANES + lane) * 2 + tap % 2] = w;
+        }
+    }
+
+    for (size_t rNew = 0; rNew < newHeight; rNew++)
+    {
+        for (size_t tap = 0; tap < plan->nTapsY; tap++)
+        {
+            plan->rWeights[rNew * plan->nTapsY + tap] = (tap < plan->nRowsY) ? yWeights[rNew * plan->nRowsY + tap] : 0;
+        }
+    }
+
+    free(tmp);
+    free(yWeights);
+    free(xWeights);
+    return plan;
+
+error:
+    if (tmp) { free(tmp); }
+    if (yWeights) { free(yWeights); }
+    if (xWeights) { free(xWeights); }
+    if (tables) { free(tables); }
+    if (plan) { free(plan); }
+    return NULL;
+}
+
+void resizeFilterPlanDestroy(resize_filter_plan_t *plan)
+{
+    if (!plan)
+    {
+        return;
+    }
+
+    free(plan->cStart);
+    free(plan);
+}
+
+bool resizeBandFilter(const resize_kernel_t *kernel, const resize_filter_plan_t *plan, const image_t *img,
+                      image_t *newImg, size_t rBegin, size_t rEnd)
+{
+    int16_t         *hRows = NULL;
+    const int16_t   **rows = NULL;
+    void            *chunk = NULL;
+    size_t          stride = 0;
+    size_t          newStride = 0;
+    size_t          paddedWidth = 0;
+    size_t          nRows = 0;
+    const uint8_t   *channels[3] = { NULL, NULL, NULL };
+    uint8_t         *newChannels[3] = { NULL, NULL, NULL };
+
+    TRACE_BEGIN(resizeSpan);
+    stride = img->stride;
+    newStride = newImg->stride;
+    paddedWidth = RESIZE_PADDED_LEN(plan->newWidth);
+    nRows = plan->nRowsY;
+    channels[0] = img->rChannel;
+    channels[1] = img->gChannel;
+    channels[2] = img->bChannel;
+    newChannels[0] = newImg->rChannel;
+    newChannels[1] = newImg->gChannel;
+    newChannels[2] = newImg->bChannel;
+
+    /* ring of horizontally filtered rows of the vertical window, padding is processed by primitives */
+    RET_ERR_MSG(posix_memalign(&chunk, IMG_ALIGN, sizeof(int16_t) * paddedWidth * nRows), "Allocation error\n");
+    hRows = chunk;
+    RET_ERR_MSG(!(rows = malloc(sizeof(int16_t *) * plan->nTapsY)), "Allocation error\n");
+
+    for (size_t ch = 0; ch < 3; ch++)
+    {
+        size_t next = 0;                // first source row not filtered yet
+
+        for (size_t rNew = rBegin; rNew < rEnd; rNew++)
+        {
+            size_t first = plan->rStart[rNew];
+
+            /* rows shared with the previous window stay in the ring */
+            next = (next < first) ? first : next;
+            for (; next < first + nRows; next++)
+            {
+                kernel->horizontalFilter(plan, &channels[ch][next * stride], &hRows[(next % nRows) * paddedWidth]);
+            }
+
+            /* padding taps have zero weights, they repeat the last row */
+            for (size_t tap = 0; tap < plan->nTapsY; tap++)
+            {
+                size_t r = first + ((tap < nRows) ? tap : nRows - 1);
+                rows[tap] = &hRows[(r % nRows) * paddedWidth];
+            }
+
+            kernel->verticalFilter(rows, &plan->rWeights[rNew * plan->nTapsY], plan->nTapsY,
+                                   &newChannels[ch][rNew * newStride], plan->newWidth);
+        }
+    }
+
+    free(rows);
+    free(hRows);
+    TRACE_END(resizeSpan, TRACE_RESIZE, (uint64_t)3 * plan->newWidth * (rEnd - rBegin),
+              (uint64_t)plan->newWidth * (rEnd - rBegin));
+    return true;
+
+error:
+    if (hRows) { free(hRows); }
+    return false;
+}
+
+image_t *imgResizeFilter(const image_t *img, size_t newWidth, size_t newHeight, img_filter_t filter)
+{
+    resize_filter_plan_t    *plan = NULL;
+    image_t                 *newImg = NULL;
+
+    RET_ERR_MSG(!img, "NULL image\n");
+    RET_ERR_MSG(!(plan = resizeFilterPlanCreate(img->width, img->height, newWidth, newHeight, filter)),
+                "Failed to create resize plan\n");
+    RET_ERR_MSG(!(newImg = imgCreate(newWidth, newHeight)), "Allocation error\n");
+    RET_ERR(!resizeBandFilter(resizeKernel(), plan, img, newImg, 0, newHeight));
+
+    resizeFilterPlanDestroy(plan);
+    return newImg;
+
+error:
+    if (newImg) { imgDestroy(newImg); }
+    if (plan) { resizeFilterPlanDestroy(plan); }
+    return NULL;
+}
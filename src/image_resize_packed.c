@@ -0,0 +1,108 @@
+#define _POSIX_C_SOURCE 200809L
+#include <string.h>
+#include "image_resize.h"
+
+/*
+** Resize of packed images
+**
+** Rows of interleaved pixels are interpolated horizontally by packed row primitives. The vertical
+** pass does not care about the layout, verticalFloat primitives process the whole row of
+** newWidth * nChannels values. Index and weight tables are shared with planar images.
+*/
+
+/**
+ * Checks whether packed images match dimensions of a resize plan
+ * @param plan Resize plan
+ * @param img Source image
+ * @param newImg Destination image
+ * @return True if the plan can be applied
+ */
+static inline bool packedResizePlanMatches(const img_resize_plan_t *plan, const packed_image_t *img,
+                                           const packed_image_t *newImg)
+{
+    return plan && img && newImg && img->nChannels == newImg->nChannels
+            && plan->width == img->width && plan->height == img->height
+            && plan->newWidth == newImg->width && plan->newHeight == newImg->height;
+}
+
+bool imgResizePackedWithPlan(const img_resize_plan_t *plan, const packed_image_t *img,
+                             packed_image_t *newImg)
+{
+    const resize_kernel_t   *kernel = resizeKernel();
+    row_cache_t             cache;
+    float                   *hRows = NULL;
+    uint8_t                 *newRow = NULL;
+    void                    *chunk = NULL;
+    size_t                  nChannels = 0;
+    size_t                  hRowLen = 0;
+    size_t                  paddedLen = 0;
+
+    TRACE_BEGIN(resizeSpan);
+    RET_ERR_MSG(!packedResizePlanMatches(plan, img, newImg), "Resize plan does not match images\n");
+
+    nChannels = img->nChannels;
+    hRowLen = plan->newWidth * nChannels;
+    paddedLen = RESIZE_PADDED_LEN(hRowLen);
+
+    /* padded rows are zeroed, padding is processed by the vertical primitive but never stored */
+    RET_ERR_MSG(posix_memalign(&chunk, IMG_ALIGN, (sizeof(float) * ROW_CACHE_N_ROWS + 1) * paddedLen),
+                "Allocation error\n");
+    memset(chunk, 0x00, (sizeof(float) * ROW_CACHE_N_ROWS + 1) * paddedLen);
+    hRows = chunk;
+    for (size_t slot = 0; slot < ROW_CACHE_N_ROWS; slot++)
+    {
+        cache.rows[slot] = hRows + slot * paddedLen;
+    }
+    newRow = (uint8_t *)(hRows + ROW_CACHE_N_ROWS * paddedLen);
+    rowCacheReset(&cache);
+
+    for (size_t rNew = 0; rNew < plan->newHeight; rNew++)
+    {
+        size_t r = plan->rTable[rNew];
+        bool hit = false;
+
+        size_t slot0 = rowCacheSlot(&cache, r, r + 1, &hit);
+        if (!hit)
+        {
+            kernel->horizontalPacked(plan, &img->pixels[r * img->stride], nChannels, cache.rows[slot0]);
+        }
+
+        size_t slot1 = rowCacheSlot(&cache, r + 1, r, &hit);
+        if (!hit)
+        {
+            kernel->horizontalPacked(plan, &img->pixels[(r + 1) * img->stride], nChannels, cache.rows[slot1]);
+        }
+
+        /* rows of packed images are not padded, the new row goes through a padded one */
+        kernel->verticalFloat(cache.rows[slot0], cache.rows[slot1], plan->deltaRTable[rNew], newRow, hRowLen);
+        memcpy(&newImg->pixels[rNew * newImg->stride], newRow, hRowLen);
+    }
+
+    free(hRows);
+    TRACE_END(resizeSpan, TRACE_RESIZE, (uint64_t)hRowLen * plan->newHeight,
+              (uint64_t)plan->newWidth * plan->newHeight);
+    return true;
+
+error:
+    return false;
+}
+
+packed_image_t *imgResizePacked(const packed_image_t *img, size_t newWidth, size_t newHeight)
+{
+    img_resize_plan_t   *plan = NULL;
+    packed_image_t      *newImg = NULL;
+
+    RET_ERR_MSG(!img, "NULL image\n");
+    RET_ERR_MSG(!(plan = imgResizePlanCreate(img->width, img->height, newWidth, newHeight)),
+                "Failed to create resize plan\n");
+    RET_ERR_MSG(!(newImg = packedImgCreate(newWidth, newHeight, img->nChannels)), "Allocation error\n");
+    RET_ERR(!imgResizePackedWithPlan(plan, img, newImg));
+
+    imgResizePlanDestroy(plan);
+    return newImg;
+
+error:
+    if (newImg) { packedImgDestroy(newImg); }
+    if (plan) { imgResizePlanDestroy(plan); }
+    return NULL;
+}
@@ -0,0 +1,257 @@
+#define _POSIX_C_SOURCE 200809L
+#include "image_resize.h"
+#include "thread_pool.h"
+
+/* new rows of all channels of a band should fit L2 cache together with their source rows */
+#define RESIZE_BAND_BYTES       (256 * 1024)
+/* bands per worker, more bands balance uneven workers better */
+#define RESIZE_BANDS_PER_THREAD 4
+
+/* Band of new rows processed by a single task */
+typedef struct
+{
+    const resize_kernel_t   *kernel;
+    const img_resize_plan_t *plan;
+    const image_t           *img;
+    image_t                 *newImg;
+    size_t                  rBegin;
+    size_t                  rEnd;
+    bool                    fixed;
+    bool                    ok;
+} resize_band_t;
+
+/* Resize pool with the number of resizes running on it */
+typedef struct
+{
+    thread_pool_t   *pool;
+    size_t          nUsers;
+} resize_pool_ref_t;
+
+static pthread_mutex_t      resizePoolLock = PTHREAD_MUTEX_INITIALIZER;
+static resize_pool_ref_t    *resizePool = NULL;     // pool of new resizes
+
+/**
+ * Creates a pool reference without users
+ * @param nThreads Number of workers, 0 for the number of online CPUs
+ * @return Reference or NULL on error
+ */
+static resize_pool_ref_t *resizePoolRefCreate(size_t nThreads)
+{
+    resize_pool_ref_t *ref = NULL;
+
+    RET_ERR_MSG(!(ref = calloc(1, sizeof(resize_pool_ref_t))), "Allocation error\n");
+    RET_ERR(!(ref->pool = threadPoolCreate(nThreads)));
+    return ref;
+
+error:
+    free(ref);
+    return NULL;
+}
+
+/**
+ * Stops the workers of a pool reference and deallocates it
+ * @param ref Reference without users
+ */
+static void resizePoolRefDestroy(resize_pool_ref_t *ref)
+{
+    if (ref)
+    {
+        threadPoolDestroy(ref->pool);
+        free(ref);
+    }
+}
+
+/**
+ * Returns the shared resize pool, starts it on first use
+ * The pool stays alive until resizeThreadPoolRelease, even when imgResizeSetThreads replaces it.
+ * @return Pool reference or NULL on error
+ */
+static resize_pool_ref_t *resizeThreadPoolAcquire(void)
+{
+    resize_pool_ref_t *ref = NULL;
+
+    pthread_mutex_lock(&resizePoolLock);
+    if (!resizePool)
+    {
+        resizePool = resizePoolRefCreate(0);
+    }
+    ref = resizePool;
+    if (ref)
+    {
+        ref->nUsers++;
+    }
+    pthread_mutex_unlock(&resizePoolLock);
+
+    return ref;
+}
+
+/**
+ * Releases a pool returned by resizeThreadPoolAcquire, the last user of a replaced pool stops it
+ * @param ref Pool reference
+ */
+static void resizeThreadPoolRelease(resize_pool_ref_t *ref)
+{
+    bool retired = false;
+
+    pthread_mutex_lock(&resizePoolLock);
+    retired = --ref->nUsers == 0 && ref != resizePool;
+    pthread_mutex_unlock(&resizePoolLock);
+
+    if (retired)
+    {
+        resizePoolRefDestroy(ref);
+    }
+}
+
+/**
+ * Thread pool task resizing a single band
+ * @param arg Band
+ */
+static void resizeBandTask(void *arg)
+{
+    resize_band_t *band = arg;
+
+    if (band->fixed)
+    {
+        band->ok = resizeBandFixed(band->kernel, band->plan, band->img, band->newImg,
+                                   band->rBegin, band->rEnd);
+    }
+    else
+    {
+        band->ok = resizeBandFloat(band->kernel, band->plan, band->img, band->newImg,
+                                   band->rBegin, band->rEnd);
+    }
+}
+
+/**
+ * Splits new rows to bands and resizes them on the shared pool
+ * @param plan Resize plan
+ * @param img Source image
+ * @param newImg Destination image
+ * @param fixed Use fixed-point row primitives
+ * @return Success flag
+ */
+static bool resizeParallel(const img_resize_plan_t *plan, const image_t *img, image_t *newImg, bool fixed)
+{
+    resize_pool_ref_t   *ref = NULL;
+    thread_pool_t       *pool = NULL;
+    thread_pool_group_t group;
+    bool                groupInit = false;
+    resize_band_t       *bands = NULL;
+    size_t              nBands = 0;
+    size_t              nSubmitted = 0;
+    size_t              rowsPerBand = 0;
+    size_t              newHeight = 0;
+    bool                ok = true;
+
+    RET_ERR_MSG(!imgResizePlanMatches(plan, img, newImg), "Resize plan does not match images\n");
+    RET_ERR_MSG(!(ref = resizeThreadPoolAcquire()), "Failed to start resize threads\n");
+    pool = ref->pool;
+
+    newHeight = plan->newHeight;
+    rowsPerBand = RESIZE_BAND_BYTES / (plan->newWidth * 3);
+    rowsPerBand = rowsPerBand ? rowsPerBand : 1;
+
+    /* keep every worker busy even when the image is small */
+    if ((newHeight + rowsPerBand - 1) / rowsPerBand < pool->nThreads * RESIZE_BANDS_PER_THREAD)
+    {
+        rowsPerBand = (newHeight + pool->nThreads * RESIZE_BANDS_PER_THREAD - 1)
+                        / (pool->nThreads * RESIZE_BANDS_PER_THREAD);
+    }
+    nBands = (newHeight + rowsPerBand - 1) / rowsPerBand;
+
+    RET_ERR_MSG(!(bands = malloc(sizeof(resize_band_t) * nBands)), "Allocation error\n");
+    RET_ERR_MSG(!(groupInit = threadPoolGroupInit(&group)), "Failed to create task group\n");
+
+    const resize_kernel_t *kernel = resizeKernel();
+    for (nSubmitted = 0; nSubmitted < nBands; nSubmitted++)
+    {
+        resize_band_t *band = &bands[nSubmitted];
+
+        band->kernel = kernel;
+        band->plan = plan;
+        band->img = img;
+        band->newImg = newImg;
+        band->rBegin = nSubmitted * rowsPerBand;
+        band->rEnd = (band->rBegin + rowsPerBand < newHeight) ? band->rBegin + rowsPerBand : newHeight;
+        band->fixed = fixed;
+        band->ok = false;
+
+        if (!threadPoolSubmit(pool, &group, resizeBandTask, band))
+        {
+            ok = false;
+            break;
+        }
+    }
+
+    threadPoolGroupWait(&group);
+    threadPoolGroupDestroy(&group);
+    resizeThreadPoolRelease(ref);
+
+    for (size_t i = 0; i < nSubmitted; i++)
+    {
+        ok = ok && bands[i].ok;
+    }
+
+    free(bands);
+    return ok;
+
+error:
+    if (bands) { free(bands); }
+    if (ref) { resizeThreadPoolRelease(ref); }
+    return false;
+}
+
+bool imgResizeSetThreads(size_t nThreads)
+{
+    resize_pool_ref_t   *ref = NULL;
+    resize_pool_ref_t   *old = NULL;
+
+    RET_ERR_MSG(!(ref = resizePoolRefCreate(nThreads)), "Failed to start resize threads\n");
+
+    /* resizes running on the old pool finish there, the last of them stops it */
+    pthread_mutex_lock(&resizePoolLock);
+    old = resizePool;
+    resizePool = ref;
+    if (old && old->nUsers)
+    {
+        old = NULL;
+    }
+    pthread_mutex_unlock(&resizePoolLock);
+
+    resizePoolRefDestroy(old);
+    return true;
+
+error:
+    return false;
+}
+
+bool imgResizeParallelWithPlan(const img_resize_plan_t *plan, const image_t *img, image_t *newImg)
+{
+    return resizeParallel(plan, img, newImg, false);
+}
+
+bool imgResizeFixedParallelWithPlan(const img_resize_plan_t *plan, const image_t *img, image_t *newImg)
+{
+    return resizeParallel(plan, img, newImg, true);
+}
+
+image_t *imgResizeParallel(const image_t *img, size_t newWidth, size_t newHeight)
+{
+    img_resize_plan_t   *plan = NULL;
+    image_t             *newImg = NULL;
+
+    RET_ERR_MSG(!img, "NULL image\n");
+    RET_ERR_MSG(!(plan = imgResizePlanCreate(img->width, img->height, newWidth, newHeight)),
+                "Failed to create resize plan\n");
+    RET_ERR_MSG(!(newImg = imgCreate(newWidth, newHeight)), "Allocation error\n");
+    RET_ERR(!imgResizeParallelWithPlan(plan, img, newImg));
+
+    imgResizePlanDestroy(plan);
+    return newImg;
+
+error:
+    if (newImg) { imgDestroy(newImg); }
+    if (plan) { imgResizePlanDestroy(plan); }
+    return NULL;
+}
@@ -0,0 +1,367 @@
+#define _POSIX_C_SOURCE 200809L
+#include "image_resize.h"
+#include "resize_fixed.h"
+
+/* Kernels of every SIMD level, levels without own primitives reuse the best lower ones */
+static const resize_kernel_t resizeKernels[SIMD_LEVEL_COUNT] =
+{
+    [SIMD_LEVEL_SCALAR] = { resizeHorizontalFloatScalar, resizeVerticalFloatScalar,
+                            resizeHorizontalFixedScalar, resizeVerticalFixedScalar,
+                            resizeHorizontalPackedScalar,
+                            resizeVerticalAreaScalar, resizeVerticalAreaSplitScalar,
+                            resizeHorizontalFilterScalar, resizeVerticalFilterScalar,
+                            resizeDownscaleRatioScalar, resizeUpscaleRatioScalar },
+    [SIMD_LEVEL_SSE2]   = { resizeHorizontalFloatSse2, resizeVerticalFloatSse2,
+                            resizeHorizontalFixedScalar, resizeVerticalFixedScalar,
+                            resizeHorizontalPackedScalar,
+                            resizeVerticalAreaSse2, resizeVerticalAreaSplitSse2,
+                            resizeHorizontalFilterScalar, resizeVerticalFilterScalar,
+                            resizeDownscaleRatioScalar, resizeUpscaleRatioScalar },
+    [SIMD_LEVEL_AVX]    = { resizeHorizontalFloatAvx, resizeVerticalFloatAvx,
+                            resizeHorizontalFixedScalar, resizeVerticalFixedScalar,
+                            resizeHorizontalPackedAvx,
+                            resizeVerticalAreaAvx, resizeVerticalAreaSplitAvx,
+                            resizeHorizontalFilterScalar, resizeVerticalFilterScalar,
+                            resizeDownscaleRatioScalar, resizeUpscaleRatioScalar },
+    [SIMD_LEVEL_AVX2]   = { resizeHorizontalFloatAvx, resizeVerticalFloatAvx,
+                            resizeHorizontalFixedAvx2, resizeVerticalFixedAvx2,
+                            resizeHorizontalPackedAvx,
+                            resizeVerticalAreaAvx2, resizeVerticalAreaSplitAvx2,
+                            resizeHorizontalFilterAvx2, resizeVerticalFilterAvx2,
+                            resizeDownscaleRatioAvx2, resizeUpscaleRatioAvx2 },
+    [SIMD_LEVEL_AVX512] = { resizeHorizontalFloatAvx512, resizeVerticalFloatAvx512,
+                            resizeHorizontalFixedAvx512, resizeVerticalFixedAvx512,
+                            resizeHorizontalPackedAvx,
+                            resizeVerticalAreaAvx512, resizeVerticalAreaSplitAvx512,
+                            resizeHorizontalFilterAvx2, resizeVerticalFilterAvx2,
+                            resizeDownscaleRatioAvx2, resizeUpscaleRatioAvx2 },
+};
+
+const resize_kernel_t *resizeKernel(void)
+{
+    return &resizeKernels[cpuSimdLevel()];
+}
+
+const resize_kernel_t *resizeKernelForLevel(simd_level_t level)
+{
+    return &resizeKernels[level];
+}
+
+img_resize_plan_t *imgResizePlanCreate(size_t width, size_t height, size_t newWidth, size_t newHeight)
+{
+    img_resize_plan_t   *plan = NULL;
+    void                *tables = NULL;
+    size_t              tablesSize = 0;
+    size_t              paddedWidth = 0;
+    float               sr = 0.0;               // row scale
+    float               sc = 0.0;               // column scale
+
+    RET_ERR_MSG(width < 2 || height < 2, "Invalid source dimension\n");
+    RET_ERR_MSG(newWidth <= 1 || newHeight <= 1, "Invalid dimension\n");
+    RET_ERR_MSG(width > INT32_MAX || height > INT32_MAX, "Image too large\n");
+
+    RET_ERR_MSG(!(plan = malloc(sizeof(img_resize_plan_t))), "Allocation error\n");
+
+    /* create one aligned memory chunk for all tables, padded column tables keep the others aligned */
+    paddedWidth = RESIZE_PADDED_LEN(newWidth);
+    tablesSize = paddedWidth * (sizeof(uint32_t) + sizeof(float) + sizeof(int32_t) + sizeof(uint16_t)
+                                + 2 * sizeof(uint8_t))
+                + newHeight * (sizeof(uint32_t) * 3 + sizeof(float) + sizeof(uint8_t));
+    RET_ERR_MSG(posix_memalign(&tables, IMG_ALIGN, tablesSize), "Allocation error\n");
+
+    plan->width = width;
+    plan->height = height;
+    plan->newWidth = newWidth;
+    plan->newHeight = newHeight;
+    plan->cTable = tables;
+    plan->deltaCTable = (float *)(plan->cTable + paddedWidth);
+    plan->cFixedTable = (int32_t *)(plan->deltaCTable + paddedWidth);
+    plan->wFixedTable = (uint16_t *)(plan->cFixedTable + paddedWidth);
+    plan->cShuffleTable = (uint8_t *)(plan->wFixedTable + paddedWidth);
+    plan->rTable = (uint32_t *)(plan->cShuffleTable + 2 * paddedWidth);
+    plan->deltaRTable = (float *)(plan->rTable + newHeight);
+    plan->r0FixedTable = (uint32_t *)(plan->deltaRTable + newHeight);
+    plan->r1FixedTable = plan->r0FixedTable + newHeight;
+    plan->fyFixedTable = (uint8_t *)(plan->r1FixedTable + newHeight);
+
+    sr = (float)height / (float)newHeight;
+    sc = (float)width / (float)newWidth;
+
+    /* padding entries continue the mapping, they are clamped to the last pixel pair as well */
+    float cf = 0.0;
+    for (size_t cNew = 0; cNew < paddedWidth; cNew++, cf += sc)
+    {
+        size_t c = (size_t)cf;
+        c = (c > width - 2) ? width - 2 : c;
+        plan->cTable[cNew] = c;
+        /* beyond the last pair, hold the last pixel instead of extrapolating */
+        plan->deltaCTable[cNew] = (cf - c > 1.0f) ? 1.0f : cf - c;
+
+        uint8_t fx = 0;
+        resizeFixedMap(width, newWidth, cNew, &c, &fx);
+        plan->cFixedTable[cNew] = (int32_t)c;
+        plan->wFixedTable[cNew] = (uint16_t)((RESIZE_FIXED_ONE - fx) | (fx << 8));
+    }
+
+    /* padded widths are multiples of the block */
+    for (size_t cNew = 0; cNew < paddedWidth; cNew += RESIZE_SHUFFLE_N_COLS)
+    {
+        uint8_t *indices = &plan->cShuffleTable[2 * cNew];
+        bool    fits = resizeShuffleFits(plan->cTable, cNew);
+
+        for (size_t i = 0; i < RESIZE_SHUFFLE_N_COLS; i++)
+        {
+            uint8_t offset = fits ? (uint8_t)(plan->cTable[cNew + i] - plan->cTable[cNew]) : 0;
+
+            indices[i] = offset;
+            indices[RESIZE_SHUFFLE_N_COLS + i] = fits ? offset + 1 : 0;
+        }
+    }
+
+    float rf = 0.0;
+    for (size_t rNew = 0; rNew < newHeight; rNew++, rf += sr)
+    {
+        size_t r = (size_t)rf;
+        r = (r > height - 2) ? height - 2 : r;
+        plan->rTable[rNew] = r;
+        plan->deltaRTable[rNew] = (rf - r > 1.0f) ? 1.0f : rf - r;
+
+        uint8_t fy = 0;
+        resizeFixedMap(height, newHeight, rNew, &r, &fy);
+        if (fy == RESIZE_FIXED_ONE)
+        {
+            /* beyond the last pair, mulhrs can not represent 1.0 */
+            plan->r0FixedTable[rNew] = r + 1;
+            plan->r1FixedTable[rNew] = r + 1;
+            plan->fyFixedTable[rNew] = 0;
+        }
+        else
+        {
+            plan->r0FixedTable[rNew] = r;
+            plan->r1FixedTable[rNew] = r + 1;
+            plan->fyFixedTable[rNew] = fy;
+        }
+    }
+
+    return plan;
+
+error:
+    if (tables) { free(tables); }
+    if (plan) { free(plan); }
+    return NULL;
+}
+
+void imgResizePlanDestroy(img_resize_plan_t *plan)
+{
+    if (!plan)
+    {
+        return;
+    }
+
+    free(plan->cTable);
+    free(plan);
+}
+
+image_t *imgResize(const image_t *img, size_t newWidth, size_t newHeight)
+{
+    img_resize_plan_t   *plan = NULL;
+    image_t             *newImg = NULL;
+
+    RET_ERR_MSG(!img, "NULL image\n");
+
+    /* integer ratios need neither a plan nor interpolated rows */
+    if (resizeRatioLog2(img->width, img->height, newWidth, newHeight))
+    {
+        RET_ERR_MSG(!(newImg = imgCreate(newWidth, newHeight)), "Allocation error\n");
+        RET_ERR(!resizeBandRatio(resizeKernel(), img, newImg, 0, newHeight));
+        return newImg;
+    }
+
+    RET_ERR_MSG(!(plan = imgResizePlanCreate(img->width, img->height, newWidth, newHeight)),
+                "Failed to create resize plan\n");
+    RET_ERR_MSG(!(newImg = imgCreate(newWidth, newHeight)), "Allocation error\n");
+    RET_ERR(!imgResizeWithPlan(plan, img, newImg));
+
+    imgResizePlanDestroy(plan);
+    return newImg;
+
+error:
+    if (newImg) { imgDestroy(newImg); }
+    if (plan) { imgResizePlanDestroy(plan); }
+    return NULL;
+}
+
+image_t *imgResizeFixed(const image_t *img, size_t newWidth, size_t newHeight)
+{
+    img_resize_plan_t   *plan = NULL;
+    image_t             *newImg = NULL;
+
+    RET_ERR_MSG(!img, "NULL image\n");
+    RET_ERR_MSG(!(plan = imgResizePlanCreate(img->width, img->height, newWidth, newHeight)),
+                "Failed to create resize plan\n");
+    RET_ERR_MSG(!(newImg = imgCreate(newWidth, newHeight)), "Allocation error\n");
+    RET_ERR(!imgResizeFixedWithPlan(plan, img, newImg));
+
+    imgResizePlanDestroy(plan);
+    return newImg;
+
+error:
+    if (newImg) { imgDestroy(newImg); }
+    if (plan) { imgResizePlanDestroy(plan); }
+    return NULL;
+}
+
+bool resizeBandFloat(const resize_kernel_t *kernel, const img_resize_plan_t *plan, const image_t *img,
+                     image_t *newImg, size_t rBegin, size_t rEnd)
+{
+    row_cache_t     cache;
+    float           *hRows = NULL;
+    void            *chunk = NULL;
+    size_t          stride = 0;
+    size_t          newWidth = 0;
+    size_t          newStride = 0;
+    size_t          paddedWidth = 0;
+    const uint8_t   *channels[3] = { NULL, NULL, NULL };
+    uint8_t         *newChannels[3] = { NULL, NULL, NULL };
+
+    TRACE_BEGIN(resizeSpan);
+    stride = img->stride;
+    newWidth = newImg->width;
+    newStride = newImg->stride;
+    paddedWidth = RESIZE_PADDED_LEN(newWidth);
+    channels[0] = img->rChannel;
+    channels[1] = img->gChannel;
+    channels[2] = img->bChannel;
+    newChannels[0] = newImg->rChannel;
+    newChannels[1] = newImg->gChannel;
+    newChannels[2] = newImg->bChannel;
+
+    RET_ERR_MSG(posix_memalign(&chunk, IMG_ALIGN, sizeof(float) * paddedWidth * ROW_CACHE_N_ROWS),
+                "Allocation error\n");
+    hRows = chunk;
+    for (size_t slot = 0; slot < ROW_CACHE_N_ROWS; slot++)
+    {
+        cache.rows[slot] = hRows + slot * paddedWidth;
+    }
+
+    for (size_t ch = 0; ch < 3; ch++)
+    {
+        rowCacheReset(&cache);
+
+        for (size_t rNew = rBegin; rNew < rEnd; rNew++)
+        {
+            size_t r = plan->rTable[rNew];
+            bool hit = false;
+
+            size_t slot0 = rowCacheSlot(&cache, r, r + 1, &hit);
+            if (!hit)
+            {
+                kernel->horizontalFloat(plan, &imgReadChannel(channels[ch], stride, r, 0), cache.rows[slot0]);
+            }
+
+            size_t slot1 = rowCacheSlot(&cache, r + 1, r, &hit);
+            if (!hit)
+            {
+                kernel->horizontalFloat(plan, &imgReadChannel(channels[ch], stride, r + 1, 0), cache.rows[slot1]);
+            }
+
+            kernel->verticalFloat(cache.rows[slot0], cache.rows[slot1], plan->deltaRTable[rNew],
+                                  &imgReadChannel(newChannels[ch], newStride, rNew, 0), newWidth);
+        }
+    }
+
+    free(hRows);
+    TRACE_END(resizeSpan, TRACE_RESIZE, (uint64_t)3 * newWidth * (rEnd - rBegin),
+              (uint64_t)newWidth * (rEnd - rBegin));
+    return true;
+
+error:
+    return false;
+}
+
+bool resizeBandFixed(const resize_kernel_t *kernel, const img_resize_plan_t *plan, const image_t *img,
+                     image_t *newImg, size_t rBegin, size_t rEnd)
+{
+    row_cache_t     cache;
+    uint16_t        *hRows = NULL;
+    void            *chunk = NULL;
+    size_t          stride = 0;
+    size_t          newWidth = 0;
+    size_t          newStride = 0;
+    size_t          paddedWidth = 0;
+    const uint8_t   *channels[3] = { NULL, NULL, NULL };
+    uint8_t         *newChannels[3] = { NULL, NULL, NULL };
+
+    TRACE_BEGIN(resizeSpan);
+    stride = img->stride;
+    newWidth = newImg->width;
+    newStride = newImg->stride;
+    paddedWidth = RESIZE_PADDED_LEN(newWidth);
+    channels[0] = img->rChannel;
+    channels[1] = img->gChannel;
+    channels[2] = img->bChannel;
+    newChannels[0] = newImg->rChannel;
+    newChannels[1] = newImg->gChannel;
+    newChannels[2] = newImg->bChannel;
+
+    RET_ERR_MSG(posix_memalign(&chunk, IMG_ALIGN, sizeof(uint16_t) * paddedWidth * ROW_CACHE_N_ROWS),
+                "Allocation error\n");
+    hRows = chunk;
+    for (size_t slot = 0; slot < ROW_CACHE_N_ROWS; slot++)
+    {
+        cache.rows[slot] = hRows + slot * paddedWidth;
+    }
+
+    for (size_t ch = 0; ch < 3; ch++)
+    {
+        rowCacheReset(&cache);
+
+        for (size_t rNew = rBegin; rNew < rEnd; rNew++)
+        {
+            size_t r0 = plan->r0FixedTable[rNew];
+            size_t r1 = plan->r1FixedTable[rNew];
+            bool hit = false;
+
+            size_t slot0 = rowCacheSlot(&cache, r0, r1, &hit);
+            if (!hit)
+            {
+                kernel->horizontalFixed(plan, &imgReadChannel(channels[ch], stride, r0, 0), cache.rows[slot0]);
+            }
+
+            size_t slot1 = rowCacheSlot(&cache, r1, r0, &hit);
+            if (!hit)
+            {
+                kernel->horizontalFixed(plan, &imgReadChannel(channels[ch], stride, r1, 0), cache.rows[slot1]);
+            }
+
+            kernel->verticalFixed(cache.rows[slot0], cache.rows[slot1], plan->fyFixedTable[rNew],
+                                  &imgReadChannel(newChannels[ch], newStride, rNew, 0), newWidth);
+        }
+    }
+
+    free(hRows);
+    TRACE_END(resizeSpan, TRACE_RESIZE, (uint64_t)3 * newWidth * (rEnd - rBegin),
+              (uint64_t)newWidth * (rEnd - rBegin));
+    return true;
+
+error:
+    return false;
+}
+
+bool imgResizeWithPlan(const img_resize_plan_t *plan, const image_t *img, image_t *newImg)
+{
+    RET_ERR_MSG(!imgResizePlanMatches(plan, img, newImg), "Resize plan does not match images\n");
+    return resizeBandFloat(resizeKernel(), plan, img, newImg, 0, plan->newHeight);
+
+error:
+    return false;
+}
+
+bool imgResizeFixedWithPlan(const img_resize_plan_t *plan, const image_t *img, image_t *newImg)
+{
+    RET_ERR_MSG(!imgResizePlanMatches(plan, img, newImg), "Resize plan does not match images\n");
+    return resizeBandFixed(resizeKernel(), plan, img, newImg, 0, plan->newHeight);
+
+error:
+    return false;
+}
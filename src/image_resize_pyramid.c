@@ -0,0 +1,148 @@
+#define _POSIX_C_SOURCE 200809L
+#include "image_resize.h"
+
+/*
+** Resize to several sizes in one pass
+**
+** Source rows of a channel are visited once in ascending order. Every level keeps the horizontally
+** interpolated previous and current source rows, a source row is interpolated for the levels still
+** needing it and new rows of all levels between the previous and the current row are finished right
+** away. Levels run the same row primitives on the same rows as imgResize, so results are identical.
+** Row buffers of all levels are a single allocation.
+*/
+
+/* Resize state of a single size */
+typedef struct
+{
+    img_resize_plan_t   *plan;
+    image_t             *newImg;
+    float               *hRows[2];          ///< interpolated source rows, row r is in hRows[r % 2]
+    size_t              rNew;               ///< next new row of the current channel
+} resize_level_t;
+
+/**
+ * Interpolates a source row for all levels and finishes their new rows ending at it
+ * @param kernel Kernel
+ * @param levels Levels
+ * @param nLevels Number of levels
+ * @param row Source row
+ * @param r Index of the source row
+ * @param ch Channel of the row
+ * @return Whether any level needs later rows
+ */
+static bool resizePyramidRow(const resize_kernel_t *kernel, resize_level_t *levels, size_t nLevels,
+                             const uint8_t *row, size_t r, size_t ch)
+{
+    bool pending = false;
+
+    for (size_t l = 0; l < nLevels; l++)
+    {
+        resize_level_t          *level = &levels[l];
+        const img_resize_plan_t *plan = level->plan;
+        uint8_t                 *newChannel = NULL;
+
+        /* new rows before rNew are done, the next one starts at r - 1 at the earliest */
+        if (level->rNew >= plan->newHeight || plan->rTable[level->rNew] > r)
+        {
+            pending |= level->rNew < plan->newHeight;
+            continue;
+        }
+
+        kernel->horizontalFloat(plan, row, level->hRows[r % 2]);
+
+        newChannel = (ch == 0) ? level->newImg->rChannel : (ch == 1) ? level->newImg->gChannel
+                                                                     : level->newImg->bChannel;
+        for ( ; level->rNew < plan->newHeight && plan->rTable[level->rNew] + 1 == r; level->rNew++)
+        {
+            kernel->verticalFloat(level->hRows[(r + 1) % 2], level->hRows[r % 2],
+                                  plan->deltaRTable[level->rNew],
+                                  &imgReadChannel(newChannel, level->newImg->stride, level->rNew, 0),
+                                  plan->newWidth);
+        }
+
+        pending |= level->rNew < plan->newHeight;
+    }
+
+    return pending;
+}
+
+bool imgResizePyramid(const image_t *img, const size_t sizes[][2], size_t nSizes, image_t **newImgs)
+{
+    const resize_kernel_t   *kernel = resizeKernel();
+    resize_level_t          *levels = NULL;
+    float                   *hRows = NULL;
+    void                    *chunk = NULL;
+    size_t                  hRowsLen = 0;
+    uint64_t                nNewPixels = 0;
+    const uint8_t           *channels[3] = { NULL, NULL, NULL };
+
+    TRACE_BEGIN(resizeSpan);
+    RET_ERR_MSG(!img, "NULL image\n");
+    RET_ERR_MSG(!sizes || !newImgs || !nSizes, "No sizes\n");
+    RET_ERR_MSG(!(levels = calloc(nSizes, sizeof(resize_level_t))), "Allocation error\n");
+
+    for (size_t l = 0; l < nSizes; l++)
+    {
+        RET_ERR_MSG(!(levels[l].plan = imgResizePlanCreate(img->width, img->height, sizes[l][0], sizes[l][1])),
+                    "Failed to create resize plan\n");
+        RET_ERR_MSG(!(levels[l].newImg = imgCreate(sizes[l][0], sizes[l][1])), "Allocation error\n");
+        hRowsLen += 2 * RESIZE_PADDED_LEN(sizes[l][0]);
+        nNewPixels += (uint64_t)sizes[l][0] * sizes[l][1];
+    }
+
+    /* padded row lengths keep rows of every level aligned */
+    RET_ERR_MSG(posix_memalign(&chunk, IMG_ALIGN, sizeof(float) * hRowsLen), "Allocation error\n");
+    hRows = chunk;
+    for (size_t l = 0; l < nSizes; l++)
+    {
+        size_t paddedWidth = RESIZE_PADDED_LEN(sizes[l][0]);
+
+        levels[l].hRows[0] = hRows;
+        levels[l].hRows[1] = hRows + paddedWidth;
+        hRows += 2 * paddedWidth;
+    }
+    hRows = chunk;
+
+    channels[0] = img->rChannel;
+    channels[1] = img->gChannel;
+    channels[2] = img->bChannel;
+
+    for (size_t ch = 0; ch < 3; ch++)
+    {
+        for (size_t l = 0; l < nSizes; l++)
+        {
+            levels[l].rNew = 0;
+        }
+
+        /* rows below the last one needed by any level are not read */
+        for (size_t r = 0; r < img->height; r++)
+        {
+            if (!resizePyramidRow(kernel, levels, nSizes, &imgReadChannel(channels[ch], img->stride, r, 0), r, ch))
+            {
+                break;
+            }
+        }
+    }
+
+    for (size_t l = 0; l < nSizes; l++)
+    {
+        newImgs[l] = levels[l].newImg;
+        imgResizePlanDestroy(levels[l].plan);
+    }
+    free(hRows);
+    free(levels);
+    TRACE_END(resizeSpan, TRACE_RESIZE, 3 * nNewPixels, nNewPixels);
+    return true;
+
+error:
+    if (levels)
+    {
+        for (size_t l = 0; l < nSizes; l++)
+        {
+            if (levels[l].newImg) { imgDestroy(levels[l].newImg); }
+            imgResizePlanDestroy(levels[l].plan);
+        }
+        free(levels);
+    }
+    return false;
+}
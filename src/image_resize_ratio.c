@@ -0,0 +1,89 @@
+#include "image_resize.h"
+
+/* positions of the general plan are exact floats below this length */
+#define RESIZE_RATIO_MAX_LEN    ((size_t)1 << 24)
+
+int resizeRatioLog2(size_t width, size_t height, size_t newWidth, size_t newHeight)
+{
+    /* the same dimensions the general plan accepts */
+    if (width < 2 || height < 2 || newWidth <= 1 || newHeight <= 1)
+    {
+        return 0;
+    }
+    if (width >= RESIZE_RATIO_MAX_LEN || height >= RESIZE_RATIO_MAX_LEN
+        || newWidth >= RESIZE_RATIO_MAX_LEN || newHeight >= RESIZE_RATIO_MAX_LEN)
+    {
+        return 0;
+    }
+
+    for (int factorLog2 = 1; factorLog2 <= 2; factorLog2++)
+    {
+        if (newWidth == width << factorLog2 && newHeight == height << factorLog2)
+        {
+            return factorLog2;
+        }
+        if (width == newWidth << factorLog2 && height == newHeight << factorLog2)
+        {
+            return -factorLog2;
+        }
+    }
+
+    return 0;
+}
+
+bool resizeBandRatio(const resize_kernel_t *kernel, const image_t *img, image_t *newImg, size_t rBegin,
+                     size_t rEnd)
+{
+    int             ratio = 0;
+    size_t          factorLog2 = 0;
+    size_t          stride = 0;
+    size_t          newStride = 0;
+    const uint8_t   *channels[3] = { NULL, NULL, NULL };
+    uint8_t         *newChannels[3] = { NULL, NULL, NULL };
+
+    TRACE_BEGIN(resizeSpan);
+    ratio = resizeRatioLog2(img->width, img->height, newImg->width, newImg->height);
+    RET_ERR_MSG(!ratio, "Not an integer ratio resize\n");
+
+    factorLog2 = (ratio > 0) ? (size_t)ratio : (size_t)-ratio;
+    stride = img->stride;
+    newStride = newImg->stride;
+    channels[0] = img->rChannel;
+    channels[1] = img->gChannel;
+    channels[2] = img->bChannel;
+    newChannels[0] = newImg->rChannel;
+    newChannels[1] = newImg->gChannel;
+    newChannels[2] = newImg->bChannel;
+
+    for (size_t ch = 0; ch < 3; ch++)
+    {
+        for (size_t rNew = rBegin; rNew < rEnd; rNew++)
+        {
+            uint8_t *newRow = &imgReadChannel(newChannels[ch], newStride, rNew, 0);
+
+            if (ratio < 0)
+            {
+                /* deltas of the general plan are 0, new pixels are the top left source pixels */
+                kernel->downscaleRatio(&imgReadChannel(channels[ch], stride, rNew << factorLog2, 0), factorLog2,
+                                       newRow, newImg->width);
+            }
+            else
+            {
+                /* the last row is held instead of extrapolated */
+                size_t r0 = rNew >> factorLog2;
+                size_t r1 = (r0 + 1 < img->height) ? r0 + 1 : r0;
+
+                kernel->upscaleRatio(&imgReadChannel(channels[ch], stride, r0, 0),
+                                     &imgReadChannel(channels[ch], stride, r1, 0),
+                                     rNew & (((size_t)1 << factorLog2) - 1), factorLog2, newRow, img->width);
+            }
+        }
+    }
+
+    TRACE_END(resizeSpan, TRACE_RESIZE, (uint64_t)3 * newImg->width * (rEnd - rBegin),
+              (uint64_t)newImg->width * (rEnd - rBegin));
+    return true;
+
+error:
+    return false;
+}
@@ -0,0 +1,137 @@
+#include <string.h>
+#include <emmintrin.h>
+#include "image_resize.h"
+
+#define SSE_REG_N_FLOATS        4
+
+/*
+** Necessary extensions:
+**      SSE2
+** Baseline vector kernel for x86-64 CPUs without AVX, only the float path is vectorized
+*/
+
+void resizeHorizontalFloatSse2(const img_resize_plan_t *plan, const uint8_t *row, float *hRow)
+{
+    size_t          newWidth = plan->newWidth;
+    const uint32_t  *cTable = plan->cTable;
+
+    __m128 one_flt_vec = _mm_set1_ps(1.0f);
+
+    /* process SSE_REG_N_FLOATS pixels in one iteration */
+    size_t cNew;
+    for (cNew = 0; cNew + SSE_REG_N_FLOATS <= newWidth; cNew += SSE_REG_N_FLOATS)
+    {
+        const uint8_t *p = row;
+
+        /* p0 = row[c], p1 = row[c + 1] */
+        __m128 p0_flt_vec = _mm_set_ps(p[cTable[cNew + 3]], p[cTable[cNew + 2]],
+                                       p[cTable[cNew + 1]], p[cTable[cNew]]);
+        __m128 p1_flt_vec = _mm_set_ps(p[cTable[cNew + 3] + 1], p[cTable[cNew + 2] + 1],
+                                       p[cTable[cNew + 1] + 1], p[cTable[cNew] + 1]);
+
+        /* deltaC, (1.0 - deltaC) */
+        __m128 delta_c_flt_vec = _mm_loadu_ps(&plan->deltaCTable[cNew]);
+        __m128 one_minus_delta_c_flt_vec = _mm_sub_ps(one_flt_vec, delta_c_flt_vec);
+
+        /* h = p0 * (1.0 - deltaC) + p1 * deltaC */
+        __m128 h_flt_vec = _mm_mul_ps(p0_flt_vec, one_minus_delta_c_flt_vec);
+        h_flt_vec = _mm_add_ps(h_flt_vec, _mm_mul_ps(p1_flt_vec, delta_c_flt_vec));
+
+        _mm_storeu_ps(&hRow[cNew], h_flt_vec);
+    }
+
+    /* finished the rest */
+    for ( ; cNew < newWidth; cNew++)
+    {
+        hRow[cNew] = resizeHorizontalFloatPixel(row, cTable[cNew], plan->deltaCTable[cNew]);
+    }
+}
+
+void resizeVerticalFloatSse2(const float *h0Row, const float *h1Row, float deltaR,
+                             uint8_t *newRow, size_t newWidth)
+{
+    __m128 delta_r_flt_vec = _mm_set1_ps(deltaR);
+    __m128 one_minus_delta_r_flt_vec = _mm_set1_ps(1.0f - deltaR);
+
+    /* process SSE_REG_N_FLOATS pixels in one iteration, rows are contiguous */
+    size_t cNew;
+    for (cNew = 0; cNew + SSE_REG_N_FLOATS <= newWidth; cNew += SSE_REG_N_FLOATS)
+    {
+        /* v = h0 * (1.0 - deltaR) + h1 * deltaR */
+        __m128 v_flt_vec = _mm_mul_ps(_mm_loadu_ps(&h0Row[cNew]), one_minus_delta_r_flt_vec);
+        v_flt_vec = _mm_add_ps(v_flt_vec, _mm_mul_ps(_mm_loadu_ps(&h1Row[cNew]), delta_r_flt_vec));
+
+        /* truncate and pack 4 x int32 to 4 x uint8, values are within 0 .. 255 */
+        __m128i v_int_vec = _mm_cvttps_epi32(v_flt_vec);
+        v_int_vec = _mm_packs_epi32(v_int_vec, v_int_vec);
+        v_int_vec = _mm_packus_epi16(v_int_vec, v_int_vec);
+
+        uint32_t bytes = (uint32_t)_mm_cvtsi128_si32(v_int_vec);
+        memcpy(&newRow[cNew], &bytes, sizeof(bytes));
+    }
+
+    /* finished the rest */
+    for ( ; cNew < newWidth; cNew++)
+    {
+        newRow[cNew] = resizeVerticalFloatPixel(h0Row[cNew], h1Row[cNew], deltaR);
+    }
+}
+
+void resizeVerticalAreaSse2(const uint8_t *row, float weight, float *accRow, size_t width)
+{
+    const __m128i zero_vec = _mm_setzero_si128();
+    __m128 weight_flt_vec = _mm_set1_ps(weight);
+
+    /* process 16 pixels in one iteration, the last one runs into the padding of the rows */
+    for (size_t c = 0; c < width; c += 16)
+    {
+        /* 16 x uint8 to 4 x (4 x float) */
+        __m128i p_vec = _mm_loadu_si128((const __m128i *)&row[c]);
+        __m128i lo_vec = _mm_unpacklo_epi8(p_vec, zero_vec);
+        __m128i hi_vec = _mm_unpackhi_epi8(p_vec, zero_vec);
+        __m128 p_flt_vec[4] = {
+            _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo_vec, zero_vec)),
+            _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo_vec, zero_vec)),
+            _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi_vec, zero_vec)),
+            _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi_vec, zero_vec)),
+        };
+
+        /* acc = acc + weight * p */
+        for (size_t i = 0; i < 4; i++)
+        {
+            float *acc = &accRow[c + i * SSE_REG_N_FLOATS];
+            _mm_store_ps(acc, _mm_add_ps(_mm_load_ps(acc), _mm_mul_ps(weight_flt_vec, p_flt_vec[i])));
+        }
+    }
+}
+
+void resizeVerticalAreaSplitSse2(const uint8_t *row, float weight, float *accRow, float nextWeight,
+                                 float *nextAccRow, size_t width)
+{
+    const __m128i zero_vec = _mm_setzero_si128();
+    __m128 weight_flt_vec = _mm_set1_ps(weight);
+    __m128 next_weight_flt_vec = _mm_set1_ps(nextWeight);
+
+    /* process 16 pixels in one iteration, the last one runs into the padding of the rows */
+    for (size_t c = 0; c < width; c += 16)
+    {
+        /* 16 x uint8 to 4 x (4 x float) */
+        __m128i p_vec = _mm_loadu_si128((const __m128i *)&row[c]);
+        __m128i lo_vec = _mm_unpacklo_epi8(p_vec, zero_vec);
+        __m128i hi_vec = _mm_unpackhi_epi8(p_vec, zero_vec);
+        __m128 p_flt_vec[4] = {
+            _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo_vec, zero_vec)),
+            _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo_vec, zero_vec)),
+            _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi_vec, zero_vec)),
+            _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi_vec, zero_vec)),
+        };
+
+        /* acc = acc + weight * p, next = nextWeight * p */
+        for (size_t i = 0; i < 4; i++)
+        {
+            float *acc = &accRow[c + i * SSE_REG_N_FLOATS];
+            _mm_store_ps(acc, _mm_add_ps(_mm_load_ps(acc), _mm_mul_ps(weight_flt_vec, p_flt_vec[i])));
+            _mm_store_ps(&nextAccRow[c + i * SSE_REG_N_FLOATS], _mm_mul_ps(next_weight_flt_vec, p_flt_vec[i]));
+        }
+    }
+}
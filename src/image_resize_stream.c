@@ -0,0 +1,163 @@
+#define _POSIX_C_SOURCE 200809L
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include "image_resize.h"
+#include "image_bmp.h"
+
+/*
+** Out-of-core resize of bitmap files
+**
+** Source rows are read in file order and only the two rows needed by the current new row are kept,
+** horizontally interpolated, in a row cache. New rows are written as soon as they are done, memory
+** is bounded by the row widths and the plan. Rows are processed by the same row primitives as
+** imgResize, so results are identical.
+**
+** The source is validated before the destination is created, the destination is never the source
+** and is removed when resizing fails, so no partial bitmap with a valid header is left behind.
+*/
+
+bool imgResizeBitmapFile(const char *srcFile, const char *dstFile, size_t newWidth, size_t newHeight)
+{
+    FILE                    *src = NULL;
+    FILE                    *dst = NULL;
+    img_resize_plan_t       *plan = NULL;
+    uint8_t                 *rows = NULL;
+    float                   *hRows = NULL;
+    void                    *chunk = NULL;
+    const resize_kernel_t   *kernel = resizeKernel();
+    bmp_deinterleave_fn_t   deinterleave = bmpDeinterleaveKernel();
+    bmp_interleave_fn_t     interleave = bmpInterleaveKernel();
+    row_cache_t             cache;
+    bmp_hdr_t               bmpHdr;
+    dib_hdr_t               dibHdr;
+    uint8_t                 hdr[BMP_HEADERS_SIZE];
+    size_t                  width = 0;
+    size_t                  height = 0;
+    size_t                  stride = 0;
+    size_t                  newStride = 0;
+    size_t                  paddedWidth = 0;
+    size_t                  nextRow = 0;            // source row at the file position
+    uint8_t                 *bgrRow = NULL;
+    uint8_t                 *newBgrRow = NULL;
+    uint8_t                 *channelRows[3] = { NULL, NULL, NULL };
+    uint8_t                 *newChannelRows[3] = { NULL, NULL, NULL };
+    struct stat             srcStat;
+    struct stat             dstStat;
+    bool                    dstCreated = false;
+    int                     closeErr = 0;
+
+    TRACE_BEGIN(resizeSpan);
+    RET_ERR_MSG(!srcFile || !dstFile, "NULL file name\n");
+    RET_ERR_MSG(!(src = fopen(srcFile, "rb")), "Failed to open file\n");
+    RET_ERR_MSG(fstat(fileno(src), &srcStat) || !S_ISREG(srcStat.st_mode), "Failed to open file\n");
+    RET_ERR_MSG(!stat(dstFile, &dstStat) && dstStat.st_dev == srcStat.st_dev && dstStat.st_ino == srcStat.st_ino,
+                "Source and destination are the same file\n");
+    RET_ERR_MSG(fread(hdr, sizeof(hdr), 1, src) != 1, "Reading error\n");
+    RET_ERR(!bmpParseHeaders(hdr, &bmpHdr, &dibHdr));
+
+    width = dibHdr.width;
+    height = dibHdr.height;
+    stride = BMP_ROW_STRIDE(width);
+    RET_ERR_MSG(bmpHdr.pixelsOffset > (size_t)srcStat.st_size, "Reading error\n");
+    RET_ERR_MSG(width && ((size_t)srcStat.st_size - bmpHdr.pixelsOffset) / stride < height, "Reading error\n");
+    newStride = BMP_ROW_STRIDE(newWidth);
+    paddedWidth = RESIZE_PADDED_LEN(newWidth);
+
+    RET_ERR_MSG(!(plan = imgResizePlanCreate(width, height, newWidth, newHeight)),
+                "Failed to create resize plan\n");
+
+    /* one source and one new row, interleaved and planar, planar source rows may be over-read */
+    RET_ERR_MSG(!(rows = malloc(stride + 3 * (width + IMG_CHANNEL_SLACK) + newStride + 3 * paddedWidth)),
+                "Allocation error\n");
+    bgrRow = rows;
+    for (size_t ch = 0; ch < 3; ch++)
+    {
+        channelRows[ch] = bgrRow + stride + ch * (width + IMG_CHANNEL_SLACK);
+    }
+    newBgrRow = channelRows[2] + width + IMG_CHANNEL_SLACK;
+    for (size_t ch = 0; ch < 3; ch++)
+    {
+        newChannelRows[ch] = newBgrRow + newStride + ch * paddedWidth;
+    }
+    memset(newBgrRow + newWidth * 3, 0x00, newStride - newWidth * 3);
+
+    /* every cache slot holds padded interpolated rows of all three channels */
+    RET_ERR_MSG(posix_memalign(&chunk, IMG_ALIGN, sizeof(float) * 3 * paddedWidth * ROW_CACHE_N_ROWS),
+                "Allocation error\n");
+    hRows = chunk;
+    for (size_t slot = 0; slot < ROW_CACHE_N_ROWS; slot++)
+    {
+        cache.rows[slot] = hRows + slot * 3 * paddedWidth;
+    }
+    rowCacheReset(&cache);
+
+    RET_ERR_MSG(!(dst = fopen(dstFile, "wb")), "Failed to open saving file\n");
+    dstCreated = true;
+    bmpWriteHeaders(newWidth, newHeight, hdr);
+    RET_ERR_MSG(fwrite(hdr, sizeof(hdr), 1, dst) != 1, "Write error\n");
+    RET_ERR_MSG(fseeko(src, bmpHdr.pixelsOffset, SEEK_SET), "Reading error\n");
+
+    for (size_t rNew = 0; rNew < newHeight; rNew++)
+    {
+        size_t r = plan->rTable[rNew];
+        size_t slots[2] = { 0, 0 };
+
+        for (size_t i = 0; i < 2; i++)
+        {
+            bool hit = false;
+
+            slots[i] = rowCacheSlot(&cache, r + i, r + 1 - i, &hit);
+            if (hit)
+            {
+                continue;
+            }
+
+            /* rows are requested in ascending order, skipped rows are seeked over */
+            if (nextRow != r + i)
+            {
+                RET_ERR_MSG(fseeko(src, bmpHdr.pixelsOffset + (off_t)(r + i) * stride, SEEK_SET),
+                            "Reading error\n");
+            }
+            RET_ERR_MSG(fread(bgrRow, sizeof(uint8_t), stride, src) != stride, "Reading error\n");
+            nextRow = r + i + 1;
+
+            deinterleave(bgrRow, channelRows[0], channelRows[1], channelRows[2], width);
+            for (size_t ch = 0; ch < 3; ch++)
+            {
+                kernel->horizontalFloat(plan, channelRows[ch], (float *)cache.rows[slots[i]] + ch * paddedWidth);
+            }
+        }
+
+        for (size_t ch = 0; ch < 3; ch++)
+        {
+            kernel->verticalFloat((float *)cache.rows[slots[0]] + ch * paddedWidth,
+                                  (float *)cache.rows[slots[1]] + ch * paddedWidth,
+                                  plan->deltaRTable[rNew], newChannelRows[ch], newWidth);
+        }
+
+        interleave(newChannelRows[0], newChannelRows[1], newChannelRows[2], newBgrRow, newWidth);
+        RET_ERR_MSG(fwrite(newBgrRow, sizeof(uint8_t), newStride, dst) != newStride, "Write error\n");
+    }
+
+    closeErr = fclose(dst);
+    dst = NULL;
+    RET_ERR_MSG(closeErr, "Write error\n");
+
+    free(hRows);
+    free(rows);
+    imgResizePlanDestroy(plan);
+    fclose(src);
+    TRACE_END(resizeSpan, TRACE_RESIZE, (uint64_t)newStride * newHeight, (uint64_t)newWidth * newHeight);
+    return true;
+
+error:
+    if (hRows) { free(hRows); }
+    if (rows) { free(rows); }
+    if (plan) { imgResizePlanDestroy(plan); }
+    if (src) { fclose(src); }
+    if (dst) { fclose(dst); }
+    if (dstCreated) { unlink(dstFile); }
+    return false;
+}
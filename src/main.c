@@ -1,7 +1,14 @@
+#include <string.h>
 #include "main.h"
-#include <immintrin.h>
+#include "commands.h"
 
-int main(int argc, char *argv[])
+/**
+ * Compares average hashes of two images
+ * @param argc Number of arguments
+ * @param argv Arguments
+ * @return Exit code
+ */
+static int cmdCompare(int argc, char *argv[])
 {
     uint64_t    avgHash1 = 0x0000000000000000;
     uint64_t    avgHash2 = 0x0000000000000000;
@@ -9,7 +16,10 @@ int main(int argc, char *argv[])
     image_t     *image1 = NULL;
     image_t     *image2 = NULL;
 
-    RET_ERR_MSG(argc != 3, "./image-info <image1> <image2>\n");
+    RET_ERR_MSG(argc != 3, "./image-info <image1> <image2>\n"
+                           "./image-info hash [-f] [-j threads] [-d directory]... [-] [image]...\n"
+                           "./image-info resize [-s WIDTHxHEIGHT] [-j workers] [-l loaders] [-w writers] "
+                           "[-q depth] [-m manifest]... [-] [src dst]...\n");
 
     RET_ERR_MSG(!(image1 = imgLoadBitmap(argv[1])), "Failed to load a bitmap file, only"
                                                     " 24bpp BMS are supported so far\n");
@@ -50,4 +60,19 @@ error:
     if (image1) { imgDestroy(image1); }
     if (image2) { imgDestroy(image2); }
     return 1;
-}
\ No newline at end of file
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc >= 2 && !strcmp(argv[1], "hash"))
+    {
+        return cmdHash(argc - 1, argv + 1);
+    }
+
+    if (argc >= 2 && !strcmp(argv[1], "resize"))
+    {
+        return cmdResize(argc - 1, argv + 1);
+    }
+
+    return cmdCompare(argc, argv);
+}
@@ -0,0 +1,191 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "thread_pool.h"
+#include "utils.h"
+
+/**
+ * Worker thread, executes queued tasks until the pool stops
+ * @param arg Pool
+ * @return NULL
+ */
+static void *threadPoolWorker(void *arg)
+{
+    thread_pool_t *pool = arg;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->head && !pool->stop)
+        {
+            pthread_cond_wait(&pool->work, &pool->lock);
+        }
+
+        thread_pool_task_t *task = pool->head;
+        if (!task)
+        {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+
+        pool->head = task->next;
+        if (!pool->head)
+        {
+            pool->tail = NULL;
+        }
+        pthread_mutex_unlock(&pool->lock);
+
+        task->fn(task->arg);
+
+        thread_pool_group_t *group = task->group;
+        free(task);
+
+        if (group)
+        {
+            pthread_mutex_lock(&group->lock);
+            group->pending--;
+            pthread_cond_broadcast(&group->done);
+            pthread_mutex_unlock(&group->lock);
+        }
+    }
+}
+
+thread_pool_t *threadPoolCreate(size_t nThreads)
+{
+    thread_pool_t   *pool = NULL;
+    bool            lockInit = false;
+    bool            workInit = false;
+
+    nThreads = nThreads ? nThreads : threadPoolCpuCount();
+
+    RET_ERR_MSG(!(pool = calloc(1, sizeof(thread_pool_t))), "Allocation error\n");
+    RET_ERR_MSG(!(pool->threads = malloc(sizeof(pthread_t) * nThreads)), "Allocation error\n");
+    RET_ERR_MSG(!(lockInit = !pthread_mutex_init(&pool->lock, NULL)), "Failed to create mutex\n");
+    RET_ERR_MSG(!(workInit = !pthread_cond_init(&pool->work, NULL)), "Failed to create condition\n");
+
+    for (pool->nThreads = 0; pool->nThreads < nThreads; pool->nThreads++)
+    {
+        RET_ERR_MSG(pthread_create(&pool->threads[pool->nThreads], NULL, threadPoolWorker, pool),
+                    "Failed to start worker thread\n");
+    }
+
+    return pool;
+
+error:
+    if (pool && pool->nThreads)
+    {
+        /* stops and joins the already started workers */
+        threadPoolDestroy(pool);
+        return NULL;
+    }
+    if (workInit) { pthread_cond_destroy(&pool->work); }
+    if (lockInit) { pthread_mutex_destroy(&pool->lock); }
+    if (pool) { free(pool->threads); free(pool); }
+    return NULL;
+}
+
+void threadPoolDestroy(thread_pool_t *pool)
+{
+    if (!pool)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < pool->nThreads; i++)
+    {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool);
+}
+
+bool threadPoolSubmit(thread_pool_t *pool, thread_pool_group_t *group, void (*fn)(void *), void *arg)
+{
+    thread_pool_task_t *task = NULL;
+
+    RET_ERR_MSG(!pool || !fn, "NULL thread pool task\n");
+    RET_ERR_MSG(!(task = malloc(sizeof(thread_pool_task_t))), "Allocation error\n");
+
+    task->fn = fn;
+    task->arg = arg;
+    task->group = group;
+    task->next = NULL;
+
+    if (group)
+    {
+        pthread_mutex_lock(&group->lock);
+        group->pending++;
+        pthread_mutex_unlock(&group->lock);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->tail)
+    {
+        pool->tail->next = task;
+    }
+    else
+    {
+        pool->head = task;
+    }
+    pool->tail = task;
+    pthread_cond_signal(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    return true;
+
+error:
+    return false;
+}
+
+bool threadPoolGroupInit(thread_pool_group_t *group)
+{
+    RET_ERR(!group);
+    RET_ERR(pthread_mutex_init(&group->lock, NULL));
+    if (pthread_cond_init(&group->done, NULL))
+    {
+        pthread_mutex_destroy(&group->lock);
+        goto error;
+    }
+
+    group->pending = 0;
+    return true;
+
+error:
+    return false;
+}
+
+void threadPoolGroupWait(thread_pool_group_t *group)
+{
+    threadPoolGroupWaitPending(group, 0);
+}
+
+void threadPoolGroupWaitPending(thread_pool_group_t *group, size_t maxPending)
+{
+    pthread_mutex_lock(&group->lock);
+    while (group->pending > maxPending)
+    {
+        pthread_cond_wait(&group->done, &group->lock);
+    }
+    pthread_mutex_unlock(&group->lock);
+}
+
+void threadPoolGroupDestroy(thread_pool_group_t *group)
+{
+    pthread_cond_destroy(&group->done);
+    pthread_mutex_destroy(&group->lock);
+}
+
+size_t threadPoolCpuCount(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (size_t)n : 1;
+}
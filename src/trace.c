@@ -0,0 +1,280 @@
+#define _POSIX_C_SOURCE 200809L
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "trace.h"
+
+static const char *traceStageNames[TRACE_STAGE_COUNT] =
+{
+    "load", "deinterleave", "resize", "grayscale", "hash", "save"
+};
+
+const char *traceStageName(trace_stage_t stage)
+{
+    return (stage < TRACE_STAGE_COUNT) ? traceStageNames[stage] : "unknown";
+}
+
+#ifdef IMG_TRACE
+
+#define TRACE_CHUNK_N_SPANS     4096
+
+/* Recorded span */
+typedef struct
+{
+    uint64_t begin;                             ///< nanoseconds since the trace started
+    uint64_t duration;                          ///< nanoseconds
+    uint64_t bytes;
+    uint64_t pixels;
+    trace_stage_t stage;
+} trace_span_t;
+
+/* Spans of a thread are appended to a list of fixed chunks, chunks never move */
+typedef struct trace_chunk
+{
+    trace_span_t spans[TRACE_CHUNK_N_SPANS];
+    struct trace_chunk *next;
+} trace_chunk_t;
+
+/* Sums of a stage */
+typedef struct
+{
+    uint64_t calls;
+    uint64_t bytes;
+    uint64_t pixels;
+    uint64_t nanos;
+} trace_counters_t;
+
+/* Spans and counters of a thread, written by the thread only */
+typedef struct trace_thread
+{
+    trace_counters_t counters[TRACE_STAGE_COUNT];
+    trace_chunk_t *head;                        ///< first chunk
+    trace_chunk_t *tail;                        ///< chunk spans are appended to
+    size_t nSpans;                              ///< published spans, read with acquire
+    uint64_t dropped;                           ///< spans over TRACE_MAX_SPANS
+    uint64_t tid;                               ///< sequential thread number
+    struct trace_thread *next;                  ///< next thread of the global list
+} trace_thread_t;
+
+static pthread_once_t   traceOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t    traceKey;
+static const char       *tracePath = NULL;
+static uint64_t         traceStart = 0;
+static trace_thread_t   *traceThreads = NULL;   // pushed by compare and swap
+static uint64_t         traceNextTid = 1;
+
+/**
+ * Reads the monotonic clock
+ * @return Nanoseconds
+ */
+static inline uint64_t traceNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Adds to a counter of the calling thread, the flush may read it concurrently
+ * @param counter Counter
+ * @param value Value to add
+ */
+static inline void traceAdd(uint64_t *counter, uint64_t value)
+{
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + value, __ATOMIC_RELAXED);
+}
+
+/**
+ * Writes all threads to the trace file, registered with atexit
+ * Threads still running stop recording new spans, their buffers stay valid until the process ends.
+ */
+static void traceFlush(void)
+{
+    FILE                *f = NULL;
+    const char          *path = __atomic_exchange_n(&tracePath, NULL, __ATOMIC_ACQ_REL);
+    trace_thread_t      *threads = __atomic_load_n(&traceThreads, __ATOMIC_ACQUIRE);
+    trace_counters_t    totals[TRACE_STAGE_COUNT] = { { 0, 0, 0, 0 } };
+    uint64_t            dropped = 0;
+    long                pid = (long)getpid();
+    bool                first = true;
+
+    if (!(f = fopen(path, "w")))
+    {
+        fprintf(stderr, "Failed to open trace file %s\n", path);
+    }
+
+    if (f)
+    {
+        fprintf(f, "{\"traceEvents\":[");
+    }
+
+    for (trace_thread_t *t = threads; t; t = t->next)
+    {
+        size_t          nSpans = __atomic_load_n(&t->nSpans, __ATOMIC_ACQUIRE);
+        trace_chunk_t   *chunk = t->head;
+
+        for (size_t s = 0; f && s < nSpans; s++)
+        {
+            const trace_span_t *span = &chunk->spans[s % TRACE_CHUNK_N_SPANS];
+
+            /* timestamps are microseconds */
+            fprintf(f, "%s\n{\"name\":\"%s\",\"cat\":\"image\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                    "\"pid\":%ld,\"tid\":%" PRIu64 ",\"args\":{\"bytes\":%" PRIu64 ",\"pixels\":%" PRIu64 "}}",
+                    first ? "" : ",", traceStageName(span->stage), span->begin / 1e3, span->duration / 1e3, pid,
+                    t->tid, span->bytes, span->pixels);
+            first = false;
+
+            if (s % TRACE_CHUNK_N_SPANS == TRACE_CHUNK_N_SPANS - 1)
+            {
+                chunk = chunk->next;
+            }
+        }
+
+        for (size_t st = 0; st < TRACE_STAGE_COUNT; st++)
+        {
+            totals[st].calls += __atomic_load_n(&t->counters[st].calls, __ATOMIC_RELAXED);
+            totals[st].bytes += __atomic_load_n(&t->counters[st].bytes, __ATOMIC_RELAXED);
+            totals[st].pixels += __atomic_load_n(&t->counters[st].pixels, __ATOMIC_RELAXED);
+            totals[st].nanos += __atomic_load_n(&t->counters[st].nanos, __ATOMIC_RELAXED);
+        }
+        dropped += __atomic_load_n(&t->dropped, __ATOMIC_RELAXED);
+    }
+
+    if (f)
+    {
+        fprintf(f, "\n],\n\"displayTimeUnit\":\"ns\",\n\"droppedSpans\":%" PRIu64 ",\n\"stages\":{", dropped);
+        for (size_t st = 0; st < TRACE_STAGE_COUNT; st++)
+        {
+            fprintf(f, "%s\n\"%s\":{\"calls\":%" PRIu64 ",\"bytes\":%" PRIu64 ",\"pixels\":%" PRIu64
+                    ",\"ns\":%" PRIu64 "}", st ? "," : "", traceStageName(st), totals[st].calls,
+                    totals[st].bytes, totals[st].pixels, totals[st].nanos);
+        }
+        fprintf(f, "\n}}\n");
+
+        if (fclose(f))
+        {
+            fprintf(stderr, "Failed to write trace file %s\n", path);
+        }
+    }
+}
+
+/**
+ * Reads TRACE_ENV and starts the trace clock, runs once
+ */
+static void traceInit(void)
+{
+    const char *path = getenv(TRACE_ENV);
+
+    if (!path || !*path)
+    {
+        return;
+    }
+
+    if (pthread_key_create(&traceKey, NULL) || atexit(traceFlush))
+    {
+        fprintf(stderr, "Failed to start tracing, %s is ignored\n", TRACE_ENV);
+        return;
+    }
+
+    traceStart = traceNow();
+    __atomic_store_n(&tracePath, path, __ATOMIC_RELEASE);
+}
+
+/**
+ * Finds the buffer of the calling thread, the first call creates and publishes it
+ * @return Buffer or NULL on allocation error
+ */
+static trace_thread_t *traceThread(void)
+{
+    trace_thread_t *t = pthread_getspecific(traceKey);
+
+    if (t)
+    {
+        return t;
+    }
+
+    if (!(t = calloc(1, sizeof(trace_thread_t))))
+    {
+        return NULL;
+    }
+    t->tid = __atomic_fetch_add(&traceNextTid, 1, __ATOMIC_RELAXED);
+    pthread_setspecific(traceKey, t);
+
+    t->next = __atomic_load_n(&traceThreads, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&traceThreads, &t->next, t, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    {
+        ;
+    }
+    return t;
+}
+
+uint64_t traceBegin(void)
+{
+    pthread_once(&traceOnce, traceInit);
+
+    /* 0 marks disabled spans, the clock starts well above it */
+    return __atomic_load_n(&tracePath, __ATOMIC_ACQUIRE) ? traceNow() : 0;
+}
+
+void traceEnd(trace_stage_t stage, uint64_t begin, uint64_t bytes, uint64_t pixels)
+{
+    uint64_t            end = 0;
+    trace_thread_t      *t = NULL;
+    trace_counters_t    *counters = NULL;
+    size_t              nSpans = 0;
+
+    if (!begin || stage >= TRACE_STAGE_COUNT || !__atomic_load_n(&tracePath, __ATOMIC_ACQUIRE))
+    {
+        return;
+    }
+    end = traceNow();
+    if (!(t = traceThread()))
+    {
+        return;
+    }
+
+    counters = &t->counters[stage];
+    traceAdd(&counters->calls, 1);
+    traceAdd(&counters->bytes, bytes);
+    traceAdd(&counters->pixels, pixels);
+    traceAdd(&counters->nanos, end - begin);
+
+    nSpans = t->nSpans;
+    if (nSpans >= TRACE_MAX_SPANS)
+    {
+        traceAdd(&t->dropped, 1);
+        return;
+    }
+
+    /* a full tail gets a successor before the span is written */
+    if (nSpans % TRACE_CHUNK_N_SPANS == 0)
+    {
+        trace_chunk_t *chunk = malloc(sizeof(trace_chunk_t));
+
+        if (!chunk)
+        {
+            traceAdd(&t->dropped, 1);
+            return;
+        }
+        chunk->next = NULL;
+        if (t->tail)
+        {
+            t->tail->next = chunk;
+        }
+        else
+        {
+            t->head = chunk;
+        }
+        t->tail = chunk;
+    }
+
+    t->tail->spans[nSpans % TRACE_CHUNK_N_SPANS] = (trace_span_t){ begin - traceStart, end - begin, bytes, pixels,
+                                                                   stage };
+    __atomic_store_n(&t->nSpans, nSpans + 1, __ATOMIC_RELEASE);
+}
+
+#endif